@@ -0,0 +1,175 @@
+#include "deferred.h"
+
+#include <sys/process.h>
+#include <sys/ppu_thread.h>
+#include <sys/sys_time.h>
+#include <sys/timer.h>
+#include "lv2_stdio.h"
+
+#define DEFERRED_PHASE_PRIORITY 3000  // below the game's own threads
+#define DEFERRED_PHASE_STACK_SIZE (16 * 1024)
+#define DEFERRED_PHASE_POLL_US (10 * 1000)
+#define DEFERRED_PHASE_WAIT_US (10 * 1000 * 1000)  // the game hasn't loaded a prx by then, go ahead anyway
+
+typedef struct
+{
+    uint32_t name_hash;  // module_name_hash(), 0 = empty slot
+    bool applied;
+    PatchPlan plan;      // only records for this module
+} DeferredModule;
+
+static DeferredModule s_modules[DEFERRED_SLOTS];
+static size_t s_pending = 0;
+static PatchPlan s_phase_plan;
+static bool s_phase_started = false;
+static bool s_phase_on_hook = false;  // no thread, the first load_module call applies it
+static system_time_t s_phase_setup_time = 0;  // what handing the phase off cost the boot path
+// set by the first sys_prx_load_module call, which the game makes from its own code once start() runs
+static volatile bool s_game_running = false;
+
+bool deferred_hook_install(void);
+
+static DeferredModule* find_slot(uint32_t name_hash, bool insert)
+{
+    for (uint32_t i = 0; i < DEFERRED_SLOTS; i++)
+    {
+        DeferredModule* slot = &s_modules[(name_hash + i) & (DEFERRED_SLOTS - 1)];
+        if (slot->name_hash == name_hash)
+        {
+            return slot;
+        }
+        if (!slot->name_hash)
+        {
+            if (!insert || s_pending >= DEFERRED_MAX_MODULES)
+            {
+                return NULL;
+            }
+            slot->name_hash = name_hash;
+            s_pending++;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+// The writes take as long here as they would have on the boot path, less the hand-off is what deferring saved
+static void apply_phase_plan(bool off_boot_path)
+{
+    const system_time_t start = sys_time_get_system_time();
+    const size_t count = patch_plan_phase_count(&s_phase_plan, PATCH_PHASE_DEFERRED);
+    patch_plan_apply(&s_phase_plan, PATCH_PHASE_DEFERRED, NULL);
+    const system_time_t elapsed = sys_time_get_system_time() - start;
+    if (off_boot_path)
+    {
+        printf("deferred phase saved %lld us on the boot path: %ld writes took %lld us here, handing them off cost %lld us there\n",
+               elapsed - s_phase_setup_time, count, elapsed, s_phase_setup_time);
+    }
+    else
+    {
+        printf("deferred phase applied %ld writes in %lld us on the boot path\n", count, elapsed);
+    }
+    patch_plan_free(&s_phase_plan);
+}
+
+void deferred_patches_on_load(const char* path, int32_t prx_id)
+{
+    s_game_running = true;
+    // games load modules from more than one thread
+    patch_plan_lock();
+    if (s_phase_on_hook)
+    {
+        s_phase_on_hook = false;
+        apply_phase_plan(true);
+    }
+
+    // one probe for modules nobody patches
+    DeferredModule* pending = find_slot(module_name_hash(path), false);
+    if (!pending || pending->applied)
+    {
+        patch_plan_unlock();
+        return;
+    }
+
+    ModuleSegments segments;
+    if (!module_segments_query(sys_process_getpid(), prx_id, &segments) || segments.name_hash != pending->name_hash)
+    {
+        printf("couldn't get segments of %s (0x%08x)\n", path, prx_id);
+        patch_plan_unlock();
+        return;
+    }
+
+    printf("applying %ld deferred writes to %s\n", pending->plan.record_count, path);
+    patch_plan_apply_module(&pending->plan, &segments);
+    pending->applied = true;
+    patch_plan_unlock();
+}
+
+bool deferred_patches_install(const PatchPlan* missing)
+{
+    for (size_t i = 0; i < missing->record_count; i++)
+    {
+        const PatchPlanRecord* rec = &missing->records[i];
+        DeferredModule* slot = find_slot(rec->module, true);
+        if (!slot || !patch_plan_add_record(&slot->plan, missing, rec))
+        {
+            printf("can't defer patch at +0x%x for module 0x%08x\n", rec->addr, rec->module);
+        }
+    }
+
+    if (s_pending)
+    {
+        deferred_hook_install();
+        printf("waiting for %ld modules to load\n", s_pending);
+    }
+    return s_pending != 0;
+}
+
+static void deferred_phase_thread(uint64_t arg)
+{
+    (void)arg;
+    // module_start of this prx is still on the boot path, the writes wait until the game runs
+    const system_time_t start = sys_time_get_system_time();
+    while (!s_game_running && sys_time_get_system_time() - start < DEFERRED_PHASE_WAIT_US)
+    {
+        sys_timer_usleep(DEFERRED_PHASE_POLL_US);
+    }
+    printf("deferred phase waited %lld us for the game\n", sys_time_get_system_time() - start);
+    // taken by deferred_phase_start until the setup time is in
+    patch_plan_lock();
+    apply_phase_plan(true);
+    patch_plan_unlock();
+    sys_ppu_thread_exit(0);
+}
+
+void deferred_phase_start(PatchPlan* plan)
+{
+    const system_time_t start = sys_time_get_system_time();
+    patch_plan_lock();
+    s_phase_plan = *plan;
+    bzero(plan, sizeof(*plan));
+    s_phase_started = true;
+    const bool hooked = deferred_hook_install();
+
+    sys_ppu_thread_t tid = SYS_PPU_THREAD_ID_INVALID;
+    if (sys_ppu_thread_create(&tid, deferred_phase_thread, 0, DEFERRED_PHASE_PRIORITY, DEFERRED_PHASE_STACK_SIZE, 0, "game_patch_deferred") != 0)
+    {
+        if (hooked)
+        {
+            printf("couldn't start the deferred phase thread, waiting for the first module load\n");
+            s_phase_on_hook = true;
+        }
+        else
+        {
+            printf("couldn't start the deferred phase thread, applying now\n");
+            apply_phase_plan(false);
+            s_phase_started = false;
+        }
+    }
+    s_phase_setup_time = sys_time_get_system_time() - start;
+    patch_plan_unlock();
+}
+
+bool deferred_patches_pending(void)
+{
+    return s_pending != 0 || s_phase_started;
+}
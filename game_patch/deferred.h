@@ -0,0 +1,31 @@
+#pragma once
+
+#if !defined(DEFERRED_H)
+#define DEFERRED_H
+
+#include <stdbool.h>
+#include "patch_plan.h"
+
+#define DEFERRED_MAX_MODULES 32
+#define DEFERRED_SLOTS (DEFERRED_MAX_MODULES * 2)  // power of two, kept half empty
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Takes the records patch_plan_apply() couldn't place and hooks module loading so they get applied
+// once their prx is loaded. Returns true if anything is pending, the plugin has to stay resident then.
+bool deferred_patches_install(const PatchPlan* missing);
+// Takes ownership of `plan` and applies its PATCH_PHASE_DEFERRED records on a low priority thread,
+// once the game makes its first sys_prx_load_module call or a timeout passes. Once they are written
+// it prints how much boot path time that saved.
+void deferred_phase_start(PatchPlan* plan);
+// The hook or the deferred phase thread still need this module's code
+bool deferred_patches_pending(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
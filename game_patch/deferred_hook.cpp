@@ -0,0 +1,45 @@
+#include <sys/prx.h>
+#include <sys/process.h>
+#include "Memory/HookRegistry.hpp"
+#include "Memory/ElfSegments.h"
+
+// Kept apart from deferred.c, Detour.hpp pulls in <string> which doesn't mix with lv2_stdio.h
+
+extern "C" void deferred_patches_on_load(const char* path, int32_t prx_id);
+
+// sys_prx_load_module in sysPrxForUser
+#define FNID_SYS_PRX_LOAD_MODULE 0x26090058
+#define GAME_EXECUTABLE_BASE 0x10000
+
+// other callbacks on sys_prx_load_module in this module share its detour
+static HookRegistry::Handle s_load_module_hook = nullptr;
+
+// Runs before the module's start entry, so its patches are in place before any of its code does.
+static sys_prx_id_t load_module_hook(const char* path, sys_prx_flags_t flags, sys_prx_load_module_option_t* pOpt)
+{
+    const sys_prx_id_t id = HookRegistry::CallNext<sys_prx_id_t>(s_load_module_hook, path, flags, pOpt);
+    if (id >= 0 && path)
+    {
+        deferred_patches_on_load(path, id);
+    }
+    return id;
+}
+
+extern "C" bool deferred_hook_install(void)
+{
+    if (!s_load_module_hook)
+    {
+        // FindExportByName walks the stub table where vsh.self keeps it, the game's own import of the
+        // function leads to the liblv2 export whatever the EBOOT looks like
+        const opd_s* opd = (const opd_s*)ElfImportOpd(sys_process_getpid(), GAME_EXECUTABLE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE);
+        if (opd)
+        {
+            s_load_module_hook = HookRegistry::Add(opd->func, (uintptr_t)load_module_hook, 0, opd->toc);
+        }
+        else
+        {
+            printf("the game doesn't import sys_prx_load_module\n");
+        }
+    }
+    return s_load_module_hook != nullptr;
+}
@@ -0,0 +1,119 @@
+#include "fingerprint.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "lv2_stdio.h"
+
+#define FNV64_BASIS 0xcbf29ce484222325ULL
+#define FNV64_PRIME 0x00000100000001b3ULL
+
+#define PT_LOAD 1
+#define PF_X 1
+
+#define FINGERPRINT_HEAD_SIZE (4 * 4096)     // first pages of each code segment are hashed whole
+#define FINGERPRINT_SAMPLE_STRIDE (64 * 1024)  // afterwards one sample per stride
+#define FINGERPRINT_SAMPLE_SIZE 64
+#define FINGERPRINT_MAX_PHDRS 16
+
+typedef struct
+{
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} ExeElf64Header;
+
+typedef struct
+{
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} ExeElf64Phdr;
+
+// hashes 8 bytes per step, `size` is rounded down to that
+static uint64_t fnv1a64_words(const void* data, size_t size, uint64_t hash)
+{
+    const uint64_t* p = (const uint64_t*)data;
+    for (size_t i = 0; i < size / sizeof(uint64_t); i++)
+    {
+        hash = (hash ^ p[i]) * FNV64_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t hash_segment(const uint8_t* image, uintptr_t image_vaddr, const ExeElf64Phdr* ph, uint64_t hash)
+{
+    const uint8_t* start = image + ((uintptr_t)ph->p_vaddr - image_vaddr);
+    const uint64_t size = ph->p_filesz;
+    const uint64_t head = size < FINGERPRINT_HEAD_SIZE ? size : FINGERPRINT_HEAD_SIZE;
+
+    hash = fnv1a64_words(start, head, hash);
+    for (uint64_t off = head; off + FINGERPRINT_SAMPLE_SIZE <= size; off += FINGERPRINT_SAMPLE_STRIDE)
+    {
+        hash = fnv1a64_words(start + off, FINGERPRINT_SAMPLE_SIZE, hash);
+    }
+    // tail catches builds that only differ in length
+    if (size > head + FINGERPRINT_SAMPLE_SIZE)
+    {
+        hash = fnv1a64_words(start + ((size - FINGERPRINT_SAMPLE_SIZE) & ~7ULL), FINGERPRINT_SAMPLE_SIZE, hash);
+    }
+    return hash;
+}
+
+uint64_t exe_image_fingerprint(const void* image, uintptr_t image_vaddr)
+{
+    const ExeElf64Header* eh = (const ExeElf64Header*)image;
+    if (eh->e_ident[0] != 0x7f || eh->e_ident[1] != 'E' || eh->e_ident[2] != 'L' || eh->e_ident[3] != 'F')
+    {
+        printf("no elf header at 0x%08x\n", (uint32_t)image_vaddr);
+        return 0;
+    }
+    if (eh->e_phentsize != sizeof(ExeElf64Phdr) || eh->e_phnum == 0 || eh->e_phnum > FINGERPRINT_MAX_PHDRS)
+    {
+        printf("unexpected program headers (%d x %d)\n", eh->e_phnum, eh->e_phentsize);
+        return 0;
+    }
+
+    const ExeElf64Phdr* ph = (const ExeElf64Phdr*)((const uint8_t*)image + (uintptr_t)eh->e_phoff);
+    uint64_t hash = FNV64_BASIS;
+    hash = fnv1a64_words(eh, sizeof(*eh), hash);
+    hash = fnv1a64_words(ph, sizeof(*ph) * eh->e_phnum, hash);
+
+    for (uint16_t i = 0; i < eh->e_phnum; i++)
+    {
+        if (ph[i].p_type == PT_LOAD && (ph[i].p_flags & PF_X) && ph[i].p_filesz)
+        {
+            hash = hash_segment((const uint8_t*)image, image_vaddr, &ph[i], hash);
+        }
+    }
+
+    // 0 is reserved for "unknown"
+    return hash ? hash : 1;
+}
+
+uint64_t get_exe_fingerprint(void)
+{
+    static bool computed = false;
+    static uint64_t fingerprint = 0;
+    if (!computed)
+    {
+        fingerprint = exe_image_fingerprint((const void*)EXE_ELF_BASE, EXE_ELF_BASE);
+        computed = true;
+    }
+    return fingerprint;
+}
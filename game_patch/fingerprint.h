@@ -0,0 +1,19 @@
+#pragma once
+
+#if !defined(FINGERPRINT_H)
+#define FINGERPRINT_H
+
+#include <stdint.h>
+
+// ELF header of the main executable stays mapped at the start of its first segment
+#define EXE_ELF_BASE 0x10000
+
+// Sampled FNV-1a over the ELF/program headers and the executable segments of the running game.
+// Computed once and cached, so call it before any patch is written.
+// Returns 0 if the image doesn't look like an ELF.
+uint64_t get_exe_fingerprint(void);
+
+// Same hash over an image that is mapped at `image` but linked at `image_vaddr`.
+uint64_t exe_image_fingerprint(const void* image, uintptr_t image_vaddr);
+
+#endif
@@ -0,0 +1,218 @@
+#include "hot_reload.h"
+
+#include <sys/ppu_thread.h>
+#include <sys/timer.h>
+#include "lv2_stdio.h"
+#include "lib/file.h"
+#include "patch.h"
+#include "fingerprint.h"
+#include "patch_overlap.h"
+
+#include "../shared/macros.h"
+
+#define HOT_RELOAD_PRIORITY 3000
+#define HOT_RELOAD_STACK_SIZE (16 * 1024)
+
+typedef struct
+{
+    GamePatchInfo game_info;
+    char patch_path[MAX_PATH + 1];
+    char settings_path[MAX_PATH + 1];
+    uint32_t interval_ms;
+    uint64_t settings_size;
+    int64_t settings_mtime;
+    uint64_t patch_size;
+    int64_t patch_mtime;
+    PatchPlan candidates;  // every patch that can be turned on, rebuilt when the yml changes
+    bool have_candidates;
+    PatchJournal journal;  // what it holds bytes for is what is applied
+    bool enabled;
+    bool running;
+} HotReload;
+
+static HotReload s_reload;
+
+// Written and journaled. A deferred or prx patch isn't until its bytes are, one that lost every
+// byte to another patch never is and gets resolved again on each reload.
+static bool is_applied(uint32_t hash)
+{
+    return journal_contains(&s_reload.journal, hash);
+}
+
+static bool is_requested(const PatchState* states, size_t count, uint32_t hash)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (states[i].hash == hash)
+        {
+            return states[i].enabled != 0;
+        }
+    }
+    return false;
+}
+
+static bool file_changed(const char* path, uint64_t* size, int64_t* mtime)
+{
+    uint64_t new_size = 0;
+    int64_t new_mtime = 0;
+    if (fileStat(path, &new_size, &new_mtime) != FILE_STATUS_OK || (new_size == *size && new_mtime == *mtime))
+    {
+        return false;
+    }
+    *size = new_size;
+    *mtime = new_mtime;
+    return true;
+}
+
+static void reload(void)
+{
+    if (file_changed(s_reload.patch_path, &s_reload.patch_size, &s_reload.patch_mtime) || !s_reload.have_candidates)
+    {
+        patch_plan_free(&s_reload.candidates);
+        s_reload.have_candidates = build_patch_plan(&s_reload.game_info, s_reload.patch_path, get_exe_fingerprint(), true, &s_reload.candidates) == 0;
+        if (!s_reload.have_candidates)
+        {
+            printf("hot reload: couldn't parse %s\n", s_reload.patch_path);
+            return;
+        }
+    }
+
+    size_t state_count = 0;
+    PatchState* states = read_patch_states(s_reload.settings_path, &state_count);
+    if (!states && s_reload.settings_size != sizeof(PatchStateFileHeader))
+    {
+        // caught it while vsh was writing it, an empty read isn't "everything off". Look again next poll
+        s_reload.settings_size = 0;
+        s_reload.settings_mtime = 0;
+        return;
+    }
+
+    patch_plan_lock();
+
+    // turned off: anything applied that isn't requested anymore
+    uint32_t applied[HOT_RELOAD_MAX_PATCHES];
+    const size_t applied_count = journal_patches(&s_reload.journal, applied, HOT_RELOAD_MAX_PATCHES);
+    uint32_t off[HOT_RELOAD_MAX_PATCHES];
+    size_t off_count = 0;
+    for (size_t i = 0; i < applied_count; i++)
+    {
+        if (!is_requested(states, state_count, applied[i]))
+        {
+            printf("hot reload: reverting 0x%08x\n", applied[i]);
+            off[off_count++] = applied[i];
+        }
+    }
+    journal_revert_set(&s_reload.journal, off, off_count);
+
+    // turned on: records are grouped by patch, so each hash starts a new run
+    uint32_t on[HOT_RELOAD_MAX_PATCHES];
+    size_t on_count = 0;
+    uint32_t last = 0;
+    for (size_t i = 0; i < s_reload.candidates.record_count && on_count < HOT_RELOAD_MAX_PATCHES; i++)
+    {
+        const uint32_t hash = s_reload.candidates.records[i].hash;
+        if (hash == last)
+        {
+            continue;
+        }
+        last = hash;
+        if (!is_applied(hash) && is_requested(states, state_count, hash))
+        {
+            on[on_count++] = hash;
+        }
+    }
+
+    if (on_count)
+    {
+        // resolved together with what is already in place, so a new patch only writes the bytes it wins
+        PatchPlan live;
+        patch_plan_init(&live);
+        for (size_t i = 0; i < s_reload.candidates.record_count; i++)
+        {
+            const PatchPlanRecord* rec = &s_reload.candidates.records[i];
+            if (is_applied(rec->hash) || is_requested(states, state_count, rec->hash))
+            {
+                patch_plan_add_record(&live, &s_reload.candidates, rec);
+            }
+        }
+        patch_plan_resolve_overlaps(&live);
+        for (size_t i = 0; i < on_count; i++)
+        {
+            printf("hot reload: applying 0x%08x\n", on[i]);
+            patch_plan_apply_patch(&live, on[i]);
+        }
+        patch_plan_free(&live);
+    }
+
+    journal_report(&s_reload.journal);
+    patch_plan_unlock();
+    free(states);
+}
+
+static void hot_reload_thread(uint64_t arg)
+{
+    (void)arg;
+    while (true)
+    {
+        sys_timer_usleep((uint64_t)s_reload.interval_ms * 1000);
+        if (file_changed(s_reload.settings_path, &s_reload.settings_size, &s_reload.settings_mtime))
+        {
+            reload();
+        }
+    }
+}
+
+bool hot_reload_init(void)
+{
+    FileHandle h = 0;
+    if (fileOpen(&h, GAME_PATCH_HOT_RELOAD_PATH, FILE_MODE_READ) != FILE_STATUS_OK)
+    {
+        return false;
+    }
+
+    char buf[16] = {0};
+    uint64_t readcount = 0;
+    fileRead(h, buf, _countof_1(buf), &readcount);
+    fileClose(h);
+
+    const uint32_t interval = strtoul(buf, NULL, 10);
+    s_reload.interval_ms = interval ? interval : HOT_RELOAD_DEFAULT_INTERVAL_MS;
+    if (s_reload.interval_ms < HOT_RELOAD_MIN_INTERVAL_MS)
+    {
+        s_reload.interval_ms = HOT_RELOAD_MIN_INTERVAL_MS;
+    }
+    s_reload.enabled = true;
+    journal_init(&s_reload.journal);
+    patch_plan_set_journal(&s_reload.journal);
+    printf("hot reload every %d ms\n", s_reload.interval_ms);
+    return true;
+}
+
+bool hot_reload_start(const GamePatchInfo* game_info, const char* patch_path, const char* settings_path)
+{
+    if (!s_reload.enabled)
+    {
+        return false;
+    }
+
+    s_reload.game_info = *game_info;
+    strncpy(s_reload.patch_path, patch_path, _countof_1(s_reload.patch_path));
+    strncpy(s_reload.settings_path, settings_path, _countof_1(s_reload.settings_path));
+    fileStat(patch_path, &s_reload.patch_size, &s_reload.patch_mtime);
+    fileStat(settings_path, &s_reload.settings_size, &s_reload.settings_mtime);
+    // the boot plan went through the journal, it already knows what is applied
+    journal_report(&s_reload.journal);
+
+    sys_ppu_thread_t tid = SYS_PPU_THREAD_ID_INVALID;
+    s_reload.running = sys_ppu_thread_create(&tid, hot_reload_thread, 0, HOT_RELOAD_PRIORITY, HOT_RELOAD_STACK_SIZE, 0, "game_patch_hot_reload") == 0;
+    if (!s_reload.running)
+    {
+        printf("couldn't start the hot reload thread\n");
+    }
+    return s_reload.running;
+}
+
+bool hot_reload_running(void)
+{
+    return s_reload.running;
+}
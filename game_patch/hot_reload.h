@@ -0,0 +1,28 @@
+#pragma once
+
+#if !defined(HOT_RELOAD_H)
+#define HOT_RELOAD_H
+
+#include <stdbool.h>
+#include "patch_plan.h"
+
+#define HOT_RELOAD_DEFAULT_INTERVAL_MS 1000
+#define HOT_RELOAD_MIN_INTERVAL_MS 100
+#define HOT_RELOAD_MAX_PATCHES 256
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Reads GAME_PATCH_HOT_RELOAD_PATH. When it exists, original bytes are saved from here on so patches can be turned off again.
+bool hot_reload_init(void);
+// Starts polling the settings file for toggles. The patches the journal holds bytes for are the applied ones.
+bool hot_reload_start(const GamePatchInfo* game_info, const char* patch_path, const char* settings_path);
+bool hot_reload_running(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,509 @@
+#include "journal.h"
+
+#include <sys/process.h>
+#include "Memory/Memory.h"
+#include "lv2_stdio.h"
+
+// no realloc in lv2 libc
+static void* grow_buffer(void* old, const size_t old_size, const size_t new_size)
+{
+    void* p = malloc(new_size);
+    if (!p)
+    {
+        return NULL;
+    }
+    if (old)
+    {
+        memcpy(p, old, old_size);
+        free(old);
+    }
+    return p;
+}
+
+static void reset_index(PatchJournal* journal)
+{
+    for (size_t i = 0; i < JOURNAL_INDEX_SLOTS; i++)
+    {
+        journal->index[i].head = JOURNAL_NONE;
+    }
+}
+
+void journal_init(PatchJournal* journal)
+{
+    bzero(journal, sizeof(*journal));
+    reset_index(journal);
+}
+
+void journal_free(PatchJournal* journal)
+{
+    free(journal->entries);
+    free(journal->data);
+    journal_init(journal);
+}
+
+static JournalSlot* find_slot(PatchJournal* journal, uint32_t hash, bool insert)
+{
+    for (uint32_t i = 0; i < JOURNAL_INDEX_SLOTS; i++)
+    {
+        JournalSlot* slot = &journal->index[(hash + i) & (JOURNAL_INDEX_SLOTS - 1)];
+        if (slot->hash == hash)
+        {
+            return slot;
+        }
+        if (!slot->hash)
+        {
+            if (!insert)
+            {
+                return NULL;
+            }
+            slot->hash = hash;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+bool journal_reserve(PatchJournal* journal, uint32_t hash, uint32_t addr, uint32_t size)
+{
+    JournalSlot* slot = find_slot(journal, hash, true);
+    if (!slot || !size)
+    {
+        return false;
+    }
+
+    if (journal->data_size + size > journal->data_capacity)
+    {
+        size_t new_capacity = journal->data_capacity ? journal->data_capacity : 256;
+        while (journal->data_size + size > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+        uint8_t* data = (uint8_t*)grow_buffer(journal->data, journal->data_size, new_capacity);
+        if (!data)
+        {
+            return false;
+        }
+        journal->data = data;
+        journal->data_capacity = new_capacity;
+    }
+
+    // continues the newest range of this patch, which is also the end of the buffer
+    if (slot->head != JOURNAL_NONE && slot->head == journal->entry_count - 1)
+    {
+        JournalEntry* last = &journal->entries[slot->head];
+        if (last->addr + last->size == addr)
+        {
+            last->size += size;
+            journal->data_size += size;
+            return true;
+        }
+    }
+
+    if (journal->entry_count >= journal->entry_capacity)
+    {
+        const size_t new_capacity = journal->entry_capacity ? journal->entry_capacity * 2 : 32;
+        JournalEntry* entries = (JournalEntry*)grow_buffer(journal->entries,
+                                                           sizeof(JournalEntry) * journal->entry_count,
+                                                           sizeof(JournalEntry) * new_capacity);
+        if (!entries)
+        {
+            return false;
+        }
+        journal->entries = entries;
+        journal->entry_capacity = new_capacity;
+    }
+
+    JournalEntry* entry = &journal->entries[journal->entry_count];
+    entry->hash = hash;
+    entry->addr = addr;
+    entry->size = size;
+    entry->offset = journal->data_size;
+    entry->prev = slot->head;
+    slot->head = journal->entry_count;
+    journal->entry_count++;
+    journal->data_size += size;
+    return true;
+}
+
+void journal_commit(PatchJournal* journal)
+{
+    const sys_pid_t pid = sys_process_getpid();
+    for (size_t i = journal->read_entry; i < journal->entry_count; i++)
+    {
+        const JournalEntry* entry = &journal->entries[i];
+        const uint32_t start = entry->offset > journal->read_offset ? entry->offset : journal->read_offset;
+        const uint32_t end = entry->offset + entry->size;
+        if (start < end)
+        {
+            ReadProcessMemory(pid, (void*)(entry->addr + (start - entry->offset)), journal->data + start, end - start);
+        }
+    }
+    journal->read_offset = journal->data_size;
+    // the last range can still be extended
+    journal->read_entry = journal->entry_count ? journal->entry_count - 1 : 0;
+}
+
+bool journal_contains(const PatchJournal* journal, uint32_t hash)
+{
+    const JournalSlot* slot = find_slot((PatchJournal*)journal, hash, false);
+    return slot && slot->head != JOURNAL_NONE;
+}
+
+size_t journal_patches(const PatchJournal* journal, uint32_t* hashes, size_t max)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < JOURNAL_INDEX_SLOTS && count < max; i++)
+    {
+        if (journal->index[i].hash && journal->index[i].head != JOURNAL_NONE)
+        {
+            hashes[count++] = journal->index[i].hash;
+        }
+    }
+    return count;
+}
+
+// Drops reverted entries once they are most of the buffer
+static void compact(PatchJournal* journal)
+{
+    if (journal->dead_size * 2 < journal->data_size)
+    {
+        return;
+    }
+
+    uint32_t* remap = (uint32_t*)malloc(sizeof(uint32_t) * (journal->entry_count ? journal->entry_count : 1));
+    if (!remap)
+    {
+        return;
+    }
+
+    size_t kept = 0;
+    size_t data_size = 0;
+    for (size_t i = 0; i < journal->entry_count; i++)
+    {
+        JournalEntry entry = journal->entries[i];
+        if (!entry.hash)
+        {
+            remap[i] = JOURNAL_NONE;
+            continue;
+        }
+        // offsets only ever grow, copying forward doesn't overwrite anything still needed
+        for (uint32_t b = 0; data_size != entry.offset && b < entry.size; b++)
+        {
+            journal->data[data_size + b] = journal->data[entry.offset + b];
+        }
+        entry.offset = data_size;
+        entry.prev = entry.prev != JOURNAL_NONE ? remap[entry.prev] : JOURNAL_NONE;
+        data_size += entry.size;
+        remap[i] = kept;
+        journal->entries[kept++] = entry;
+    }
+    for (size_t i = 0; i < JOURNAL_INDEX_SLOTS; i++)
+    {
+        JournalSlot* slot = &journal->index[i];
+        slot->head = slot->head != JOURNAL_NONE ? remap[slot->head] : JOURNAL_NONE;
+    }
+    free(remap);
+
+    journal->entry_count = kept;
+    journal->data_size = journal->read_offset = data_size;
+    journal->read_entry = kept ? kept - 1 : 0;
+    journal->dead_size = 0;
+}
+
+static bool overlaps(const JournalEntry* entry, uint32_t addr, uint32_t size)
+{
+    return entry->hash && entry->addr < addr + size && addr < entry->addr + entry->size;
+}
+
+// Live entries in address order, cut into clusters of ranges that chain together. Only entries in
+// the same cluster can overlap, so a revert never looks at the rest of the journal.
+typedef struct
+{
+    uint32_t* order;    // entry indices by address, NULL without the memory for it
+    uint32_t* where;    // per entry, its position in order
+    uint32_t* cluster;  // per position, where its cluster starts in order
+    uint32_t* later;    // sort buffer, then the later entries over the one being reverted
+    uint32_t* span_start;
+    uint32_t* span_end;
+    size_t count;
+} RevertIndex;
+
+// Stable merge sort by address, there's no qsort in lv2 libc
+static void sort_by_addr(const PatchJournal* journal, uint32_t* idx, uint32_t* tmp, size_t n)
+{
+    for (size_t width = 1; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += width * 2)
+        {
+            const size_t mid = lo + width < n ? lo + width : n;
+            const size_t hi = lo + width * 2 < n ? lo + width * 2 : n;
+            size_t a = lo, b = mid, out = lo;
+            while (a < mid && b < hi)
+            {
+                tmp[out++] = journal->entries[idx[b]].addr < journal->entries[idx[a]].addr ? idx[b++] : idx[a++];
+            }
+            while (a < mid)
+            {
+                tmp[out++] = idx[a++];
+            }
+            while (b < hi)
+            {
+                tmp[out++] = idx[b++];
+            }
+        }
+        memcpy(idx, tmp, sizeof(*idx) * n);
+    }
+}
+
+static void index_build(const PatchJournal* journal, RevertIndex* index)
+{
+    const size_t n = journal->entry_count + 1;
+    bzero(index, sizeof(*index));
+    index->order = (uint32_t*)malloc(sizeof(uint32_t) * n * 6);
+    if (!index->order)
+    {
+        return;
+    }
+    index->where = index->order + n;
+    index->cluster = index->where + n;
+    index->later = index->cluster + n;
+    index->span_start = index->later + n;
+    index->span_end = index->span_start + n;
+
+    for (size_t i = 0; i < journal->entry_count; i++)
+    {
+        index->where[i] = JOURNAL_NONE;
+        if (journal->entries[i].hash)
+        {
+            index->order[index->count++] = i;
+        }
+    }
+    sort_by_addr(journal, index->order, index->later, index->count);
+
+    uint64_t cluster_end = 0;  // 64 bit, a range may end at 4 GB
+    for (size_t p = 0; p < index->count; p++)
+    {
+        const JournalEntry* entry = &journal->entries[index->order[p]];
+        const uint64_t end = (uint64_t)entry->addr + entry->size;
+        const bool chained = p && entry->addr < cluster_end;
+        index->where[index->order[p]] = p;
+        index->cluster[p] = chained ? index->cluster[p - 1] : p;
+        cluster_end = chained && cluster_end > end ? cluster_end : end;
+    }
+}
+
+static void index_free(RevertIndex* index)
+{
+    free(index->order);
+    bzero(index, sizeof(*index));
+}
+
+// Live entries after `index` that overlap it, oldest first
+static size_t later_overlaps(const PatchJournal* journal, const RevertIndex* revert, size_t index)
+{
+    const JournalEntry* entry = &journal->entries[index];
+    const uint32_t first = revert->cluster[revert->where[index]];
+    size_t count = 0;
+    for (size_t p = first; p < revert->count && revert->cluster[p] == first; p++)
+    {
+        const uint32_t i = revert->order[p];
+        if (i > index && overlaps(&journal->entries[i], entry->addr, entry->size))
+        {
+            // insertion by entry index, clusters are small
+            size_t at = count++;
+            for (; at > 0 && revert->later[at - 1] > i; at--)
+            {
+                revert->later[at] = revert->later[at - 1];
+            }
+            revert->later[at] = i;
+        }
+    }
+    return count;
+}
+
+// Oldest live entry after `index` that covers `addr`, JOURNAL_NONE if the game still shows what `index` wrote there
+static uint32_t covering_entry(const PatchJournal* journal, size_t index, uint32_t addr)
+{
+    for (size_t i = index + 1; i < journal->entry_count; i++)
+    {
+        if (overlaps(&journal->entries[i], addr, 1))
+        {
+            return i;
+        }
+    }
+    return JOURNAL_NONE;
+}
+
+// Without the index: every byte looks through every later entry
+static void revert_entry_slow(PatchJournal* journal, size_t index, sys_pid_t pid)
+{
+    const JournalEntry* entry = &journal->entries[index];
+    const uint8_t* saved = journal->data + entry->offset;
+    uint32_t run = 0;  // first byte not written back yet
+    for (uint32_t b = 0; b < entry->size; b++)
+    {
+        const uint32_t later = covering_entry(journal, index, entry->addr + b);
+        if (later == JOURNAL_NONE)
+        {
+            continue;
+        }
+        if (run < b)
+        {
+            WriteProcessMemory(pid, (void*)(entry->addr + run), saved + run, b - run);
+        }
+        run = b + 1;
+        const JournalEntry* owner = &journal->entries[later];
+        journal->data[owner->offset + (entry->addr + b - owner->addr)] = saved[b];
+    }
+    if (run < entry->size)
+    {
+        WriteProcessMemory(pid, (void*)(entry->addr + run), saved + run, entry->size - run);
+    }
+}
+
+// A later patch that is still applied wrote over some of these bytes. Those stay as they are, and the later
+// entry takes over the bytes saved here, so reverting it afterwards still ends at what was there originally.
+// The oldest later entry over a byte takes it. Only the entries of this one's cluster are looked at and each
+// byte is copied once, back to the game or into the entry that inherits it.
+static void revert_entry(PatchJournal* journal, const RevertIndex* revert, size_t index, sys_pid_t pid)
+{
+    if (!revert->order || revert->where[index] == JOURNAL_NONE)
+    {
+        revert_entry_slow(journal, index, pid);
+        return;
+    }
+
+    const JournalEntry* entry = &journal->entries[index];
+    const uint8_t* saved = journal->data + entry->offset;
+    const size_t later_count = later_overlaps(journal, revert, index);
+
+    // bytes no later entry took yet, sorted [start, end) offsets into the entry. A claim splits
+    // at most one span in two, so there are never more than later_count + 1
+    uint32_t* span_start = revert->span_start;
+    uint32_t* span_end = revert->span_end;
+    size_t spans = 1;
+    span_start[0] = 0;
+    span_end[0] = entry->size;
+    for (size_t l = 0; l < later_count && spans; l++)
+    {
+        const JournalEntry* owner = &journal->entries[revert->later[l]];
+        const uint32_t lo = owner->addr > entry->addr ? owner->addr - entry->addr : 0;
+        const uint64_t owner_end = (uint64_t)owner->addr + owner->size - entry->addr;
+        const uint32_t hi = owner_end < entry->size ? (uint32_t)owner_end : entry->size;
+        for (size_t sp = 0; sp < spans; sp++)
+        {
+            const uint32_t start = span_start[sp] > lo ? span_start[sp] : lo;
+            const uint32_t end = span_end[sp] < hi ? span_end[sp] : hi;
+            if (start >= end)
+            {
+                continue;
+            }
+            memcpy(journal->data + owner->offset + (entry->addr + start - owner->addr), saved + start, end - start);
+
+            if (span_start[sp] < start && end < span_end[sp])
+            {
+                // the tail becomes a span of its own right after this one
+                for (size_t m = spans; m > sp + 1; m--)
+                {
+                    span_start[m] = span_start[m - 1];
+                    span_end[m] = span_end[m - 1];
+                }
+                span_start[sp + 1] = end;
+                span_end[sp + 1] = span_end[sp];
+                span_end[sp] = start;
+                spans++;
+                sp++;
+            }
+            else if (span_start[sp] < start)
+            {
+                span_end[sp] = start;
+            }
+            else if (end < span_end[sp])
+            {
+                span_start[sp] = end;
+            }
+            else
+            {
+                for (size_t m = sp + 1; m < spans; m++)
+                {
+                    span_start[m - 1] = span_start[m];
+                    span_end[m - 1] = span_end[m];
+                }
+                spans--;
+                sp--;
+            }
+        }
+    }
+
+    for (size_t sp = 0; sp < spans; sp++)
+    {
+        WriteProcessMemory(pid, (void*)(entry->addr + span_start[sp]), saved + span_start[sp], span_end[sp] - span_start[sp]);
+    }
+}
+
+static void revert_one(PatchJournal* journal, const RevertIndex* revert, uint32_t hash)
+{
+    JournalSlot* slot = find_slot(journal, hash, false);
+    if (!slot)
+    {
+        return;
+    }
+
+    const sys_pid_t pid = sys_process_getpid();
+    for (uint32_t i = slot->head; i != JOURNAL_NONE;)
+    {
+        JournalEntry* entry = &journal->entries[i];
+        revert_entry(journal, revert, i, pid);
+        journal->dead_size += entry->size;
+        entry->hash = 0;
+        i = entry->prev;
+    }
+    slot->head = JOURNAL_NONE;
+}
+
+void journal_revert(PatchJournal* journal, uint32_t hash)
+{
+    journal_revert_set(journal, &hash, 1);
+}
+
+void journal_revert_set(PatchJournal* journal, const uint32_t* hashes, size_t count)
+{
+    if (!count)
+    {
+        return;
+    }
+    // built once for the whole set, reverted entries only drop out of their clusters
+    RevertIndex index;
+    index_build(journal, &index);
+    for (size_t i = 0; i < count; i++)
+    {
+        revert_one(journal, &index, hashes[i]);
+    }
+    index_free(&index);
+    compact(journal);
+}
+
+void journal_revert_all(PatchJournal* journal)
+{
+    const sys_pid_t pid = sys_process_getpid();
+    for (size_t i = journal->entry_count; i-- > 0;)
+    {
+        const JournalEntry* entry = &journal->entries[i];
+        if (entry->hash)
+        {
+            WriteProcessMemory(pid, (void*)entry->addr, journal->data + entry->offset, entry->size);
+        }
+    }
+    journal->entry_count = 0;
+    journal->data_size = journal->dead_size = 0;
+    journal->read_entry = journal->read_offset = 0;
+    reset_index(journal);
+}
+
+void journal_report(const PatchJournal* journal)
+{
+    const size_t used = sizeof(JournalEntry) * journal->entry_count + journal->data_size;
+    const size_t reserved = sizeof(JournalEntry) * journal->entry_capacity + journal->data_capacity + sizeof(journal->index);
+    printf("journal: %ld ranges, %ld bytes saved (%ld reverted), %ld bytes used, %ld bytes reserved\n",
+           journal->entry_count, journal->data_size - journal->dead_size, journal->dead_size, used, reserved);
+}
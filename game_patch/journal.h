@@ -0,0 +1,64 @@
+#pragma once
+
+#if !defined(JOURNAL_H)
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JOURNAL_MAX_PATCHES 256
+#define JOURNAL_INDEX_SLOTS (JOURNAL_MAX_PATCHES * 2)  // power of two, kept half empty
+#define JOURNAL_NONE 0xffffffff
+
+// Bytes one patch replaced at [addr, addr + size), kept at `offset` in PatchJournal.data
+typedef struct
+{
+    uint32_t hash;
+    uint32_t addr;
+    uint32_t size;
+    uint32_t offset;
+    uint32_t prev;  // older entry of the same patch, JOURNAL_NONE at the end
+} JournalEntry;
+
+typedef struct
+{
+    uint32_t hash;  // 0 = empty slot, stays set after a revert so the slot can be reused
+    uint32_t head;  // newest entry, JOURNAL_NONE if nothing is saved
+} JournalSlot;
+
+typedef struct
+{
+    JournalEntry* entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    uint8_t* data;
+    size_t data_size;
+    size_t data_capacity;
+    size_t dead_size;  // bytes of reverted entries still in `data`
+    size_t read_entry;  // first entry that may still have unread bytes
+    size_t read_offset;  // data before this has been read
+    JournalSlot index[JOURNAL_INDEX_SLOTS];
+} PatchJournal;
+
+void journal_init(PatchJournal* journal);
+void journal_free(PatchJournal* journal);
+
+// Reserves room for the bytes at [addr, addr + size). Ranges of the same patch that continue
+// the last one are merged. Nothing is read until journal_commit().
+bool journal_reserve(PatchJournal* journal, uint32_t hash, uint32_t addr, uint32_t size);
+// Reads everything reserved since the last commit, one ReadProcessMemory per merged range.
+void journal_commit(PatchJournal* journal);
+
+bool journal_contains(const PatchJournal* journal, uint32_t hash);
+// Hashes of the patches with saved bytes, up to `max`. Returns how many were written.
+size_t journal_patches(const PatchJournal* journal, uint32_t* hashes, size_t max);
+// Writes back the saved bytes of one patch, newest first. Bytes a later patch that is still applied wrote
+// over are left alone; that patch's entries inherit the saved bytes instead.
+void journal_revert(PatchJournal* journal, uint32_t hash);
+void journal_revert_set(PatchJournal* journal, const uint32_t* hashes, size_t count);
+void journal_revert_all(PatchJournal* journal);
+
+void journal_report(const PatchJournal* journal);
+
+#endif
@@ -41,6 +41,12 @@ static int sys_fs_close(int fd)
     return_to_user_prog(int);
 }
 
+static int sys_fs_stat(const char* path, CellFsStat* sb)
+{
+    system_call_2(808, (uint32_t)path, (uint32_t)sb);
+    return_to_user_prog(int);
+}
+
 static int sys_fs_unlink(const char* path)
 {
     system_call_1(814, (uint64_t)path);
@@ -61,6 +67,8 @@ static int fileModeToCellFs(FileMode mode)
             return CELL_FS_O_RDWR;
         case FILE_MODE_CREATE:
             return CELL_FS_O_CREAT;
+        case FILE_MODE_CREATE_TRUNCATE:
+            return CELL_FS_O_WRONLY | CELL_FS_O_CREAT | CELL_FS_O_TRUNC;
         default:
             assert(false && "invalid file mode");
     }
@@ -262,3 +270,17 @@ void fileDelete(const char* path)
 {
     sys_fs_unlink(path);
 }
+
+FileStatus fileStat(const char* path, uint64_t* size, int64_t* mtime)
+{
+    CellFsStat sb;
+    memset(&sb, 0, sizeof(sb));
+    int err = sys_fs_stat(path, &sb);
+    FileStatus status = cellFsErrorToFileStatus(err);
+    if (status == FILE_STATUS_OK)
+    {
+        *size = sb.st_size;
+        *mtime = sb.st_mtime;
+    }
+    return status;
+}
@@ -24,6 +24,7 @@ typedef enum
     FILE_MODE_WRITE,
     FILE_MODE_READ_WRITE,
     FILE_MODE_CREATE,
+    FILE_MODE_CREATE_TRUNCATE,
 } FileMode;
 
 /**
@@ -122,4 +123,14 @@ FileStatus fileReadLine(FileHandle handle, char* buffer, uint32_t bufferSize, ui
 
 void fileDelete(const char* path);
 
+/**
+ * @brief Returns the size and modification time of a file without opening it.
+ *
+ * @param path The file path.
+ * @param size The returned file size.
+ * @param mtime The returned modification time.
+ * @return FileStatus indicating whether the operation succeeded.
+ */
+FileStatus fileStat(const char* path, uint64_t* size, int64_t* mtime);
+
 #endif
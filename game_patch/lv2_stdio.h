@@ -5,6 +5,13 @@
 #include <stdbool.h>
 #include <limits.h> // ULONG_MAX
 
+#if !defined(__PRX__)
+// host builds (tests) use the C library directly
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#else
 #if defined(__cplusplus)
 extern "C"
 {
@@ -312,3 +319,4 @@ static long strtol(const char* nptr, char** endptr, int base)
 #define memcpy _sys_memcpy
 #define puts(s) printf(s "\n")
 #define perror puts
+#endif
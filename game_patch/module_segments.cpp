@@ -0,0 +1,66 @@
+#include "Utils/SystemCalls.hpp"
+
+extern "C"
+{
+#include "lv2_stdio.h"
+#include "module_table.h"
+}
+
+#define MAX_MODULE_SEGMENTS 4
+
+bool module_segments_query(uint32_t pid, int32_t prx_id, ModuleSegments* module)
+{
+    char filename[256];
+    sys_prx_segment_info_t segments[MAX_MODULE_SEGMENTS];
+    sys_prx_module_info_t info;
+    bzero(filename, sizeof(filename));
+    bzero(segments, sizeof(segments));
+    bzero(&info, sizeof(info));
+    info.size = sizeof(info);
+    info.filename = (sys_addr_t)filename;
+    info.filename_size = sizeof(filename);
+    info.segments = (sys_addr_t)segments;
+    info.segments_num = MAX_MODULE_SEGMENTS;
+    if (ps3mapi_get_process_module_segments(pid, prx_id, &info) != 0 || info.segments_num == 0)
+    {
+        return false;
+    }
+
+    bzero(module, sizeof(*module));
+    module->name_hash = module_name_hash(filename);
+    module->prx_id = prx_id;
+    module->text_base = segments[0].base;
+    module->text_size = segments[0].memsz;
+    if (info.segments_num > 1)
+    {
+        module->data_base = segments[1].base;
+        module->data_size = segments[1].memsz;
+    }
+    printf("module %s text 0x%08x (0x%x) data 0x%08x (0x%x)\n", filename, module->text_base, module->text_size, module->data_base, module->data_size);
+    return true;
+}
+
+bool module_table_build(ModuleTable* table, uint32_t pid)
+{
+    module_table_clear(table);
+    table->built = true;
+
+    sys_prx_id_t ids[MODULE_TABLE_MAX_MODULES];
+    bzero(ids, sizeof(ids));
+    const int ret = ps3mapi_get_all_process_modules_prx_id(pid, ids);
+    if (ret != 0)
+    {
+        printf("ps3mapi_get_all_process_modules_prx_id failed 0x%08x\n", ret);
+        return false;
+    }
+
+    for (size_t i = 0; i < MODULE_TABLE_MAX_MODULES; i++)
+    {
+        ModuleSegments module;
+        if (ids[i] != 0 && module_segments_query(pid, ids[i], &module))
+        {
+            module_table_add(table, &module);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+#include "module_table.h"
+#include "../shared/stringid.h"
+
+#if defined(__PRX__)
+#include "lv2_stdio.h"
+#else
+#include <stdio.h>
+#include <string.h>
+#endif
+
+uint32_t module_name_hash(const char* path)
+{
+    if (!path || !path[0])
+    {
+        return 0;
+    }
+
+    const char* name = path;
+    for (const char* p = path; *p; p++)
+    {
+        if (*p == '/')
+        {
+            name = p + 1;
+        }
+    }
+
+    uint32_t hash = 0x811c9dc5;
+    for (; *name; name++)
+    {
+        const char c = (*name >= 'A' && *name <= 'Z') ? (*name - 'A' + 'a') : *name;
+        hash = 0x01000193 * (hash ^ c);
+    }
+    // 0 marks an empty slot
+    return hash ? hash : 1;
+}
+
+void module_table_clear(ModuleTable* table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+bool module_table_add(ModuleTable* table, const ModuleSegments* module)
+{
+    if (!module->name_hash || table->count >= MODULE_TABLE_MAX_MODULES)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < MODULE_TABLE_SLOTS; i++)
+    {
+        ModuleSegments* slot = &table->slots[(module->name_hash + i) & (MODULE_TABLE_SLOTS - 1)];
+        if (slot->name_hash == module->name_hash)
+        {
+            // same file loaded twice, first one wins
+            return false;
+        }
+        if (!slot->name_hash)
+        {
+            *slot = *module;
+            table->count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+const ModuleSegments* module_table_find(const ModuleTable* table, uint32_t name_hash)
+{
+    if (!name_hash)
+    {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < MODULE_TABLE_SLOTS; i++)
+    {
+        const ModuleSegments* slot = &table->slots[(name_hash + i) & (MODULE_TABLE_SLOTS - 1)];
+        if (slot->name_hash == name_hash)
+        {
+            return slot;
+        }
+        if (!slot->name_hash)
+        {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static bool range_inside(uint32_t addr, uint32_t size, uint32_t base, uint32_t base_size)
+{
+    return addr >= base && (uint64_t)addr - base + size <= base_size;
+}
+
+bool module_table_resolve(const ModuleSegments* module, uint32_t offset, uint32_t size, uint32_t* addr)
+{
+    // the loader keeps the segments at their ELF vaddr distance, alignment padding included
+    const uint64_t target = (uint64_t)module->text_base + offset;
+    if (target + size <= 0x100000000ull)
+    {
+        const uint32_t resolved = (uint32_t)target;
+        if (range_inside(resolved, size, module->text_base, module->text_size) ||
+            (module->data_size && range_inside(resolved, size, module->data_base, module->data_size)))
+        {
+            *addr = resolved;
+            return true;
+        }
+    }
+
+    printf("offset 0x%x (+0x%x) is outside of module segments (text 0x%08x+0x%x, data 0x%08x+0x%x)\n", offset, size, module->text_base, module->text_size, module->data_base, module->data_size);
+    return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#if !defined(MODULE_TABLE_H)
+#define MODULE_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MODULE_TABLE_MAX_MODULES 128                         // prx ids returned by ps3mapi
+#define MODULE_TABLE_SLOTS (MODULE_TABLE_MAX_MODULES * 2)  // power of two, kept half empty
+
+typedef struct
+{
+    uint32_t name_hash;  // module_name_hash() of the file name, 0 = empty slot
+    int32_t prx_id;
+    uint32_t text_base;
+    uint32_t text_size;
+    uint32_t data_base;
+    uint32_t data_size;
+} ModuleSegments;
+
+typedef struct
+{
+    ModuleSegments slots[MODULE_TABLE_SLOTS];
+    size_t count;
+    bool built : 1;
+} ModuleTable;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Case insensitive hash of the file name part of `path`, so "/dev_hdd0/game/X/USRDIR/libfoo.sprx" and "libfoo.SPRX" match.
+uint32_t module_name_hash(const char* path);
+
+void module_table_clear(ModuleTable* table);
+bool module_table_add(ModuleTable* table, const ModuleSegments* module);
+const ModuleSegments* module_table_find(const ModuleTable* table, uint32_t name_hash);
+
+// `offset` is relative to the text base, as in the prx's own vaddr layout; the range must land in the text or data segment.
+bool module_table_resolve(const ModuleSegments* module, uint32_t offset, uint32_t size, uint32_t* addr);
+
+bool module_segments_query(uint32_t pid, int32_t prx_id, ModuleSegments* module);
+// Fills the table from the modules currently loaded in `pid`.
+bool module_table_build(ModuleTable* table, uint32_t pid);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
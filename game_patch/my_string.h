@@ -49,7 +49,7 @@ static char* trim(char* str)
 static char* str_dup(const char* str)
 {
 #if !defined(__PRX__)
-    return strdup(str);
+    return str ? strdup(str) : NULL;
 #else
     if (!str)
     {
@@ -16,12 +16,20 @@
 
 #if defined(__PRX__)
 #include <sys/process.h>
+#include <sys/sys_time.h>
 #include "Memory/Memory.h"
 #include "../shared/memory.h"
 #include "plugins.h"
 #include "lv2_stdio.h"
 #include "lib/file.h"
+#include "fingerprint.h"
+#include "deferred.h"
+#include "hot_reload.h"
+#include "patch_overlap.h"
 #endif
+#include "patch_plan.h"
+#include "module_table.h"
+#include "patch_signature.h"
 
 #include "../shared/macros.h"
 
@@ -130,6 +138,174 @@ static size_t parse_patch_entry(const char* str, PatchEntry* entry)
     return entry->param_count;
 }
 
+static bool isHex(const char* s)
+{
+    return s && (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'));
+}
+
+static int isHexBase(const char* s)
+{
+    return isHex(s) ? 16 : 10;
+}
+
+static int64_t string_to_int(const char* str)
+{
+    return strtoll(str, NULL, isHexBase(str));
+}
+
+static uint64_t string_to_uint(const char* str)
+{
+    return strtoull(str, NULL, isHexBase(str));
+}
+
+static bool is_number(const char* str)
+{
+    if (!str || !str[0])
+    {
+        return false;
+    }
+    const bool hex = isHex(str);
+    const char* p = hex ? str + 2 : str;
+    if (!*p)
+    {
+        return false;
+    }
+    for (; *p; p++)
+    {
+        if (hex ? parse_hex_digit(*p) < 0 : !isdigit(*p))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+PatchEntryType get_patch_entry_type(const PatchEntry* entry)
+{
+    if (!entry || entry->param_count == 0 || !entry->params[0])
+    {
+        return PATCH_ENTRY_UNKNOWN;
+    }
+
+    static const struct
+    {
+        const char* name;
+        PatchEntryType type;
+    } types[] = {
+        {"bytes8", PATCH_ENTRY_BYTES8},
+        {"byte", PATCH_ENTRY_BYTES8},
+        {"bytes16", PATCH_ENTRY_BYTES16},
+        {"be16", PATCH_ENTRY_BYTES16},
+        {"bytes32", PATCH_ENTRY_BYTES32},
+        {"be32", PATCH_ENTRY_BYTES32},
+        {"bytes64", PATCH_ENTRY_BYTES64},
+        {"be64", PATCH_ENTRY_BYTES64},
+        {"append_arg", PATCH_ENTRY_APPEND_ARG},
+        {"bytes", PATCH_ENTRY_BLOB},
+        {"fill", PATCH_ENTRY_FILL},
+        {"copy", PATCH_ENTRY_COPY},
+        {"file", PATCH_ENTRY_FILE},
+    };
+    for (size_t i = 0; i < _countof(types); i++)
+    {
+        if (strcmp(entry->params[0], types[i].name) == 0)
+        {
+            return types[i].type;
+        }
+    }
+    return PATCH_ENTRY_UNKNOWN;
+}
+
+// "DEADBEEF", "0xDEADBEEF" or "DE AD BE EF". `out` may be NULL to only count.
+// Returns the number of bytes, 0 if malformed or `out_size` is too small.
+size_t parse_hex_bytes(const char* str, uint8_t* out, size_t out_size)
+{
+    if (!str)
+    {
+        return 0;
+    }
+    if (isHex(str))
+    {
+        str += 2;
+    }
+
+    size_t count = 0;
+    while (*str)
+    {
+        if (isspace(*str))
+        {
+            str++;
+            continue;
+        }
+        const int hi = parse_hex_digit(str[0]);
+        const int lo = str[1] ? parse_hex_digit(str[1]) : -1;
+        if (hi < 0 || lo < 0)
+        {
+            return 0;
+        }
+        if (out)
+        {
+            if (count >= out_size)
+            {
+                return 0;
+            }
+            out[count] = (uint8_t)((hi << 4) | lo);
+        }
+        count++;
+        str += 2;
+    }
+    return count;
+}
+
+// relative to GAME_PATCH_DATA_PATH and not allowed to leave it
+static bool is_data_path(const char* path)
+{
+    return path && path[0] && path[0] != '/' && !strstr(path, "..");
+}
+
+// plan records hold 32 bit addresses and sizes, a range that ends past 4 GB would wrap around
+static bool range_fits(uint64_t addr, uint64_t size)
+{
+    return size > 0 && addr <= UINT32_MAX && size <= UINT32_MAX - addr + 1;
+}
+
+// bytes written by a fill, 0 if `count` repeats can't fit
+static uint64_t fill_size(size_t pattern_size, uint64_t count)
+{
+    return count <= UINT32_MAX ? pattern_size * count : 0;
+}
+
+bool validate_patch_entry(const PatchEntry* entry)
+{
+    const PatchEntryType type = get_patch_entry_type(entry);
+    switch (type)
+    {
+        case PATCH_ENTRY_BYTES8:
+        case PATCH_ENTRY_BYTES16:
+        case PATCH_ENTRY_BYTES32:
+        case PATCH_ENTRY_BYTES64:
+            return entry->param_count >= 3 && is_number(entry->params[1]) && is_number(entry->params[2]);
+        case PATCH_ENTRY_APPEND_ARG:
+            return entry->param_count >= 2;
+        case PATCH_ENTRY_BLOB:
+            return entry->param_count >= 3 && is_number(entry->params[1]) && parse_hex_bytes(entry->params[2], NULL, 0) > 0;
+        case PATCH_ENTRY_FILL:
+            return entry->param_count >= 4 && is_number(entry->params[1]) && parse_hex_bytes(entry->params[2], NULL, 0) > 0 &&
+                   is_number(entry->params[3]) &&
+                   range_fits(string_to_uint(entry->params[1]), fill_size(parse_hex_bytes(entry->params[2], NULL, 0), string_to_uint(entry->params[3])));
+        case PATCH_ENTRY_COPY:
+            return entry->param_count >= 4 && is_number(entry->params[1]) && is_number(entry->params[2]) &&
+                   is_number(entry->params[3]) && range_fits(string_to_uint(entry->params[1]), string_to_uint(entry->params[3])) &&
+                   range_fits(string_to_uint(entry->params[2]), string_to_uint(entry->params[3]));
+        case PATCH_ENTRY_FILE:
+            return entry->param_count >= 6 && is_number(entry->params[1]) && is_data_path(entry->params[2]) &&
+                   is_number(entry->params[3]) && is_number(entry->params[4]) && range_fits(string_to_uint(entry->params[1]), string_to_uint(entry->params[4])) &&
+                   is_number(entry->params[5]);
+        default:
+            return false;
+    }
+}
+
 static uint32_t calculate_patch_hash(size_t patch_number,
                                      const char* titleid_cat,
                                      const Patch* patch,
@@ -158,8 +334,13 @@ static uint32_t calculate_patch_hash(size_t patch_number,
     return hash;
 }
 
-static bool patch_matches_game(const GamePatchInfo* game, const char* app_ver)
+static bool patch_matches_game(const ParseContext* ctx, const char* app_ver, uint64_t app_fingerprint)
 {
+    const GamePatchInfo* game = &ctx->game_info;
+    if (app_fingerprint && ctx->exe_fingerprint && app_fingerprint != ctx->exe_fingerprint)
+    {
+        return false;
+    }
     if (app_ver && game->app_ver[0] != '\0')
     {
         return strcmp(game->app_ver, app_ver) == 0;
@@ -188,18 +369,17 @@ static void process_patch_metadata_for_app_ver(PatchMetadata* meta,
     meta->version = str_dup(ctx->current_patch.version);
     meta->app_bin = str_dup(ctx->current_patch.app_bin);
     meta->app_ver = str_dup(app_ver);
+    meta->app_fingerprint = ctx->current_patch.app_fingerprint ? strtoull(ctx->current_patch.app_fingerprint, NULL, 16) : 0;
 
-    meta->matches_game = patch_matches_game(&ctx->game_info, app_ver);
+    meta->matches_game = patch_matches_game(ctx, app_ver, meta->app_fingerprint);
+    meta->deferred = ctx->current_patch.phase && strcmp(ctx->current_patch.phase, "deferred") == 0;
+    meta->signature = str_dup(ctx->current_patch.signature);
+    meta->signature_offset = ctx->current_patch.signature_offset ? (int32_t)strtol(ctx->current_patch.signature_offset, NULL, 0) : 0;
 
     char settings_buf[MAX_PATH + 1] = {0};
     snprintf(settings_buf, _countof_1(settings_buf), GAME_PATCH_SETTINGS "/%s.bin", ctx->game_info.titleid);
-    const bool isExeMatched = (g_args && (strstr(g_args->argv[0].c.lo, meta->app_bin) != 0));
-    const bool readEnabled = read_patch_state(settings_buf, meta->hash) == 1;
-    print_bool(isExeMatched);
-    print_bool(readEnabled);
-    meta->enabled = readEnabled && isExeMatched;
     static const char* prx_list[] = {".prx", ".PRX", ".sprx", ".SPRX"};
-    for (size_t i = 0; i < _countof(prx_list); i++)
+    for (size_t i = 0; meta->app_bin && i < _countof(prx_list); i++)
     {
         meta->is_prx = strstr(meta->app_bin, prx_list[i]) != 0;
         if (meta->is_prx)
@@ -207,6 +387,18 @@ static void process_patch_metadata_for_app_ver(PatchMetadata* meta,
             break;
         }
     }
+    // prx patches are matched against the loaded modules when applied, not argv[0]
+#if defined(__PRX__)
+    const bool isExeMatched = meta->app_bin && (meta->is_prx || (g_args && (strstr(g_args->argv[0].c.lo, meta->app_bin) != 0)));
+#else
+    // no running executable to compare against
+    const bool isExeMatched = meta->app_bin != NULL;
+#endif
+    const bool readEnabled = read_patch_state(settings_buf, meta->hash) == 1;
+    print_bool(isExeMatched);
+    print_bool(readEnabled);
+    meta->exe_matched = isExeMatched;
+    meta->enabled = readEnabled && isExeMatched;
 }
 
 static void reset_current_patch(ParseContext* ctx)
@@ -217,6 +409,10 @@ static void reset_current_patch(ParseContext* ctx)
     free(ctx->current_patch.author);
     free(ctx->current_patch.version);
     free(ctx->current_patch.app_bin);
+    free(ctx->current_patch.app_fingerprint);
+    free(ctx->current_patch.phase);
+    free(ctx->current_patch.signature);
+    free(ctx->current_patch.signature_offset);
 
     for (size_t i = 0; i < ctx->current_patch.app_ver_count; i++)
     {
@@ -382,6 +578,23 @@ static void process_line(ParseContext* ctx, char* line)
     {
         ctx->current_patch.app_bin = parse_quoted_string(trimmed);
     }
+    else if (strstr(trimmed, "app_fingerprint:"))
+    {
+        ctx->current_patch.app_fingerprint = parse_quoted_string(trimmed);
+    }
+    else if (strstr(trimmed, "phase:"))
+    {
+        ctx->current_patch.phase = parse_quoted_string(trimmed);
+    }
+    // before "signature:", which it contains
+    else if (strstr(trimmed, "signature_offset:"))
+    {
+        ctx->current_patch.signature_offset = parse_quoted_string(trimmed);
+    }
+    else if (strstr(trimmed, "signature:"))
+    {
+        ctx->current_patch.signature = parse_quoted_string(trimmed);
+    }
     else if (strstr(trimmed, "app_ver:"))
     {
         if (is_list_value(trimmed))
@@ -415,6 +628,8 @@ static void process_line(ParseContext* ctx, char* line)
         ctx->in_patches_section = true;
         if (ctx->mode == PARSE_MODE_LOW_MEM)
         {
+            // entries of a patch that doesn't match must not run under the previous one's metadata
+            ctx->processing_enabled_patch = false;
             size_t app_ver_count = ctx->current_patch.app_ver_count;
             if (app_ver_count == 0)
             {
@@ -431,7 +646,7 @@ static void process_line(ParseContext* ctx, char* line)
                 if (meta.matches_game && ctx->meta_callback)
                 {
                     ctx->meta_callback(&meta, ctx->user_data);
-                    ctx->processing_enabled_patch = meta.matches_game && meta.enabled;
+                    ctx->processing_enabled_patch = meta.matches_game && (meta.enabled || (ctx->include_disabled && meta.exe_matched));
                 }
 
                 if (av_idx == 0)
@@ -563,6 +778,10 @@ void free_parse_context_data(ParseContext* ctx)
     free(ctx->current_patch.author);
     free(ctx->current_patch.version);
     free(ctx->current_patch.app_bin);
+    free(ctx->current_patch.app_fingerprint);
+    free(ctx->current_patch.phase);
+    free(ctx->current_patch.signature);
+    free(ctx->current_patch.signature_offset);
 
     if (ctx->current_patch.app_ver)
     {
@@ -812,6 +1031,7 @@ void free_patch_metadata(PatchMetadata* meta)
     free(meta->version);
     free(meta->app_bin);
     free(meta->app_ver);
+    free(meta->signature);
 }
 
 void free_patch_entry(PatchEntry* entry)
@@ -1021,6 +1241,11 @@ int write_patch_state(const char* filename, uint32_t hash, bool enabled)
 }
 #endif
 
+PatchState* read_patch_states(const char* filename, size_t* count)
+{
+    return read_patch_states_internal(filename, count);
+}
+
 int read_patch_state(const char* filename, uint32_t hash)
 {
     size_t count = 0;
@@ -1069,11 +1294,17 @@ int toggle_patch_state(const char* filename, uint32_t hash)
 }
 #endif
 
-#if defined(__PRX__)
+typedef struct
+{
+    size_t count;
+    PatchPlan* plan;
+    bool include_disabled;
+    PatchSignatures signatures;
+} RunPatchData;
 
 static void metadata_callback(const PatchMetadata* meta, void* user_data)
 {
-    size_t* count = (size_t*)user_data;
+    size_t* count = &((RunPatchData*)user_data)->count;
     (*count)++;
     printf("Patch %ld (#%ld) (Hash: 0x%08x)\n", *count, meta->patch_number, meta->hash);
     printf("  Title: %s\n", meta->title ? meta->title : "N/A");
@@ -1082,127 +1313,179 @@ static void metadata_callback(const PatchMetadata* meta, void* user_data)
     printf("  Version: %s\n", meta->version ? meta->version : "N/A");
     printf("  App Binary: %s\n", meta->app_bin ? meta->app_bin : "N/A");
     printf("  App Version: %s\n", meta->app_ver ? meta->app_ver : "N/A");
+    printf("  App Fingerprint: %016llx\n", meta->app_fingerprint);
+    printf("  Phase: %s\n", meta->deferred ? "deferred" : "early");
     printf("  Matches: %s, Enabled: %s\n",
            meta->matches_game ? "Yes" : "No",
            meta->enabled ? "Yes" : "No");
-}
-
-static bool isHex(const char* s)
-{
-    return s && (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'));
-}
-
-static int isHexBase(const char* s)
-{
-    return isHex(s) ? 16 : 10;
-}
-
-static void write_patch(void* addr, const void* val, const size_t valsz)
-{
-    static sys_pid_t current_pid = 0;
-    if (!current_pid)
-    {
-        current_pid = sys_process_getpid();
-    }
-    if (current_pid)
+    if (meta->signature)
     {
-        hex_dump((void*)addr, valsz, (uintptr_t)addr);
-        WriteProcessMemory(current_pid, addr, val, valsz);
-        hex_dump((void*)addr, valsz, (uintptr_t)addr);
+        printf("  Signature: %s (offset %d)\n", meta->signature, meta->signature_offset);
     }
 }
 
-static int64_t string_to_int(const char* str)
+
+#if 0 // how should this be ~~copied~~ added?
+static double string_to_double(const char* str)
 {
-    return strtoll(str, NULL, isHexBase(str));
+    return strtod(str, NULL);
 }
+#endif
 
-static uint64_t string_to_uint(const char* str)
+// addresses of prx patches are offsets into that module, resolved when the plan is applied
+static uint32_t patch_module(const PatchMetadata* meta)
 {
-    return strtoull(str, NULL, isHexBase(str));
+    return meta->is_prx ? module_name_hash(meta->app_bin) : 0;
 }
 
-#if 0 // how should this be ~~copied~~ added?
-static double string_to_double(const char* str)
+static void plan_write(PatchPlan* plan, const PatchMetadata* meta, uintptr_t addr, const void* val, size_t valsz)
 {
-    return strtod(str, NULL);
+    if (!patch_plan_add(plan, meta->hash, patch_module(meta), PATCH_PLAN_WRITE, addr, val, valsz))
+    {
+        printf("failed to add write at 0x%08x to patch plan\n", addr);
+    }
 }
-#endif
 
-static void apply_patch(const PatchEntry* entry)
+static void apply_patch(PatchPlan* plan, const PatchMetadata* meta, const PatchEntry* entry)
 {
     const size_t params = entry->param_count;
+    plan->phase = meta->deferred ? PATCH_PHASE_DEFERRED : PATCH_PHASE_EARLY;
 
     if (params >= MIN_PATCH_PARAMS)
     {
-        const char* type = entry->params[0];
+        const PatchEntryType type = get_patch_entry_type(entry);
         const char* address = entry->params[1];
         const char* value = entry->params[2];
-        uintptr_t base = 0;  // TODO: Support prx
+        const uint32_t module = patch_module(meta);
 
-        if (isZero(strncmp2(type, "bytes8")) || isZero(strncmp2(type, "byte")))
-        {
-            const uintptr_t addr = string_to_uint(address);
-            const int8_t val = string_to_int(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
-        }
-        else if (isZero(strncmp2(type, "bytes16")) || isZero(strncmp2(type, "be16")))
-        {
-            const uintptr_t addr = string_to_uint(address);
-            const int16_t val = string_to_int(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
-        }
-        else if (isZero(strncmp2(type, "bytes32")) || isZero(strncmp2(type, "be32")))
-        {
-            const uintptr_t addr = string_to_uint(address);
-            const int32_t val = string_to_int(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
-        }
-        else if (isZero(strncmp2(type, "bytes64")) || isZero(strncmp2(type, "be64")))
+        if (type != PATCH_ENTRY_APPEND_ARG && !validate_patch_entry(entry))
         {
-            const uintptr_t addr = string_to_uint(address);
-            const int64_t val = string_to_int(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
+            printf("invalid patch entry \"%s\"\n", entry->params[0]);
+            return;
         }
-        else if (g_args && strcmp(type, "append_arg") == 0)
+
+        switch (type)
         {
-            // starting from `"type"`. up to 7 args per entry
-            for (size_t i = 1; i < params; i++)
+            case PATCH_ENTRY_BYTES8:
+            {
+                const uintptr_t addr = string_to_uint(address);
+                const int8_t val = string_to_int(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
+            case PATCH_ENTRY_BYTES16:
+            {
+                const uintptr_t addr = string_to_uint(address);
+                const int16_t val = string_to_int(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
+            case PATCH_ENTRY_BYTES32:
             {
-                if (entry->params[i] && entry->params[i][0])
+                const uintptr_t addr = string_to_uint(address);
+                const int32_t val = string_to_int(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
+            case PATCH_ENTRY_BYTES64:
+            {
+                const uintptr_t addr = string_to_uint(address);
+                const int64_t val = string_to_int(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
+            case PATCH_ENTRY_BLOB:
+            {
+                // a param can't be longer than a line
+                uint8_t blob[MAX_LINE_LENGTH / 2];
+                const uintptr_t addr = string_to_uint(address);
+                const size_t size = parse_hex_bytes(value, blob, sizeof(blob));
+                plan_write(plan, meta, addr, blob, size);
+                break;
+            }
+            case PATCH_ENTRY_FILL:
+            {
+                uint8_t pattern[MAX_LINE_LENGTH / 2];
+                const uintptr_t addr = string_to_uint(address);
+                const size_t pattern_size = parse_hex_bytes(value, pattern, sizeof(pattern));
+                // validated, can't overflow. prx fills are bounded by their segment when resolved
+                const size_t size = fill_size(pattern_size, string_to_uint(entry->params[3]));
+                if (!patch_plan_add_fill(plan, meta->hash, module, addr, pattern, pattern_size, size))
                 {
-                    if (append_arg(g_args, entry->params[i]))
-                    {
-                        printf("appended \"%s\" okay!\n", entry->params[i]);
-                    }
-                    else
+                    printf("failed to add fill at 0x%08x to patch plan\n", addr);
+                }
+                break;
+            }
+            case PATCH_ENTRY_COPY:
+            {
+                const uintptr_t dst = string_to_uint(address);
+                const uintptr_t src = string_to_uint(value);
+                const size_t size = string_to_uint(entry->params[3]);
+                if (!patch_plan_add_copy(plan, meta->hash, module, dst, src, size))
+                {
+                    printf("failed to add copy at 0x%08x to patch plan\n", dst);
+                }
+                break;
+            }
+            case PATCH_ENTRY_FILE:
+            {
+                const uintptr_t addr = string_to_uint(address);
+                const uint32_t offset = string_to_uint(entry->params[3]);
+                const size_t size = string_to_uint(entry->params[4]);
+                const uint32_t checksum = string_to_uint(entry->params[5]);
+                if (!patch_plan_add_file(plan, meta->hash, module, addr, value, offset, size, checksum))
+                {
+                    printf("failed to add file %s at 0x%08x to patch plan\n", value, addr);
+                }
+                break;
+            }
+            case PATCH_ENTRY_APPEND_ARG:
+            {
+                // starting from `"type"`. up to 7 args per entry
+                for (size_t i = 1; i < params; i++)
+                {
+                    if (entry->params[i] && entry->params[i][0])
                     {
-                        printf("couldn't append %ld arguement.\n", i);
+                        patch_plan_add(plan, meta->hash, 0, PATCH_PLAN_APPEND_ARG, 0, entry->params[i], strlen(entry->params[i]) + 1);
                     }
                 }
+                break;
             }
-        }
 #if 0
-        else if (strcmp(type, "float32") == 0)
-        {
-            const float val = (float)string_to_double(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
-        }
-        else if (strcmp(type, "float64") == 0)
-        {
-            const double val = string_to_double(value);
-            write_patch((void*)(base + addr), &val, sizeof(val));
-        }
+            case PATCH_ENTRY_FLOAT32:
+            {
+                const float val = (float)string_to_double(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
+            case PATCH_ENTRY_FLOAT64:
+            {
+                const double val = string_to_double(value);
+                plan_write(plan, meta, addr, &val, sizeof(val));
+                break;
+            }
 #endif
+            default:
+            {
+                printf("unknown patch type \"%s\"\n", entry->params[0]);
+                break;
+            }
+        }
     }
 }
 
 static void entry_callback(const PatchMetadata* meta, const PatchEntry* entry, void* user_data)
 {
     here();
-    if (meta->enabled)
+    RunPatchData* data = (RunPatchData*)user_data;
+    if (meta->enabled || data->include_disabled)
     {
-        apply_patch(entry);
+        // the block's records are offsets until build_patch_plan finds the signature
+        if (meta->signature)
+        {
+            patch_signatures_add(&data->signatures, meta->hash, meta->signature, meta->signature_offset, meta->is_prx);
+        }
+        apply_patch(data->plan, meta, entry);
     }
     printf("- [ ");
     for (size_t i = 0; i < entry->param_count; i++)
@@ -1216,37 +1499,142 @@ static void entry_callback(const PatchMetadata* meta, const PatchEntry* entry, v
     printf(" ]\n");
 }
 
-int run_patch(GamePatchInfo* game_info)
+int build_patch_plan(const GamePatchInfo* game_info, const char* path, uint64_t exe_fingerprint, bool include_disabled, PatchPlan* plan)
 {
-    char path[MAX_PATH + 1] = {0};
-    snprintf(path, _countof_1(path), GAME_PATCH_FILES_PATH "/%s.yml", game_info->titleid);
     ParseContext ctx;
     bzero(&ctx, sizeof(ctx));
     create_parse_context(&ctx, game_info, PARSE_MODE_LOW_MEM);
-    size_t count = 0;
+    ctx.exe_fingerprint = exe_fingerprint;
+    ctx.include_disabled = include_disabled;
+    RunPatchData data;
+    bzero(&data, sizeof(data));
+    data.plan = plan;
+    data.include_disabled = include_disabled;
+    patch_signatures_init(&data.signatures);
     ParseContext input;
     bzero(&input, sizeof(input));
 
     input.filename = path;
     input.meta_callback = metadata_callback;
     input.entry_callback = entry_callback;
-    input.user_data = &count;
+    input.user_data = &data;
     const int ret = parse_patch_file_low_mem(&ctx, &input);
+    free_parse_context_data(&ctx);
+
+    plan->patch_count = data.count;
+
+    // signature patches were planned relative to their block, one scan places all of them
+    if (data.signatures.count)
+    {
+        char cache_path[MAX_PATH + 1] = {0};
+        snprintf(cache_path, _countof_1(cache_path), GAME_PATCH_CACHE_PATH "/%s.sig", game_info->titleid);
+        patch_signatures_resolve(&data.signatures, cache_path, exe_fingerprint);
+        if (!patch_signatures_rebase(&data.signatures, plan))
+        {
+            printf("failed to rebase signature patches\n");
+        }
+    }
+    patch_signatures_free(&data.signatures);
+    return ret;
+}
+
+#if defined(__PRX__)
+
+// Only the result area of the record is written, vsh created the file
+static void write_launch_result(const GameLaunchResult* result)
+{
+    FileHandle h = 0;
+    if (fileOpen(&h, GAME_LAUNCH_RECORD_PATH, FILE_MODE_READ_WRITE) != FILE_STATUS_OK)
+    {
+        printf("can't open %s for the launch result\n", GAME_LAUNCH_RECORD_PATH);
+        return;
+    }
+    uint64_t position = 0;
+    uint64_t write_count = 0;
+    if (fileSeek(h, FILE_SEEK_START, GAME_LAUNCH_RESULT_OFFSET, &position) != FILE_STATUS_OK ||
+        fileWrite(h, result, sizeof(*result), &write_count) != FILE_STATUS_OK || write_count != sizeof(*result))
+    {
+        printf("failed to write the launch result\n");
+    }
+    fileClose(h);
+}
+
+int run_patch(GameLaunchRecord* launch)
+{
+    const system_time_t boot_start = sys_time_get_system_time();
+    const GamePatchInfo* game_info = &launch->info;
+    const char* path = launch->patch_path;
+    char settings_path[MAX_PATH + 1] = {0};
+    snprintf(settings_path, _countof_1(settings_path), GAME_PATCH_SETTINGS "/%s.bin", game_info->titleid);
+    char plan_path[MAX_PATH + 1] = {0};
+    snprintf(plan_path, _countof_1(plan_path), GAME_PATCH_CACHE_PATH "/%s.plan", game_info->titleid);
+
+    const uint64_t fingerprint = get_exe_fingerprint();
+    printf("exe fingerprint %016llx\n", fingerprint);
+
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    PatchPlanKey key;
+    const bool have_key = patch_plan_make_key(&key, launch, g_args ? g_args->argv[0].c.lo : NULL, fingerprint);
+
+    size_t count = 0;
+    int ret = -1;
+    if (have_key && patch_plan_load(&plan, plan_path, &key))
+    {
+        printf("using cached patch plan %s (%ld writes)\n", plan_path, plan.record_count);
+        count = plan.patch_count;
+        ret = 0;
+    }
+    else if (launch->flags & GAME_LAUNCH_HAS_PATCH_FILE)
+    {
+        ret = build_patch_plan(game_info, path, fingerprint, false, &plan);
+        count = plan.patch_count;
+        // resolved once here, the cached plan is already overlap free
+        patch_plan_resolve_overlaps(&plan);
+        if (ret == 0 && have_key && patch_plan_save(&plan, plan_path, &key))
+        {
+            printf("saved patch plan %s\n", plan_path);
+        }
+    }
+
+    hot_reload_init();
+
+    // patches for prx that aren't loaded yet wait for sys_prx_load_module
+    PatchPlan missing;
+    patch_plan_init(&missing);
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, &missing);
+    if (missing.record_count)
+    {
+        deferred_patches_install(&missing);
+    }
+    patch_plan_free(&missing);
+    hot_reload_start(game_info, path, settings_path);
+    const size_t deferred_count = patch_plan_phase_count(&plan, PATCH_PHASE_DEFERRED);
+    if (deferred_count)
+    {
+        deferred_phase_start(&plan);
+    }
+    patch_plan_free(&plan);
+
+    GameLaunchResult result;
+    bzero(&result, sizeof(result));
+    result.sequence = launch->sequence;
+    result.patch_count = count;
+    result.deferred_count = deferred_count;
     if (ret == 0 && count > 0)
     {
-        char buf[64 + 1] = {0};
-        snprintf(buf, _countof_1(buf), "Applied %ld patch%s", count, count > 1 ? "es" : "");
-        uint64_t write_count = 0;
-        fileWrite2(GAME_PATCH_NOTIFY_MSG_FILE, buf, strlen(buf), &write_count);
-        printf("%s\n", buf);
+        result.state = GAME_LAUNCH_RESULT_APPLIED;
+        snprintf(result.message, _countof_1(result.message), "Applied %ld patch%s", count, count > 1 ? "es" : "");
+        printf("%s\n", result.message);
     }
-    else if (count == 0)
+    else
     {
-        printf("no patches, deleting notification file!\n");
-        fileDelete(GAME_PATCH_NOTIFY_MSG_FILE);
+        result.state = GAME_LAUNCH_RESULT_NONE;
+        printf("no patches, nothing to notify\n");
     }
+    write_launch_result(&result);
 
-    free_parse_context_data(&ctx);
+    printf("boot path took %lld us, %ld writes deferred\n", sys_time_get_system_time() - boot_start, deferred_count);
     return count > 0 ? 0 : 1;
 }
 
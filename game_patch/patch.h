@@ -38,9 +38,14 @@ typedef struct
     char* version;
     char* app_bin;
     char* app_ver;
+    uint64_t app_fingerprint;  // 0 if the patch doesn't pin an executable
     bool matches_game : 1;
     bool enabled : 1;
     bool is_prx : 1;
+    bool exe_matched : 1;  // app_bin is the running executable or a prx
+    bool deferred : 1;  // phase: deferred, applied after the game started
+    char* signature;  // entry addresses are relative to where this is found, plus signature_offset
+    int32_t signature_offset;
 } PatchMetadata;
 
 typedef struct
@@ -49,6 +54,20 @@ typedef struct
     size_t param_count;
 } PatchEntry;
 
+typedef enum
+{
+    PATCH_ENTRY_UNKNOWN,
+    PATCH_ENTRY_BYTES8,      // "bytes8"/"byte", addr, value
+    PATCH_ENTRY_BYTES16,     // "bytes16"/"be16", addr, value
+    PATCH_ENTRY_BYTES32,     // "bytes32"/"be32", addr, value
+    PATCH_ENTRY_BYTES64,     // "bytes64"/"be64", addr, value
+    PATCH_ENTRY_APPEND_ARG,  // "append_arg", arg...
+    PATCH_ENTRY_BLOB,        // "bytes", addr, "hex string"
+    PATCH_ENTRY_FILL,        // "fill", addr, "hex pattern", count
+    PATCH_ENTRY_COPY,        // "copy", dst, src, size
+    PATCH_ENTRY_FILE,        // "file", addr, "path under GAME_PATCH_DATA_PATH", offset, length, FNV-1a 32 of the bytes
+} PatchEntryType;
+
 typedef struct
 {
     PatchMetadata metadata;
@@ -74,6 +93,10 @@ typedef struct
     char* author;
     char* version;
     char* app_bin;
+    char* app_fingerprint;
+    char* phase;  // "early" (default) or "deferred"
+    char* signature;  // IDA style, "80 1F ?? 4? 9E"
+    char* signature_offset;
     char** app_ver;
     size_t app_ver_count;
     bool is_app_ver_list : 1;
@@ -83,6 +106,7 @@ typedef struct ParseContext
 {
     ParseMode mode;
     GamePatchInfo game_info;
+    uint64_t exe_fingerprint;  // of the running executable, 0 if unknown
     char** global_titleids;
     size_t global_titleid_count;
     size_t current_patch_number;
@@ -110,6 +134,7 @@ typedef struct ParseContext
     void* user_data;
     PatchMetadata current_meta;
     bool processing_enabled_patch;
+    bool include_disabled;  // also pass entries of patches that are turned off, for hot reload
 } ParseContext;
 
 void create_parse_context(ParseContext* ctx, const GamePatchInfo* game_info, ParseMode mode);
@@ -127,11 +152,21 @@ parse_patch_file(ParseContext* ctx, const char* filename);
 PatchData* get_all_patches(ParseContext* ctx, size_t* count);
 PatchMetadata* get_metadata(ParseContext* ctx, size_t* count);
 
+PatchEntryType get_patch_entry_type(const PatchEntry* entry);
+bool validate_patch_entry(const PatchEntry* entry);
+size_t parse_hex_bytes(const char* str, uint8_t* out, size_t out_size);
+
 int read_patch_state(const char* filename, uint32_t hash);
+PatchState* read_patch_states(const char* filename, size_t* count);
 int toggle_patch_state(const char* filename, uint32_t hash);
 
 void free_patch_data(PatchData* patches, size_t count);
 void free_patch_metadata(PatchMetadata* meta);
 void free_patch_entry(PatchEntry* entry);
 
+#include "patch_plan.h"
+
+// Parses the title's yml into `plan`. `include_disabled` adds patches that are turned off as well.
+int build_patch_plan(const GamePatchInfo* game_info, const char* path, uint64_t exe_fingerprint, bool include_disabled, PatchPlan* plan);
+
 #endif
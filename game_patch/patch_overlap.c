@@ -0,0 +1,385 @@
+#include "patch_overlap.h"
+
+#include "lv2_stdio.h"
+
+#define NO_RECORD 0xffffffff
+
+typedef struct
+{
+    uint32_t owner;  // record index, the last writer
+    uint32_t addr;
+    uint32_t size;
+    uint32_t next;  // next piece of the same owner
+} WritePiece;
+
+typedef struct
+{
+    const PatchPlan* plan;
+    const uint32_t* epoch;   // per record, copies that run before it in the same space
+    const uint64_t* points;  // split points of the cluster being resolved
+} ResolveContext;
+
+typedef bool (*IndexLess)(const ResolveContext* ctx, uint32_t a, uint32_t b);
+
+// Stable merge sort, there's no qsort in lv2 libc
+static void sort_indices(uint32_t* idx, uint32_t* tmp, size_t n, const ResolveContext* ctx, IndexLess less)
+{
+    for (size_t width = 1; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += width * 2)
+        {
+            const size_t mid = lo + width < n ? lo + width : n;
+            const size_t hi = lo + width * 2 < n ? lo + width * 2 : n;
+            size_t a = lo, b = mid, out = lo;
+            while (a < mid && b < hi)
+            {
+                tmp[out++] = less(ctx, idx[b], idx[a]) ? idx[b++] : idx[a++];
+            }
+            while (a < mid)
+            {
+                tmp[out++] = idx[a++];
+            }
+            while (b < hi)
+            {
+                tmp[out++] = idx[b++];
+            }
+        }
+        memcpy(idx, tmp, sizeof(*idx) * n);
+    }
+}
+
+// Records that write a range of their own, the ones resolved here
+static bool is_interval(const PatchPlanRecord* rec)
+{
+    return rec->size && (rec->kind == PATCH_PLAN_WRITE || rec->kind == PATCH_PLAN_FILL || rec->kind == PATCH_PLAN_FILE);
+}
+
+// Writes clash when they land in the same module, whatever pass they are in
+static bool same_space(const PatchPlanRecord* a, const PatchPlanRecord* b)
+{
+    return a->module == b->module;
+}
+
+// Every early record runs before every deferred one, file order only counts within a phase
+static bool runs_before(const PatchPlan* plan, uint32_t a, uint32_t b)
+{
+    const PatchPlanRecord* ra = &plan->records[a];
+    const PatchPlanRecord* rb = &plan->records[b];
+    return ra->phase != rb->phase ? ra->phase < rb->phase : a < b;
+}
+
+// 64 bit so a record ending at the top of the address space doesn't end at 0
+static uint64_t record_end(const PatchPlanRecord* rec)
+{
+    return (uint64_t)rec->addr + rec->size;
+}
+
+// A copy reads whatever is in memory when it runs, so nothing before it may be dropped
+// because of something after it. Writes are only resolved against others in the same epoch.
+static bool same_epoch(const ResolveContext* ctx, uint32_t a, uint32_t b)
+{
+    return same_space(&ctx->plan->records[a], &ctx->plan->records[b]) && ctx->epoch[a] == ctx->epoch[b];
+}
+
+static bool record_less(const ResolveContext* ctx, uint32_t a, uint32_t b)
+{
+    const PatchPlanRecord* ra = &ctx->plan->records[a];
+    const PatchPlanRecord* rb = &ctx->plan->records[b];
+    if (ra->module != rb->module)
+    {
+        return ra->module < rb->module;
+    }
+    if (ctx->epoch[a] != ctx->epoch[b])
+    {
+        return ctx->epoch[a] < ctx->epoch[b];
+    }
+    return ra->addr < rb->addr;
+}
+
+static bool point_less(const ResolveContext* ctx, uint32_t a, uint32_t b)
+{
+    return ctx->points[a] < ctx->points[b];
+}
+
+// One cluster of records whose ranges chain together. Splits it at every start and end, gives
+// each span to the record covering it that runs last and merges neighbouring spans of the same owner.
+static size_t resolve_cluster(const ResolveContext* ctx, const uint32_t* recs, size_t count, uint64_t* points, uint32_t* order, uint32_t* tmp, WritePiece* out, size_t* conflicts)
+{
+    const PatchPlan* plan = ctx->plan;
+    size_t point_count = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PatchPlanRecord* rec = &plan->records[recs[i]];
+        order[point_count] = point_count;
+        points[point_count++] = rec->addr;
+        order[point_count] = point_count;
+        points[point_count++] = record_end(rec);
+    }
+    ResolveContext point_ctx = *ctx;
+    point_ctx.points = points;
+    sort_indices(order, tmp, point_count, &point_ctx, point_less);
+
+    size_t pieces = 0;
+    for (size_t p = 0; p + 1 < point_count; p++)
+    {
+        const uint64_t start = points[order[p]];
+        const uint64_t end = points[order[p + 1]];
+        if (start == end)
+        {
+            continue;
+        }
+
+        uint32_t owner = NO_RECORD;
+        for (size_t i = 0; i < count; i++)
+        {
+            const PatchPlanRecord* rec = &plan->records[recs[i]];
+            if (rec->addr <= start && end <= record_end(rec) && (owner == NO_RECORD || runs_before(plan, owner, recs[i])))
+            {
+                owner = recs[i];
+            }
+        }
+        if (owner == NO_RECORD)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const PatchPlanRecord* rec = &plan->records[recs[i]];
+            if (recs[i] != owner && rec->hash != plan->records[owner].hash && rec->addr <= start && end <= record_end(rec))
+            {
+                printf("patch 0x%08x overwrites 0x%08x at 0x%08x (+0x%x) (module 0x%08x)\n",
+                       plan->records[owner].hash, rec->hash, (uint32_t)start, (uint32_t)(end - start), rec->module);
+                (*conflicts)++;
+            }
+        }
+
+        if (pieces && out[pieces - 1].owner == owner && (uint64_t)out[pieces - 1].addr + out[pieces - 1].size == start)
+        {
+            out[pieces - 1].size += (uint32_t)(end - start);
+        }
+        else
+        {
+            out[pieces].owner = owner;
+            out[pieces].addr = (uint32_t)start;
+            out[pieces].size = (uint32_t)(end - start);
+            out[pieces].next = NO_RECORD;
+            pieces++;
+        }
+    }
+    return pieces;
+}
+
+static uint32_t copy_count_before(const PatchPlan* plan, const uint32_t* copies, size_t copy_count, uint32_t index)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < copy_count; i++)
+    {
+        count += same_space(&plan->records[copies[i]], &plan->records[index]) && runs_before(plan, copies[i], index);
+    }
+    return count;
+}
+
+// `piece` of `rec` as a record of its own in `resolved`
+static bool add_piece(PatchPlan* resolved, const PatchPlan* plan, const PatchPlanRecord* rec, const WritePiece* piece)
+{
+    const uint8_t* data = plan->data + rec->data_offset;
+    const uint32_t skip = piece->addr - rec->addr;
+    resolved->phase = (PatchPhase)rec->phase;
+    switch (rec->kind)
+    {
+        case PATCH_PLAN_FILL:
+        {
+            // the pattern is rotated so the piece continues where it was cut
+            uint32_t pattern_size = 0;
+            memcpy(&pattern_size, data, sizeof(pattern_size));
+            const uint8_t* pattern = data + sizeof(pattern_size);
+            if (!pattern_size)
+            {
+                return true;
+            }
+            const uint32_t phase = skip % pattern_size;
+            if (!phase)
+            {
+                return patch_plan_add_fill(resolved, rec->hash, rec->module, piece->addr, pattern, pattern_size, piece->size);
+            }
+            uint8_t* rotated = (uint8_t*)malloc(pattern_size);
+            if (!rotated)
+            {
+                return false;
+            }
+            memcpy(rotated, pattern + phase, pattern_size - phase);
+            memcpy(rotated + pattern_size - phase, pattern, phase);
+            const bool okay = patch_plan_add_fill(resolved, rec->hash, rec->module, piece->addr, rotated, pattern_size, piece->size);
+            free(rotated);
+            return okay;
+        }
+        case PATCH_PLAN_FILE:
+        {
+            // still checked against the whole range the checksum was made for
+            const PatchPlanFile* file = (const PatchPlanFile*)data;
+            if (!patch_plan_add_file(resolved, rec->hash, rec->module, piece->addr, file->path, file->offset, piece->size, file->checksum))
+            {
+                return false;
+            }
+            PatchPlanFile* added = (PatchPlanFile*)(resolved->data + resolved->records[resolved->record_count - 1].data_offset);
+            added->length = file->length;
+            added->skip = file->skip + skip;
+            return true;
+        }
+        default:
+        {
+            return patch_plan_add(resolved, rec->hash, rec->module, PATCH_PLAN_WRITE, piece->addr, data + skip, piece->size);
+        }
+    }
+}
+
+bool patch_plan_resolve_overlaps(PatchPlan* plan)
+{
+    size_t write_count = 0;
+    size_t copy_count = 0;
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        write_count += is_interval(&plan->records[i]);
+        copy_count += plan->records[i].kind == PATCH_PLAN_COPY;
+    }
+    if (write_count < 2)
+    {
+        return true;
+    }
+
+    // every record adds at most two split points and so at most two pieces
+    uint32_t* writes = (uint32_t*)malloc(sizeof(uint32_t) * write_count);
+    uint64_t* points = (uint64_t*)malloc(sizeof(uint64_t) * write_count * 2);
+    uint32_t* order = (uint32_t*)malloc(sizeof(uint32_t) * write_count * 2);
+    uint32_t* tmp = (uint32_t*)malloc(sizeof(uint32_t) * write_count * 2);
+    WritePiece* pieces = (WritePiece*)malloc(sizeof(WritePiece) * write_count * 2);
+    uint32_t* first_piece = (uint32_t*)malloc(sizeof(uint32_t) * plan->record_count);
+    uint32_t* epoch = (uint32_t*)malloc(sizeof(uint32_t) * plan->record_count);
+    uint32_t* copies = (uint32_t*)malloc(sizeof(uint32_t) * (copy_count ? copy_count : 1));
+    bool okay = writes && points && order && tmp && pieces && first_piece && epoch && copies;
+    if (!okay)
+    {
+        printf("no memory to resolve overlapping writes\n");
+    }
+
+    const ResolveContext ctx = {plan, epoch, NULL};
+    size_t piece_count = 0;
+    size_t conflicts = 0;
+    if (okay)
+    {
+        size_t n = 0;
+        copy_count = 0;
+        for (size_t i = 0; i < plan->record_count; i++)
+        {
+            if (is_interval(&plan->records[i]))
+            {
+                writes[n++] = i;
+            }
+            else if (plan->records[i].kind == PATCH_PLAN_COPY)
+            {
+                copies[copy_count++] = i;
+            }
+        }
+        write_count = n;
+        for (size_t i = 0; i < write_count; i++)
+        {
+            epoch[writes[i]] = copy_count ? copy_count_before(plan, copies, copy_count, writes[i]) : 0;
+        }
+        sort_indices(writes, tmp, write_count, &ctx, record_less);
+
+        for (size_t first = 0; first < write_count;)
+        {
+            const PatchPlanRecord* head = &plan->records[writes[first]];
+            uint64_t cluster_end = record_end(head);
+            size_t last = first + 1;
+            while (last < write_count && same_epoch(&ctx, writes[first], writes[last]) && plan->records[writes[last]].addr < cluster_end)
+            {
+                const PatchPlanRecord* rec = &plan->records[writes[last]];
+                if (record_end(rec) > cluster_end)
+                {
+                    cluster_end = record_end(rec);
+                }
+                last++;
+            }
+
+            if (last - first == 1)
+            {
+                pieces[piece_count].owner = writes[first];
+                pieces[piece_count].addr = head->addr;
+                pieces[piece_count].size = head->size;
+                pieces[piece_count].next = NO_RECORD;
+                piece_count++;
+            }
+            else
+            {
+                piece_count += resolve_cluster(&ctx, &writes[first], last - first, points, order, tmp, &pieces[piece_count], &conflicts);
+            }
+            first = last;
+        }
+
+        // pieces are emitted by address, chain them per record to put them back in file order
+        for (size_t i = 0; i < plan->record_count; i++)
+        {
+            first_piece[i] = NO_RECORD;
+        }
+        for (size_t i = piece_count; i-- > 0;)
+        {
+            pieces[i].next = first_piece[pieces[i].owner];
+            first_piece[pieces[i].owner] = i;
+        }
+    }
+
+    PatchPlan resolved;
+    patch_plan_init(&resolved);
+    size_t before = 0, after = 0;
+    for (size_t i = 0; okay && i < plan->record_count; i++)
+    {
+        const PatchPlanRecord* rec = &plan->records[i];
+        if (!is_interval(rec))
+        {
+            okay = patch_plan_add_record(&resolved, plan, rec);
+            continue;
+        }
+
+        before += rec->size;
+        for (uint32_t p = first_piece[i]; okay && p != NO_RECORD; p = pieces[p].next)
+        {
+            const WritePiece* piece = &pieces[p];
+            if (piece->addr == rec->addr && piece->size == rec->size)
+            {
+                okay = patch_plan_add_record(&resolved, plan, rec);
+            }
+            else
+            {
+                okay = add_piece(&resolved, plan, rec, piece);
+            }
+            after += piece->size;
+        }
+    }
+
+    free(writes);
+    free(points);
+    free(order);
+    free(tmp);
+    free(pieces);
+    free(first_piece);
+    free(epoch);
+    free(copies);
+
+    if (!okay)
+    {
+        patch_plan_free(&resolved);
+        return false;
+    }
+
+    if (before != after)
+    {
+        printf("overlapping writes: %ld conflicts, %ld of %ld bytes were shadowed\n", conflicts, before - after, before);
+    }
+    resolved.patch_count = plan->patch_count;
+    resolved.phase = plan->phase;
+    patch_plan_free(plan);
+    *plan = resolved;
+    return true;
+}
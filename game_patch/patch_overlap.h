@@ -0,0 +1,15 @@
+#pragma once
+
+#if !defined(PATCH_OVERLAP_H)
+#define PATCH_OVERLAP_H
+
+#include "patch_plan.h"
+
+// Rewrites the write, fill and file records of `plan` so every byte is written once, by the last record
+// to run that covers it: deferred records after early ones, file order within a phase. Shadowed records
+// are dropped, partial overlaps are split and conflicts
+// between different patches are logged. Copies read memory as it is when they run, so they are kept as
+// they are and nothing before one is dropped for something after it.
+bool patch_plan_resolve_overlaps(PatchPlan* plan);
+
+#endif
@@ -0,0 +1,709 @@
+#include "patch_plan.h"
+#include "../shared/stringid.h"
+
+#include <sys/process.h>
+#include <sys/synchronization.h>
+#include "Memory/Memory.h"
+#include "../shared/memory.h"
+#include "plugins.h"
+#include "lv2_stdio.h"
+#include "lib/file.h"
+#include "module_table.h"
+
+#include "../shared/macros.h"
+
+extern program_args* g_args;
+
+static bool bytes_equal(const void* a, const void* b, size_t size)
+{
+    const uint8_t* pa = (const uint8_t*)a;
+    const uint8_t* pb = (const uint8_t*)b;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (pa[i] != pb[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// no realloc in lv2 libc
+static void* grow_buffer(void* old, const size_t old_size, const size_t new_size)
+{
+    void* p = malloc(new_size);
+    if (!p)
+    {
+        return NULL;
+    }
+    if (old)
+    {
+        memcpy(p, old, old_size);
+        free(old);
+    }
+    return p;
+}
+
+void patch_plan_init(PatchPlan* plan)
+{
+    bzero(plan, sizeof(*plan));
+}
+
+void patch_plan_free(PatchPlan* plan)
+{
+    if (!plan)
+    {
+        return;
+    }
+    free(plan->records);
+    free(plan->data);
+    bzero(plan, sizeof(*plan));
+}
+
+// reserves a record whose payload (`data_size` bytes) isn't necessarily `size` long
+static PatchPlanRecord* plan_push(PatchPlan* plan, uint32_t hash, uint32_t module, PatchPlanKind kind, uint32_t addr, size_t size, size_t data_size)
+{
+    if (plan->record_count >= plan->record_capacity)
+    {
+        const size_t new_capacity = plan->record_capacity ? plan->record_capacity * 2 : 32;
+        PatchPlanRecord* records = (PatchPlanRecord*)grow_buffer(plan->records,
+                                                                 sizeof(PatchPlanRecord) * plan->record_count,
+                                                                 sizeof(PatchPlanRecord) * new_capacity);
+        if (!records)
+        {
+            return NULL;
+        }
+        plan->records = records;
+        plan->record_capacity = new_capacity;
+    }
+
+    if (plan->data_size + data_size > plan->data_capacity)
+    {
+        size_t new_capacity = plan->data_capacity ? plan->data_capacity : 256;
+        while (plan->data_size + data_size > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+        uint8_t* new_data = (uint8_t*)grow_buffer(plan->data, plan->data_size, new_capacity);
+        if (!new_data)
+        {
+            return NULL;
+        }
+        plan->data = new_data;
+        plan->data_capacity = new_capacity;
+    }
+
+    PatchPlanRecord* rec = &plan->records[plan->record_count];
+    rec->hash = hash;
+    rec->module = module;
+    rec->kind = kind;
+    rec->phase = plan->phase;
+    rec->addr = addr;
+    rec->size = size;
+    rec->data_offset = plan->data_size;
+    plan->data_size += data_size;
+    plan->record_count++;
+    return rec;
+}
+
+bool patch_plan_add(PatchPlan* plan, uint32_t hash, uint32_t module, PatchPlanKind kind, uint32_t addr, const void* data, size_t size)
+{
+    if (!plan || (size && !data))
+    {
+        return false;
+    }
+
+    PatchPlanRecord* rec = plan_push(plan, hash, module, kind, addr, size, size);
+    if (!rec)
+    {
+        return false;
+    }
+    if (size)
+    {
+        memcpy(plan->data + rec->data_offset, data, size);
+    }
+    return true;
+}
+
+bool patch_plan_add_fill(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t addr, const void* pattern, size_t pattern_size, size_t size)
+{
+    if (!plan || !pattern || !pattern_size || !size)
+    {
+        return false;
+    }
+
+    PatchPlanRecord* rec = plan_push(plan, hash, module, PATCH_PLAN_FILL, addr, size, sizeof(uint32_t) + pattern_size);
+    if (!rec)
+    {
+        return false;
+    }
+    const uint32_t len = pattern_size;
+    memcpy(plan->data + rec->data_offset, &len, sizeof(len));
+    memcpy(plan->data + rec->data_offset + sizeof(len), pattern, pattern_size);
+    return true;
+}
+
+bool patch_plan_add_copy(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t dst, uint32_t src, size_t size)
+{
+    if (!plan || !size)
+    {
+        return false;
+    }
+
+    PatchPlanRecord* rec = plan_push(plan, hash, module, PATCH_PLAN_COPY, dst, size, sizeof(src));
+    if (!rec)
+    {
+        return false;
+    }
+    memcpy(plan->data + rec->data_offset, &src, sizeof(src));
+    return true;
+}
+
+#define MAX_PATCH_DUMP 64
+
+static sys_pid_t get_current_pid()
+{
+    static sys_pid_t current_pid = 0;
+    if (!current_pid)
+    {
+        current_pid = sys_process_getpid();
+    }
+    return current_pid;
+}
+
+bool patch_plan_add_file(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t addr, const char* path, uint32_t offset, size_t size, uint32_t checksum)
+{
+    if (!plan || !path || !size)
+    {
+        return false;
+    }
+
+    const size_t path_size = strlen(path) + 1;
+    PatchPlanRecord* rec = plan_push(plan, hash, module, PATCH_PLAN_FILE, addr, size, sizeof(PatchPlanFile) + path_size);
+    if (!rec)
+    {
+        return false;
+    }
+    PatchPlanFile* file = (PatchPlanFile*)(plan->data + rec->data_offset);
+    file->offset = offset;
+    file->length = size;
+    file->checksum = checksum;
+    file->skip = 0;
+    memcpy(file->path, path, path_size);
+    return true;
+}
+
+// Built the first time a module relative record is applied, once per apply pass
+static ModuleTable s_modules;
+
+// `loaded` is set when every record of the plan belongs to that one module
+static const ModuleSegments* find_module(const ModuleSegments* loaded, uint32_t module)
+{
+    if (loaded)
+    {
+        return loaded->name_hash == module ? loaded : NULL;
+    }
+    if (!s_modules.built)
+    {
+        module_table_build(&s_modules, get_current_pid());
+    }
+    return module_table_find(&s_modules, module);
+}
+
+static bool resolve_addr(const ModuleSegments* segments, uint32_t module, uint32_t addr, uint32_t size, uint32_t* out)
+{
+    if (!module)
+    {
+        *out = addr;
+        return true;
+    }
+    return segments && module_table_resolve(segments, addr, size, out);
+}
+
+static void write_patch(void* addr, const void* val, const size_t valsz)
+{
+    const sys_pid_t current_pid = get_current_pid();
+    if (current_pid)
+    {
+        const size_t dumpsz = valsz < MAX_PATCH_DUMP ? valsz : MAX_PATCH_DUMP;
+        hex_dump((void*)addr, dumpsz, (uintptr_t)addr);
+        WriteProcessMemory(current_pid, addr, val, valsz);
+        hex_dump((void*)addr, dumpsz, (uintptr_t)addr);
+    }
+}
+
+// Written a chunk at a time. The chunk is a whole number of patterns, so one buffer serves every write.
+static void fill_patch(const PatchPlanRecord* rec, uint32_t addr, const uint8_t* data)
+{
+    uint32_t pattern_size = 0;
+    memcpy(&pattern_size, data, sizeof(pattern_size));
+    const uint8_t* pattern = data + sizeof(pattern_size);
+    if (!pattern_size)
+    {
+        return;
+    }
+
+    const uint32_t chunk_size = rec->size < PATCH_FILE_CHUNK_SIZE ? rec->size : PATCH_FILE_CHUNK_SIZE - PATCH_FILE_CHUNK_SIZE % pattern_size;
+    uint8_t* buf = chunk_size ? (uint8_t*)malloc(chunk_size) : NULL;
+    if (buf)
+    {
+        for (uint32_t i = 0; i < chunk_size; i++)
+        {
+            buf[i] = pattern[i % pattern_size];
+        }
+        for (uint32_t off = 0; off < rec->size; off += chunk_size)
+        {
+            const uint32_t left = rec->size - off;
+            write_patch((void*)(addr + off), buf, left < chunk_size ? left : chunk_size);
+        }
+        free(buf);
+        return;
+    }
+
+    // not enough memory for one write, go a pattern at a time
+    printf("fill of %d bytes at 0x%08x done in pieces\n", rec->size, addr);
+    for (uint32_t off = 0; off < rec->size; off += pattern_size)
+    {
+        const uint32_t left = rec->size - off;
+        write_patch((void*)(addr + off), pattern, left < pattern_size ? left : pattern_size);
+    }
+}
+
+static void copy_patch(const PatchPlanRecord* rec, const ModuleSegments* segments, uint32_t dst, const uint8_t* data)
+{
+    uint32_t src = 0;
+    memcpy(&src, data, sizeof(src));
+    if (!resolve_addr(segments, rec->module, src, rec->size, &src))
+    {
+        return;
+    }
+
+    if (src < dst + rec->size && dst < src + rec->size)
+    {
+        // overlapping, stage through a buffer so the source isn't clobbered mid copy
+        uint8_t* buf = (uint8_t*)malloc(rec->size);
+        if (!buf)
+        {
+            printf("no memory to copy 0x%08x -> 0x%08x\n", src, dst);
+            return;
+        }
+        memcpy(buf, (const void*)src, rec->size);
+        write_patch((void*)dst, buf, rec->size);
+        free(buf);
+        return;
+    }
+
+    write_patch((void*)dst, (const void*)src, rec->size);
+}
+
+static bool read_chunk(FileHandle h, uint8_t* buf, uint32_t size)
+{
+    uint64_t readcount = 0;
+    return fileRead(h, buf, size, &readcount) == FILE_STATUS_OK && readcount == size;
+}
+
+// Checksum is verified before anything is written, so a file is either applied whole or not at all.
+// Fits in one chunk: one read, one write. Otherwise a hashing pass, then one write per chunk.
+static void file_patch(const PatchPlanRecord* rec, uint32_t addr, const uint8_t* data)
+{
+    const PatchPlanFile* file = (const PatchPlanFile*)data;
+    char path[MAX_PATH + 1] = {0};
+    snprintf(path, _countof_1(path), GAME_PATCH_DATA_PATH "/%s", file->path);
+    if ((uint64_t)file->skip + rec->size > file->length)
+    {
+        printf("patch data %s record is outside of its checked range\n", path);
+        return;
+    }
+
+    FileHandle h = 0;
+    if (fileOpen(&h, path, FILE_MODE_READ) != FILE_STATUS_OK)
+    {
+        printf("failed to open patch data %s\n", path);
+        return;
+    }
+
+    uint64_t fsz = 0;
+    const uint32_t chunk_size = file->length < PATCH_FILE_CHUNK_SIZE ? file->length : PATCH_FILE_CHUNK_SIZE;
+    uint8_t* buf = (uint8_t*)malloc(chunk_size);
+    uint64_t pos = 0;
+    if (!buf || fileSize(h, &fsz) != FILE_STATUS_OK || (uint64_t)file->offset + file->length > fsz ||
+        fileSeek(h, FILE_SEEK_START, file->offset, &pos) != FILE_STATUS_OK)
+    {
+        printf("patch data %s is too small or unreadable (%lld < 0x%x + 0x%x)\n", path, fsz, file->offset, file->length);
+        free(buf);
+        fileClose(h);
+        return;
+    }
+
+    uint32_t hash = 0;
+    bool okay = true;
+    for (uint32_t off = 0; okay && off < file->length; off += chunk_size)
+    {
+        const uint32_t left = file->length - off;
+        const uint32_t len = left < chunk_size ? left : chunk_size;
+        okay = read_chunk(h, buf, len);
+        hash = memid(buf, len, hash);
+    }
+
+    if (!okay || hash != file->checksum)
+    {
+        printf("patch data %s checksum 0x%08x, expected 0x%08x. not applying\n", path, hash, file->checksum);
+    }
+    else if (file->length == chunk_size)
+    {
+        // already holds the whole range
+        write_patch((void*)addr, buf + file->skip, rec->size);
+    }
+    else if (fileSeek(h, FILE_SEEK_START, file->offset + file->skip, &pos) == FILE_STATUS_OK)
+    {
+        for (uint32_t off = 0; off < rec->size; off += chunk_size)
+        {
+            const uint32_t left = rec->size - off;
+            const uint32_t len = left < chunk_size ? left : chunk_size;
+            if (!read_chunk(h, buf, len))
+            {
+                printf("patch data %s changed while applying at 0x%x\n", path, off);
+                break;
+            }
+            write_patch((void*)(addr + off), buf, len);
+        }
+    }
+
+    free(buf);
+    fileClose(h);
+}
+
+static size_t record_data_size(const PatchPlan* plan, const PatchPlanRecord* rec)
+{
+    const uint8_t* data = plan->data + rec->data_offset;
+    switch (rec->kind)
+    {
+        case PATCH_PLAN_FILL:
+        {
+            uint32_t pattern_size = 0;
+            memcpy(&pattern_size, data, sizeof(pattern_size));
+            return sizeof(pattern_size) + pattern_size;
+        }
+        case PATCH_PLAN_COPY:
+        {
+            return sizeof(uint32_t);
+        }
+        case PATCH_PLAN_FILE:
+        {
+            return sizeof(PatchPlanFile) + strlen(((const PatchPlanFile*)data)->path) + 1;
+        }
+        default:
+        {
+            return rec->size;
+        }
+    }
+}
+
+bool patch_plan_add_record(PatchPlan* plan, const PatchPlan* src, const PatchPlanRecord* rec)
+{
+    const size_t data_size = record_data_size(src, rec);
+    PatchPlanRecord* copy = plan_push(plan, rec->hash, rec->module, (PatchPlanKind)rec->kind, rec->addr, rec->size, data_size);
+    if (!copy)
+    {
+        return false;
+    }
+    copy->phase = rec->phase;
+    memcpy(plan->data + copy->data_offset, src->data + rec->data_offset, data_size);
+    return true;
+}
+
+// argv is read by the game's start(), anything later is too late for it
+static PatchPhase record_phase(const PatchPlanRecord* rec)
+{
+    return rec->kind == PATCH_PLAN_APPEND_ARG ? PATCH_PHASE_EARLY : (PatchPhase)rec->phase;
+}
+
+size_t patch_plan_phase_count(const PatchPlan* plan, PatchPhase phase)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        if (phase == PATCH_PHASE_ANY || record_phase(&plan->records[i]) == phase)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// bytes about to be overwritten are saved here when set, for reverting
+static PatchJournal* s_journal = NULL;
+
+// Plans are applied from the boot path, the deferred phase thread, the load_module hook and the hot reload
+// thread. Recursive, so a holder can still go through patch_plan_apply_*(); priority inherit because the
+// hook runs on a game thread and may wait for one of the low priority threads.
+static sys_mutex_t s_lock = 0;
+
+void patch_plan_lock(void)
+{
+    if (!s_lock)
+    {
+        // first taken on the boot path, before any of the other threads exist
+        sys_mutex_attribute_t attr;
+        sys_mutex_attribute_initialize(attr);
+        attr.attr_protocol = SYS_SYNC_PRIORITY_INHERIT;
+        attr.attr_recursive = SYS_SYNC_RECURSIVE;
+        const int ret = sys_mutex_create(&s_lock, &attr);
+        if (ret != 0)
+        {
+            printf("sys_mutex_create failed 0x%08x\n", ret);
+            s_lock = 0;
+            return;
+        }
+    }
+    sys_mutex_lock(s_lock, 0);
+}
+
+void patch_plan_unlock(void)
+{
+    if (s_lock)
+    {
+        sys_mutex_unlock(s_lock);
+    }
+}
+
+void patch_plan_set_journal(PatchJournal* journal)
+{
+    patch_plan_lock();
+    s_journal = journal;
+    patch_plan_unlock();
+}
+
+// Where `rec` gets written in this pass, false if it's skipped. `hash` limits it to one patch, 0 for all.
+static bool record_target(const PatchPlan* plan, const PatchPlanRecord* rec, const ModuleSegments* loaded, PatchPhase phase,
+                          PatchPlan* missing, uint32_t hash, const ModuleSegments** segments, uint32_t* addr)
+{
+    if (hash && rec->hash != hash)
+    {
+        return false;
+    }
+    *segments = rec->module ? find_module(loaded, rec->module) : NULL;
+    if (rec->module && !*segments)
+    {
+        // later phases see the same snapshot, these were handed over by the early pass
+        if (missing && !patch_plan_add_record(missing, plan, rec))
+        {
+            printf("module 0x%08x isn't loaded, skipping patch at +0x%x\n", rec->module, rec->addr);
+        }
+        return false;
+    }
+    if (phase != PATCH_PHASE_ANY && record_phase(rec) != phase)
+    {
+        return false;
+    }
+
+    *addr = rec->addr;
+    return rec->kind == PATCH_PLAN_APPEND_ARG || resolve_addr(*segments, rec->module, rec->addr, rec->size, addr);
+}
+
+static void apply_records(const PatchPlan* plan, const ModuleSegments* loaded, PatchPhase phase, PatchPlan* missing, uint32_t hash)
+{
+    if (s_journal)
+    {
+        // everything is read before anything is written, so overlapping records all save the real originals
+        for (size_t i = 0; i < plan->record_count; i++)
+        {
+            const PatchPlanRecord* rec = &plan->records[i];
+            const ModuleSegments* segments = NULL;
+            uint32_t addr = 0;
+            if (rec->kind != PATCH_PLAN_APPEND_ARG && record_target(plan, rec, loaded, phase, NULL, hash, &segments, &addr) &&
+                !journal_reserve(s_journal, rec->hash, addr, rec->size))
+            {
+                printf("no room to save original bytes at 0x%08x\n", addr);
+            }
+        }
+        journal_commit(s_journal);
+    }
+
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        const PatchPlanRecord* rec = &plan->records[i];
+        const uint8_t* data = plan->data + rec->data_offset;
+        const ModuleSegments* segments = NULL;
+        uint32_t addr = 0;
+        if (!record_target(plan, rec, loaded, phase, missing, hash, &segments, &addr))
+        {
+            continue;
+        }
+
+        switch (rec->kind)
+        {
+            case PATCH_PLAN_WRITE:
+            {
+                write_patch((void*)addr, data, rec->size);
+                break;
+            }
+            case PATCH_PLAN_FILL:
+            {
+                fill_patch(rec, addr, data);
+                break;
+            }
+            case PATCH_PLAN_COPY:
+            {
+                copy_patch(rec, segments, addr, data);
+                break;
+            }
+            case PATCH_PLAN_FILE:
+            {
+                file_patch(rec, addr, data);
+                break;
+            }
+            case PATCH_PLAN_APPEND_ARG:
+            {
+                if (g_args && append_arg(g_args, (const char*)data))
+                {
+                    printf("appended \"%s\" okay!\n", (const char*)data);
+                }
+                else
+                {
+                    printf("couldn't append \"%s\".\n", (const char*)data);
+                }
+                break;
+            }
+            default:
+            {
+                printf("unknown plan record kind %d\n", rec->kind);
+                break;
+            }
+        }
+    }
+}
+
+void patch_plan_apply(const PatchPlan* plan, PatchPhase phase, PatchPlan* missing)
+{
+    patch_plan_lock();
+    if (phase != PATCH_PHASE_DEFERRED)
+    {
+        // modules may have been loaded or unloaded since the last pass
+        s_modules.built = false;
+    }
+    apply_records(plan, NULL, phase, missing, 0);
+    patch_plan_unlock();
+}
+
+void patch_plan_apply_module(const PatchPlan* plan, const ModuleSegments* module)
+{
+    patch_plan_lock();
+    apply_records(plan, module, PATCH_PHASE_ANY, NULL, 0);
+    patch_plan_unlock();
+}
+
+void patch_plan_apply_patch(const PatchPlan* plan, uint32_t hash)
+{
+    patch_plan_lock();
+    s_modules.built = false;
+    apply_records(plan, NULL, PATCH_PHASE_ANY, NULL, hash);
+    patch_plan_unlock();
+}
+
+bool patch_plan_make_key(PatchPlanKey* key, const GameLaunchRecord* launch, const char* exe_path, uint64_t exe_fingerprint)
+{
+    bzero(key, sizeof(*key));
+    if (!(launch->flags & GAME_LAUNCH_HAS_PATCH_FILE))
+    {
+        return false;
+    }
+    memcpy(key->titleid, launch->info.titleid, sizeof(key->titleid));
+    memcpy(key->app_ver, launch->info.app_ver, sizeof(key->app_ver));
+    key->exe_hash = stringid(exe_path ? exe_path : "", 0);
+    key->exe_fingerprint = exe_fingerprint;
+    key->state_checksum = launch->state_checksum;
+    key->patch_file_size = launch->patch_file_size;
+    key->patch_file_mtime = launch->patch_file_mtime;
+    return true;
+}
+
+static uint32_t plan_checksum(const PatchPlan* plan)
+{
+    const uint32_t hash = memid(plan->records, sizeof(PatchPlanRecord) * plan->record_count, 0);
+    return memid(plan->data, plan->data_size, hash);
+}
+
+bool patch_plan_load(PatchPlan* plan, const char* path, const PatchPlanKey* key)
+{
+    FileHandle h = 0;
+    if (fileOpen(&h, path, FILE_MODE_READ) != FILE_STATUS_OK)
+    {
+        return false;
+    }
+
+    bool okay = false;
+    PatchPlanFileHeader header;
+    uint64_t readcount = 0;
+    if (fileRead(h, &header, sizeof(header), &readcount) == FILE_STATUS_OK && readcount == sizeof(header) &&
+        header.magic == PATCH_PLAN_MAGIC && header.version == PATCH_PLAN_VERSION &&
+        bytes_equal(&header.key, key, sizeof(*key)))
+    {
+        const size_t records_size = sizeof(PatchPlanRecord) * header.record_count;
+        plan->records = (PatchPlanRecord*)malloc(records_size ? records_size : 1);
+        plan->data = (uint8_t*)malloc(header.data_size ? header.data_size : 1);
+        if (plan->records && plan->data)
+        {
+            uint64_t records_read = 0, data_read = 0;
+            if ((!records_size || (fileRead(h, plan->records, records_size, &records_read) == FILE_STATUS_OK && records_read == records_size)) &&
+                (!header.data_size || (fileRead(h, plan->data, header.data_size, &data_read) == FILE_STATUS_OK && data_read == header.data_size)))
+            {
+                plan->record_count = plan->record_capacity = header.record_count;
+                plan->data_size = plan->data_capacity = header.data_size;
+                plan->patch_count = header.patch_count;
+                okay = plan_checksum(plan) == header.checksum;
+            }
+        }
+        if (!okay)
+        {
+            patch_plan_free(plan);
+        }
+    }
+    else
+    {
+        printf("patch plan %s is stale\n", path);
+    }
+
+    fileClose(h);
+    return okay;
+}
+
+bool patch_plan_save(const PatchPlan* plan, const char* path, const PatchPlanKey* key)
+{
+    FileHandle h = 0;
+    if (fileOpen(&h, path, FILE_MODE_CREATE_TRUNCATE) != FILE_STATUS_OK)
+    {
+        printf("failed to create patch plan %s\n", path);
+        return false;
+    }
+
+    PatchPlanFileHeader header;
+    bzero(&header, sizeof(header));
+    header.magic = PATCH_PLAN_MAGIC;
+    header.version = PATCH_PLAN_VERSION;
+    header.key = *key;
+    header.patch_count = plan->patch_count;
+    header.record_count = plan->record_count;
+    header.data_size = plan->data_size;
+    header.checksum = plan_checksum(plan);
+
+    const size_t records_size = sizeof(PatchPlanRecord) * plan->record_count;
+    uint64_t writecount = 0;
+    bool okay = fileWrite(h, &header, sizeof(header), &writecount) == FILE_STATUS_OK;
+    if (okay && records_size)
+    {
+        okay = fileWrite(h, plan->records, records_size, &writecount) == FILE_STATUS_OK;
+    }
+    if (okay && plan->data_size)
+    {
+        okay = fileWrite(h, plan->data, plan->data_size, &writecount) == FILE_STATUS_OK;
+    }
+    fileClose(h);
+
+    if (!okay)
+    {
+        // don't leave a half written plan behind
+        fileDelete(path);
+    }
+    return okay;
+}
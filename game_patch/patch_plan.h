@@ -0,0 +1,122 @@
+#pragma once
+
+#if !defined(PATCH_PLAN_H)
+#define PATCH_PLAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../shared/GamePatchInfo.h"
+#include "module_table.h"
+#include "journal.h"
+
+#define PATCH_PLAN_MAGIC (uint32_t)'PLAN'
+#define PATCH_PLAN_VERSION 5
+
+typedef enum
+{
+    PATCH_PLAN_WRITE,       // `size` bytes written to `addr`
+    PATCH_PLAN_APPEND_ARG,  // nul terminated string appended to argv
+    PATCH_PLAN_FILL,        // data is u32 pattern length + pattern, repeated over `size` bytes
+    PATCH_PLAN_COPY,        // data is u32 source address (same module as `addr`), `size` bytes copied to `addr`
+    PATCH_PLAN_FILE,        // data is PatchPlanFile, `size` bytes streamed from it to `addr`
+} PatchPlanKind;
+
+typedef enum
+{
+    PATCH_PHASE_EARLY,     // before the game's start(), on the boot path
+    PATCH_PHASE_DEFERRED,  // on a low priority thread after module_start, once the game loads its first prx (or a timeout)
+    PATCH_PHASE_ANY,
+} PatchPhase;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t hash;         // hash of the patch this record belongs to
+    uint32_t module;       // module_name_hash() of the prx `addr` is relative to, 0 = absolute
+    uint32_t kind;         // PatchPlanKind
+    uint32_t phase;        // PatchPhase
+    uint32_t addr;
+    uint32_t size;
+    uint32_t data_offset;  // offset into PatchPlan.data
+} PatchPlanRecord;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t offset;
+    uint32_t length;    // bytes at `offset` the checksum covers
+    uint32_t checksum;  // 32 bit FNV-1a (memid) of those bytes
+    uint32_t skip;      // the record writes `size` bytes from `offset + skip`, less than `length` once overlaps split it
+    char path[];        // relative to GAME_PATCH_DATA_PATH
+} PatchPlanFile;
+
+// Read size of file backed patches, also the most that is written per call
+#define PATCH_FILE_CHUNK_SIZE (64 * 1024)
+
+// Everything the resolved plan depends on.
+// Any change here means the yml has to be parsed again.
+typedef struct __attribute__((packed))
+{
+    char titleid[16];
+    char app_ver[8];
+    uint32_t exe_hash;        // argv[0], `app_bin` is matched against it
+    uint64_t exe_fingerprint;  // changes with the executable even if app_ver doesn't
+    uint32_t state_checksum;  // settings/<TITLEID>.bin, changes on every toggle
+    uint64_t patch_file_size;
+    int64_t patch_file_mtime;
+} PatchPlanKey;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t version;
+    PatchPlanKey key;
+    uint32_t patch_count;
+    uint32_t record_count;
+    uint32_t data_size;
+    uint32_t checksum;  // records and data
+} PatchPlanFileHeader;
+
+typedef struct
+{
+    PatchPlanRecord* records;
+    size_t record_count;
+    size_t record_capacity;
+    uint8_t* data;
+    size_t data_size;
+    size_t data_capacity;
+    size_t patch_count;
+    PatchPhase phase;  // given to records added from now on
+} PatchPlan;
+
+void patch_plan_init(PatchPlan* plan);
+void patch_plan_free(PatchPlan* plan);
+
+bool patch_plan_add(PatchPlan* plan, uint32_t hash, uint32_t module, PatchPlanKind kind, uint32_t addr, const void* data, size_t size);
+bool patch_plan_add_fill(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t addr, const void* pattern, size_t pattern_size, size_t size);
+bool patch_plan_add_copy(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t dst, uint32_t src, size_t size);
+bool patch_plan_add_file(PatchPlan* plan, uint32_t hash, uint32_t module, uint32_t addr, const char* path, uint32_t offset, size_t size, uint32_t checksum);
+bool patch_plan_add_record(PatchPlan* plan, const PatchPlan* src, const PatchPlanRecord* rec);
+
+size_t patch_plan_phase_count(const PatchPlan* plan, PatchPhase phase);
+
+// Applies the records of `phase`. Records for modules that aren't loaded yet are copied to `missing`
+// (may be NULL) whatever their phase. The early pass takes the module snapshot later phases reuse.
+void patch_plan_apply(const PatchPlan* plan, PatchPhase phase, PatchPlan* missing);
+// Applies a plan that only holds records for `module`.
+void patch_plan_apply_module(const PatchPlan* plan, const ModuleSegments* module);
+// Applies the records of one patch, whatever their phase.
+void patch_plan_apply_patch(const PatchPlan* plan, uint32_t hash);
+
+// While set, the bytes each record overwrites are saved to `journal` first.
+void patch_plan_set_journal(PatchJournal* journal);
+// Serializes every write to game memory and the state behind it (module snapshot, journal).
+// The apply functions take it themselves; hold it around journal reverts and multi step updates.
+void patch_plan_lock(void);
+void patch_plan_unlock(void);
+
+// The patch file stat and settings checksum come from the launch record, vsh took them before the game started.
+bool patch_plan_make_key(PatchPlanKey* key, const GameLaunchRecord* launch, const char* exe_path, uint64_t exe_fingerprint);
+bool patch_plan_load(PatchPlan* plan, const char* path, const PatchPlanKey* key);
+bool patch_plan_save(const PatchPlan* plan, const char* path, const PatchPlanKey* key);
+
+#endif
@@ -0,0 +1,317 @@
+#include "patch_signature.h"
+#include "../shared/stringid.h"
+
+#include <sys/process.h>
+#include <sys/sys_time.h>
+#include "Memory/ElfSegments.h"
+#include "Memory/SignatureScan.h"
+#include "lv2_stdio.h"
+#include "lib/file.h"
+#include "fingerprint.h"
+#include "my_string.h"
+
+void patch_signatures_init(PatchSignatures* signatures)
+{
+    bzero(signatures, sizeof(*signatures));
+}
+
+void patch_signatures_free(PatchSignatures* signatures)
+{
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        free(signatures->items[i].text);
+    }
+    bzero(signatures, sizeof(*signatures));
+}
+
+bool patch_signatures_add(PatchSignatures* signatures, uint32_t patch_hash, const char* text, int32_t offset, bool is_prx)
+{
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        if (signatures->items[i].patch_hash == patch_hash)
+        {
+            return true;
+        }
+    }
+    if (signatures->count == PATCH_SIGNATURES_MAX)
+    {
+        printf("too many signature patches, 0x%08x is skipped\n", patch_hash);
+        return false;
+    }
+
+    PatchSignature* signature = &signatures->items[signatures->count];
+    bzero(signature, sizeof(*signature));
+    signature->text = str_dup(text);
+    if (!signature->text)
+    {
+        return false;
+    }
+    signature->patch_hash = patch_hash;
+    signature->key = stringid(text, 0);
+    signature->offset = offset;
+    signature->is_prx = is_prx;
+    signatures->count++;
+    return true;
+}
+
+static const PatchSignature* find_signature(const PatchSignatures* signatures, uint32_t patch_hash)
+{
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        if (signatures->items[i].patch_hash == patch_hash)
+        {
+            return &signatures->items[i];
+        }
+    }
+    return NULL;
+}
+
+// Gives the match to every other signature with the same text
+static size_t share_match(PatchSignatures* signatures, uint32_t key, uint32_t match)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        PatchSignature* signature = &signatures->items[i];
+        if (signature->key == key && !signature->resolved && !signature->is_prx)
+        {
+            signature->match = match;
+            signature->resolved = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+static void load_cache(PatchSignatures* signatures, const char* cache_path, uint64_t exe_fingerprint)
+{
+    FileHandle h = 0;
+    if (!exe_fingerprint || fileOpen(&h, cache_path, FILE_MODE_READ) != FILE_STATUS_OK)
+    {
+        return;
+    }
+
+    SignatureCacheHeader header;
+    uint64_t readcount = 0;
+    if (fileRead(h, &header, sizeof(header), &readcount) == FILE_STATUS_OK && readcount == sizeof(header) &&
+        header.magic == SIGNATURE_CACHE_MAGIC && header.version == SIGNATURE_CACHE_VERSION && header.exe_fingerprint == exe_fingerprint)
+    {
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            SignatureCacheEntry entry;
+            if (fileRead(h, &entry, sizeof(entry), &readcount) != FILE_STATUS_OK || readcount != sizeof(entry))
+            {
+                break;
+            }
+            share_match(signatures, entry.key, entry.match);
+        }
+    }
+    fileClose(h);
+}
+
+static void save_cache(const PatchSignatures* signatures, const char* cache_path, uint64_t exe_fingerprint)
+{
+    FileHandle h = 0;
+    if (!exe_fingerprint || fileOpen(&h, cache_path, FILE_MODE_CREATE_TRUNCATE) != FILE_STATUS_OK)
+    {
+        return;
+    }
+
+    SignatureCacheHeader header;
+    bzero(&header, sizeof(header));
+    header.magic = SIGNATURE_CACHE_MAGIC;
+    header.version = SIGNATURE_CACHE_VERSION;
+    header.exe_fingerprint = exe_fingerprint;
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        header.count += signatures->items[i].resolved;
+    }
+
+    uint64_t writecount = 0;
+    bool okay = fileWrite(h, &header, sizeof(header), &writecount) == FILE_STATUS_OK;
+    for (size_t i = 0; okay && i < signatures->count; i++)
+    {
+        const PatchSignature* signature = &signatures->items[i];
+        if (signature->resolved)
+        {
+            SignatureCacheEntry entry = {signature->key, signature->match};
+            okay = fileWrite(h, &entry, sizeof(entry), &writecount) == FILE_STATUS_OK;
+        }
+    }
+    fileClose(h);
+
+    if (!okay)
+    {
+        fileDelete(cache_path);
+    }
+}
+
+// One batch scan over the code segments for every signature still unresolved. What a segment finds
+// leaves the batch, the first hit wins and later segments only look for the rest.
+static size_t scan_signatures(PatchSignatures* signatures)
+{
+    Signature* pending = (Signature*)malloc(sizeof(Signature) * signatures->count);
+    uint32_t* keys = (uint32_t*)malloc(sizeof(uint32_t) * signatures->count);
+    uintptr_t* results = (uintptr_t*)malloc(sizeof(uintptr_t) * signatures->count);
+    uint8_t* bytes = (uint8_t*)malloc(PATCH_SIGNATURE_MAX_SIZE * 2 * signatures->count);
+    size_t pending_count = 0;
+    size_t found = 0;
+    if (!pending || !keys || !results || !bytes)
+    {
+        printf("no memory to scan for signatures\n");
+        goto done;
+    }
+
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        const PatchSignature* signature = &signatures->items[i];
+        bool duplicate = false;
+        for (size_t j = 0; j < pending_count; j++)
+        {
+            duplicate |= keys[j] == signature->key;
+        }
+        if (signature->resolved || signature->is_prx || duplicate)
+        {
+            continue;
+        }
+
+        uint8_t* pattern = &bytes[PATCH_SIGNATURE_MAX_SIZE * 2 * pending_count];
+        uint8_t* mask = pattern + PATCH_SIGNATURE_MAX_SIZE;
+        const uint32_t size = SignatureParse(signature->text, pattern, mask, PATCH_SIGNATURE_MAX_SIZE);
+        if (!size)
+        {
+            printf("patch 0x%08x has a malformed signature \"%s\"\n", signature->patch_hash, signature->text);
+            continue;
+        }
+        bzero(&pending[pending_count], sizeof(pending[pending_count]));
+        pending[pending_count].bytes = pattern;
+        pending[pending_count].mask = mask;
+        pending[pending_count].size = size;
+        keys[pending_count] = signature->key;
+        pending_count++;
+    }
+
+    if (pending_count)
+    {
+        const uint32_t pid = sys_process_getpid();
+        CodeSegment segments[CODE_SEGMENTS_MAX];
+        const size_t segment_count = ElfCodeSegments(pid, EXE_ELF_BASE, segments, CODE_SEGMENTS_MAX);
+        for (size_t s = 0; s < segment_count && pending_count; s++)
+        {
+            const system_time_t start = sys_time_get_system_time();
+            const size_t hits = SignatureScanBatch(pid, segments[s].base, segments[s].size, pending, pending_count, results);
+            printf("scanned 0x%08x-0x%08x for %ld signatures in %lld us, %ld found\n",
+                   segments[s].base, segments[s].base + segments[s].size, pending_count, sys_time_get_system_time() - start, hits);
+            size_t kept = 0;
+            for (size_t i = 0; i < pending_count; i++)
+            {
+                if (results[i])
+                {
+                    found += share_match(signatures, keys[i], results[i]);
+                    continue;
+                }
+                pending[kept] = pending[i];
+                keys[kept] = keys[i];
+                kept++;
+            }
+            pending_count = kept;
+        }
+    }
+
+done:
+    free(pending);
+    free(keys);
+    free(results);
+    free(bytes);
+    return found;
+}
+
+void patch_signatures_resolve(PatchSignatures* signatures, const char* cache_path, uint64_t exe_fingerprint)
+{
+    if (!signatures->count)
+    {
+        return;
+    }
+
+    load_cache(signatures, cache_path, exe_fingerprint);
+    if (scan_signatures(signatures))
+    {
+        save_cache(signatures, cache_path, exe_fingerprint);
+    }
+
+    for (size_t i = 0; i < signatures->count; i++)
+    {
+        const PatchSignature* signature = &signatures->items[i];
+        if (signature->resolved)
+        {
+            printf("patch 0x%08x signature at 0x%08x\n", signature->patch_hash, signature->match);
+        }
+        else
+        {
+            printf("patch 0x%08x signature \"%s\" not found%s\n", signature->patch_hash, signature->text, signature->is_prx ? ", prx patches can't use signatures" : "");
+        }
+    }
+}
+
+bool patch_signatures_rebase(const PatchSignatures* signatures, PatchPlan* plan)
+{
+    if (!signatures->count)
+    {
+        return true;
+    }
+
+    size_t dropped = 0;
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        PatchPlanRecord* rec = &plan->records[i];
+        const PatchSignature* signature = find_signature(signatures, rec->hash);
+        if (!signature || rec->kind == PATCH_PLAN_APPEND_ARG)
+        {
+            continue;
+        }
+        if (!signature->resolved)
+        {
+            dropped++;
+            continue;
+        }
+
+        const uint32_t base = signature->match + signature->offset;
+        rec->addr += base;
+        if (rec->kind == PATCH_PLAN_COPY)
+        {
+            uint32_t src = 0;
+            memcpy(&src, plan->data + rec->data_offset, sizeof(src));
+            src += base;
+            memcpy(plan->data + rec->data_offset, &src, sizeof(src));
+        }
+    }
+    if (!dropped)
+    {
+        return true;
+    }
+
+    PatchPlan resolved;
+    patch_plan_init(&resolved);
+    bool okay = true;
+    for (size_t i = 0; okay && i < plan->record_count; i++)
+    {
+        const PatchPlanRecord* rec = &plan->records[i];
+        const PatchSignature* signature = find_signature(signatures, rec->hash);
+        if (!signature || signature->resolved || rec->kind == PATCH_PLAN_APPEND_ARG)
+        {
+            okay = patch_plan_add_record(&resolved, plan, rec);
+        }
+    }
+    if (!okay)
+    {
+        patch_plan_free(&resolved);
+        return false;
+    }
+
+    printf("dropped %ld writes of patches whose signature wasn't found\n", dropped);
+    resolved.patch_count = plan->patch_count;
+    resolved.phase = plan->phase;
+    patch_plan_free(plan);
+    *plan = resolved;
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#if !defined(PATCH_SIGNATURE_H)
+#define PATCH_SIGNATURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "patch_plan.h"
+
+#define PATCH_SIGNATURES_MAX 64
+#define PATCH_SIGNATURE_MAX_SIZE 256
+
+#define SIGNATURE_CACHE_MAGIC (uint32_t)'SIGC'
+#define SIGNATURE_CACHE_VERSION 1
+
+// A patch block addressed by `signature:`, its entries are offsets from the match plus `signature_offset:`
+typedef struct
+{
+    uint32_t patch_hash;
+    uint32_t key;  // stringid() of the signature text
+    int32_t offset;
+    uint32_t match;  // address of the signature, valid when resolved
+    bool resolved;
+    bool is_prx;
+    char* text;
+} PatchSignature;
+
+typedef struct
+{
+    PatchSignature items[PATCH_SIGNATURES_MAX];
+    size_t count;
+} PatchSignatures;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t exe_fingerprint;
+    uint32_t count;
+} SignatureCacheHeader;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t key;
+    uint32_t match;
+} SignatureCacheEntry;
+
+void patch_signatures_init(PatchSignatures* signatures);
+void patch_signatures_free(PatchSignatures* signatures);
+bool patch_signatures_add(PatchSignatures* signatures, uint32_t patch_hash, const char* text, int32_t offset, bool is_prx);
+
+// Looks the signatures up in `cache_path`, scans the executable's code segments once for all the
+// ones it doesn't have and writes them back. The cache is only trusted for the same exe fingerprint.
+void patch_signatures_resolve(PatchSignatures* signatures, const char* cache_path, uint64_t exe_fingerprint);
+
+// Moves the records of signature patches from block offsets to absolute addresses.
+// Records of patches whose signature wasn't found are dropped.
+bool patch_signatures_rebase(const PatchSignatures* signatures, PatchPlan* plan);
+
+#endif
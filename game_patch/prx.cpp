@@ -14,6 +14,8 @@ extern "C"
 {
 #include "lib/file.h"
 #include "lv2_stdio.h"
+#include "deferred.h"
+#include "hot_reload.h"
 }
 
 #include "../shared/GamePatchInfo.hpp"
@@ -24,13 +26,13 @@ SYS_MODULE_INFO(PPU_Game_Patch, 0, 1, 1);
 SYS_MODULE_START(module_start);
 SYS_MODULE_STOP(module_stop);
 
-extern "C" int run_patch(GamePatchInfo&);
+extern "C" int run_patch(GameLaunchRecord&);
 
-static int init_list(const char* path)
+static int init_list()
 {
-    GamePatchInfo info;
-    bzero(&info, sizeof(info));
-    if (load_game_info(path, info) && run_patch(info) == 0)
+    GameLaunchRecord record;
+    bzero(&record, sizeof(record));
+    if (load_launch_record(record) && run_patch(record) == 0)
     {
         puts("patch hopefully okay!");
     }
@@ -57,8 +59,9 @@ extern "C" int module_start(unsigned int argc, program_args& arg)
     {
         printf("arg[%d]: %s\n", i, arg.argv[i].c.lo ? arg.argv[i].c.lo : "");
     }
-    init_list(GAME_INFO_PATH);
-    return SYS_PRX_NO_RESIDENT;
+    init_list();
+    // the load_module hook and the deferred/hot reload threads live in this module
+    return deferred_patches_pending() || hot_reload_running() ? SYS_PRX_RESIDENT : SYS_PRX_NO_RESIDENT;
 }
 
 extern "C" int module_stop(void)
@@ -2,9 +2,15 @@
 #include <string>
 #include <sys/process.h>
 #include "Memory.hpp"
+#include "PowerPC.hpp"
+#include "TrampolinePool.hpp"
+#include "FnidIndex.hpp"
 
+#if !defined(MARK_AS_EXECUTABLE)
 #define MARK_AS_EXECUTABLE __attribute__((section(".text")))
+#endif
 
+// Looked up in an index of all stubs built on the first call
 opd_s* FindExportByName(const char* module, uint32_t fnid);
 opd_s* FindImportByName(const char* module, uint32_t fnid);
 
@@ -17,6 +23,18 @@ class Detour
         uint32_t hookBytes[4];
     };
 
+    struct HookRequest
+    {
+        Detour* detour;
+        uintptr_t fnAddress;
+        uintptr_t fnCallback;
+        uintptr_t tocOverride;
+    };
+
+   public:
+    // Bytes overwritten at the hooked function, a far jump that doesn't preserve r0
+    static const size_t HookSize = PowerPCFarJump<false>::Size;
+
    public:
     Detour();
     Detour(uintptr_t fnAddress, uintptr_t fnCallback);
@@ -29,6 +47,30 @@ class Detour
     virtual void Hook(uintptr_t fnAddress, uintptr_t fnCallback, uintptr_t tocOverride = 0);
     virtual bool UnHook();
 
+    /***
+     * Installs several detours at once. All trampolines go out in a single write, then one write per hook site.
+     * @param requests What to hook, requests[i].detour gets hooked like Hook(fnAddress, fnCallback, tocOverride).
+     * @param count Number of requests.
+     * @returns number of detours installed
+     */
+    static size_t HookBatch(const HookRequest* requests, size_t count);
+
+    // Usage of the memory shared by all trampolines.
+    static TrampolinePool::Stats GetTrampolineStats();
+
+    /***
+     * Writes a stub that calls the function of whatever opd *slot points to when it runs, with r2 loaded from that opd
+     * and the caller's r2 restored afterwards. Changing the slot redirects it with a single store, r0 and r12 are clobbered.
+     * @param slot Holds a pointer to an opd.
+     * @returns the stub in trampoline memory, nullptr when it couldn't be written
+     */
+    static uint8_t* CreateIndirectCall(const void* slot);
+
+    bool IsHooked() const { return m_HookAddress != nullptr && m_OriginalLength != 0; }
+
+    // opd that calls the original function, valid while hooked
+    const uint32_t* GetOriginalOpd() const { return m_TrampolineOpd; }
+
     // also works
     /*template<typename T>
     T GetOriginal() const
@@ -45,18 +87,18 @@ class Detour
 
    private:
     /***
-     * Writes an unconditional branch to the destination address that will branch to the target address.
-     * @param destination Where the branch will be written to.
+     * Assembles an unconditional branch that will branch to the target address.
+     * @param destination Local buffer the instructions are written to.
      * @param branchTarget The address the branch will jump to.
      * @param linked Branch is a call or a jump? aka bl or b
      * @param preserveRegister Preserve the register clobbered after loading the branch address.
      * @returns size of relocating the instruction in bytes
      */
-    size_t Jump(void* destination, const void* branchTarget, bool linked, bool preserveRegister);
+    size_t Jump(uint32_t* destination, const void* branchTarget, bool linked, bool preserveRegister);
 
     /***
-     * Writes both conditional and unconditional branches using the count register to the destination address that will branch to the target address.
-     * @param destination Where the branch will be written to.
+     * Assembles both conditional and unconditional branches using the count register that will branch to the target address.
+     * @param destination Local buffer the instructions are written to.
      * @param branchTarget The address the branch will jump to.
      * @param linked Branch is a call or a jump? aka bl or b
      * @param preserveRegister Preserve the register clobbered after loading the branch address.
@@ -65,32 +107,49 @@ class Detour
      * @param registerIndex Register to use when loading the destination address into the count register.
      * @returns size of relocating the instruction in bytes
      */
-    size_t JumpWithOptions(void* destination, const void* branchTarget, bool linked, bool preserveRegister, uint32_t branchOptions, uint8_t conditionRegisterBit, uint8_t registerIndex);
+    size_t JumpWithOptions(uint32_t* destination, const void* branchTarget, bool linked, bool preserveRegister, uint32_t branchOptions, uint8_t conditionRegisterBit, PowerPCRegister registerIndex);
 
     /***
      * Copies and fixes relative branch instructions to a new location.
-     * @param destination Where to write the new branch.
-     * @param source Address to the instruction that is being relocated.
+     * @param destination Local buffer to write the new branch to.
+     * @param instruction The instruction that is being relocated.
+     * @param instructionAddress Where the instruction was, branch offsets are relative to it.
      * @returns size of relocating the instruction in bytes
      */
-    size_t RelocateBranch(uint32_t* destination, uint32_t* source);
+    size_t RelocateBranch(uint32_t* destination, uint32_t instruction, uint32_t instructionAddress);
 
     /***
      * Copies an instruction enusuring things such as PC relative offsets are fixed.
-     * @param destination Where to write the new instruction(s).
-     * @param source Address to the instruction that is being copied.
+     * @param destination Local buffer to write the new instruction(s) to.
+     * @param instruction The instruction that is being copied.
+     * @param instructionAddress Where the instruction was.
      * @returns size of relocating the instruction in bytes
      */
-    size_t RelocateCode(uint32_t* destination, uint32_t* source);
+    size_t RelocateCode(uint32_t* destination, uint32_t instruction, uint32_t instructionAddress);
 
     /***
-     * Get's size of method hook in bytes
-     * @param branchTarget The address the branch will jump to.
-     * @param linked Branch is a call or a jump? aka bl or b
-     * @param preserveRegister Preserve the register clobbered after loading the branch address.
-     * @returns size of hook in bytes
+     * Saves the original instructions and assembles the trampoline for them, nothing is written yet.
+     * @param fnAddress The function we are hooking.
+     * @param fnCallback opd of the function the hook points to.
+     * @param trampoline Local buffer of at least TRAMPOLINE_MAX_SIZE bytes.
+     * @returns size of the trampoline in bytes, 0 if the function couldn't be read
+     */
+    size_t BuildTrampoline(uintptr_t fnAddress, uintptr_t fnCallback, uint32_t* trampoline);
+
+    /***
+     * Points the detour at its trampoline once it has a place in the pool.
+     * @param trampoline Block allocated for the trampoline.
+     * @param size Size of the trampoline in bytes.
+     * @param tocOverride toc of the original function, 0 for ours.
+     */
+    void PlaceTrampoline(uint8_t* trampoline, size_t size, uintptr_t tocOverride);
+
+    /***
+     * Gives the trampoline back to the pool and forgets the hook.
      */
-    size_t GetHookSize(const void* branchTarget, bool linked, bool preserveRegister);
+    void ReleaseTrampoline();
+
+    static TrampolinePool& GetTrampolinePool();
 
     /***
      * Retrieve infomation about address which contains bytes and name of hook owner
@@ -101,16 +160,16 @@ class Detour
     bool GetHookInfo(uintptr_t addr, HookInformation* hookInfo);
 
    protected:
-    const void* m_HookTarget;            // The funtion we are pointing the hook to.
-    void* m_HookAddress;                 // The function we are hooking.
-    uint8_t* m_TrampolineAddress;        // Pointer to the trampoline for this detour.
-    uint32_t m_TrampolineOpd[2];         // opd_s of the trampoline for this detour.
-    uint8_t m_OriginalInstructions[30];  // Any bytes overwritten by the hook.
-    size_t m_OriginalLength;             // The amount of bytes overwritten by the hook.
-
-    // Shared
+    const void* m_HookTarget;                  // The funtion we are pointing the hook to.
+    void* m_HookAddress;                       // The function we are hooking.
+    uint8_t* m_TrampolineAddress;              // Pointer to the trampoline for this detour.
+    size_t m_TrampolineSize;                   // Size of the trampoline in bytes.
+    uint32_t m_TrampolineOpd[2];               // opd_s of the trampoline for this detour.
+    uint8_t m_OriginalInstructions[HookSize];  // Any bytes overwritten by the hook.
+    size_t m_OriginalLength;                   // The amount of bytes overwritten by the hook.
+
+    // Shared, the first trampolines go here before the pool needs pages
     MARK_AS_EXECUTABLE static uint8_t s_TrampolineBuffer[2048];
-    static size_t s_TrampolineSize;
 };
 
 // list of fnids https://github.com/aerosoul94/ida_gel/blob/master/src/ps3/ps3.xml
@@ -0,0 +1,217 @@
+#include "ElfSegments.h"
+#include "Memory.h"
+#include "RemoteMemoryView.hpp"
+#include <string.h>
+#include "Utils/SystemCalls.hpp"
+
+#define ELF_CLASS_64 2
+#define ELF_DATA_MSB 2
+#define ELF_PT_LOAD 1
+#define ELF_PT_PROC_PRX_PARAM 0x60000002
+#define ELF_PF_X 1
+#define ELF_MAX_PROGRAM_HEADERS 32
+
+struct Elf64Header
+{
+    uint8_t ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct Elf64ProgramHeader
+{
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+};
+
+#define PRX_PARAM_MAGIC 0x1b434cec
+#define PRX_IMPORT_NAME_MAX 32
+
+// What PT_PROC_PRX_PARAM points to, the library tables of the image
+struct PrxParam
+{
+    uint32_t size;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sdkVersion;
+    uint32_t libentStart;
+    uint32_t libentEnd;
+    uint32_t libstubStart;
+    uint32_t libstubEnd;
+};
+
+// importStub_s as it is in memory, with 32 bit addresses whatever the pointer size
+struct PrxImportStub
+{
+    uint8_t size;
+    uint8_t unknown;
+    uint16_t version;
+    uint16_t attributes;
+    uint16_t functions;
+    uint16_t variables;
+    uint16_t tlsVariables;
+    uint32_t hashInfo;
+    uint32_t name;
+    uint32_t fnids;
+    uint32_t stubs;
+};
+
+// Header and program headers of the image, false when it isn't a big endian ELF64
+static bool ReadProgramHeaders(RemoteMemoryView& view, uintptr_t image, Elf64ProgramHeader* programHeaders, uint16_t* count)
+{
+    Elf64Header header;
+    if (!view.Read(image, &header, sizeof(header)))
+    {
+        return false;
+    }
+    if (header.ident[0] != 0x7f || header.ident[1] != 'E' || header.ident[2] != 'L' || header.ident[3] != 'F' ||
+        header.ident[4] != ELF_CLASS_64 || header.ident[5] != ELF_DATA_MSB ||
+        header.phentsize != sizeof(Elf64ProgramHeader) || header.phnum == 0 || header.phnum > ELF_MAX_PROGRAM_HEADERS)
+    {
+        return false;
+    }
+    *count = header.phnum;
+    return view.Read(image + (uint32_t)header.phoff, programHeaders, sizeof(Elf64ProgramHeader) * header.phnum);
+}
+
+extern "C"
+{
+size_t ElfCodeSegments(uint32_t pid, uintptr_t image, CodeSegment* segments, size_t max)
+{
+    // the program headers follow the elf header, usually one page read covers both
+    RemoteMemoryView view(pid, 0x400, 1);
+    Elf64ProgramHeader programHeaders[ELF_MAX_PROGRAM_HEADERS];
+    uint16_t programHeaderCount = 0;
+    if (!ReadProgramHeaders(view, image, programHeaders, &programHeaderCount))
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (uint16_t i = 0; i < programHeaderCount && count < max; i++)
+    {
+        const Elf64ProgramHeader& ph = programHeaders[i];
+        if (ph.type == ELF_PT_LOAD && (ph.flags & ELF_PF_X) && ph.memsz)
+        {
+            segments[count].base = (uint32_t)ph.vaddr;
+            segments[count].size = (uint32_t)ph.memsz;
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t PrxCodeSegments(uint32_t pid, uint32_t prx_id, CodeSegment* segments, size_t max)
+{
+    sys_prx_segment_info_t prxSegments[4];
+    sys_prx_module_info_t info;
+    memset(prxSegments, 0, sizeof(prxSegments));
+    memset(&info, 0, sizeof(info));
+    info.size = sizeof(info);
+    info.segments = (sys_addr_t)prxSegments;
+    info.segments_num = 4;
+    if (!max || ps3mapi_get_process_module_segments(pid, prx_id, &info) != 0)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < info.segments_num && i < 4; i++)
+    {
+        if (prxSegments[i].type == ELF_PT_LOAD && prxSegments[i].memsz)
+        {
+            segments[0].base = (uint32_t)prxSegments[i].base;
+            segments[0].size = (uint32_t)prxSegments[i].memsz;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t ElfImportOpd(uint32_t pid, uintptr_t image, const char* module, uint32_t fnid)
+{
+    RemoteMemoryView view(pid, 0x400, 2);
+    Elf64ProgramHeader programHeaders[ELF_MAX_PROGRAM_HEADERS];
+    uint16_t programHeaderCount = 0;
+    if (!module || !ReadProgramHeaders(view, image, programHeaders, &programHeaderCount))
+    {
+        return 0;
+    }
+
+    PrxParam param;
+    memset(&param, 0, sizeof(param));
+    for (uint16_t i = 0; i < programHeaderCount; i++)
+    {
+        if (programHeaders[i].type == ELF_PT_PROC_PRX_PARAM && programHeaders[i].filesz >= sizeof(param))
+        {
+            view.Read((uint32_t)programHeaders[i].vaddr, &param, sizeof(param));
+            break;
+        }
+    }
+    if (param.magic != PRX_PARAM_MAGIC || param.libstubEnd < param.libstubStart)
+    {
+        return 0;
+    }
+
+    const size_t moduleLength = strlen(module) + 1;
+    PrxImportStub stub;
+    for (uint32_t address = param.libstubStart; address + sizeof(stub) <= param.libstubEnd; address += stub.size)
+    {
+        if (!view.Read(address, &stub, sizeof(stub)) || stub.size < sizeof(stub))
+        {
+            return 0;
+        }
+
+        char name[PRX_IMPORT_NAME_MAX];
+        if (moduleLength > sizeof(name) || !view.Read(stub.name, name, moduleLength) || memcmp(name, module, moduleLength) != 0)
+        {
+            continue;
+        }
+        for (uint16_t i = 0; i < stub.functions; i++)
+        {
+            uint32_t entry = 0;
+            if (!view.Read(stub.fnids + i * sizeof(uint32_t), &entry, sizeof(entry)))
+            {
+                return 0;
+            }
+            if (entry == fnid)
+            {
+                // the loader wrote the opd of the export into the stub slot
+                uint32_t opd = 0;
+                view.Read(stub.stubs + i * sizeof(uint32_t), &opd, sizeof(opd));
+                return opd;
+            }
+        }
+    }
+    return 0;
+}
+
+uintptr_t SignatureScanSegments(uint32_t pid, const CodeSegment* segments, size_t count, const Signature* signature)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const uintptr_t found = SignatureScan(pid, segments[i].base, segments[i].size, signature);
+        if (found)
+        {
+            return found;
+        }
+    }
+    return 0;
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "SignatureScan.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#define CODE_SEGMENTS_MAX 8
+
+typedef struct
+{
+    uint32_t base;
+    uint32_t size;
+} CodeSegment;
+
+// Executable PT_LOAD segments listed by the ELF64 program headers of the image mapped at `image`
+// (0x10000 for the main executable). Returns how many were written to segments.
+size_t ElfCodeSegments(uint32_t pid, uintptr_t image, CodeSegment* segments, size_t max);
+
+// Code segment of a loaded PRX. Its headers aren't mapped, the module segments only carry the
+// segment type, so the first loaded segment (text, by PRX layout) is the one returned.
+size_t PrxCodeSegments(uint32_t pid, uint32_t prx_id, CodeSegment* segments, size_t max);
+
+// opd the image's import of module/fnid was linked to, found through the libstub table its
+// PT_PROC_PRX_PARAM header points to. Works for any executable, not only vsh.self. 0 when the
+// image doesn't import the function.
+uint32_t ElfImportOpd(uint32_t pid, uintptr_t image, const char* module, uint32_t fnid);
+
+// SignatureScan over each segment in turn, the first match wins
+uintptr_t SignatureScanSegments(uint32_t pid, const CodeSegment* segments, size_t count, const Signature* signature);
+
+#if defined(__cplusplus)
+}
+#endif
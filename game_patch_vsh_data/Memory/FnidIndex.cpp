@@ -0,0 +1,134 @@
+#include "FnidIndex.hpp"
+#include <string.h>
+#include "../../shared/stringid.h"
+
+#define FNID_INDEX_MIN_CAPACITY 64
+
+FnidIndex::FnidIndex()
+    : m_Entries(nullptr), m_Capacity(0)
+{
+    memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+FnidIndex::~FnidIndex()
+{
+    Clear();
+}
+
+void FnidIndex::Clear()
+{
+    delete[] m_Entries;
+    m_Entries = nullptr;
+    m_Capacity = 0;
+    memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+uint32_t FnidIndex::Slot(uint32_t kind, uint32_t module, uint32_t fnid) const
+{
+    // fnids are already hashes, mixing in the module is enough
+    uint32_t hash = (module ^ kind) * 0x9E3779B1 ^ fnid;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    return hash & (m_Capacity - 1);
+}
+
+void FnidIndex::Insert(uint32_t kind, uint32_t module, const char* name, uint32_t fnid, opd_s* opd)
+{
+    for (uint32_t slot = Slot(kind, module, fnid);; slot = (slot + 1) & (m_Capacity - 1))
+    {
+        Entry& entry = m_Entries[slot];
+        if (!entry.opd)
+        {
+            entry.module = module;
+            entry.fnid = fnid;
+            entry.kind = kind;
+            entry.name = name;
+            entry.opd = opd;
+            m_Stats.entries++;
+            return;
+        }
+        if (entry.module == module && entry.fnid == fnid && entry.kind == kind && !strcmp(entry.name, name))
+        {
+            return;
+        }
+    }
+}
+
+bool FnidIndex::Build(const exportStub_s* exports, const importStub_s* imports)
+{
+    Clear();
+
+    uint32_t count = 0;
+    for (const exportStub_s* stub = exports; stub && stub->ssize == 0x1C00; stub++)
+    {
+        count += stub->exports;
+    }
+    for (const importStub_s* stub = imports; stub && stub->ssize == 0x2C00; stub++)
+    {
+        count += stub->imports;
+    }
+
+    // at most half full keeps the probe runs short
+    uint32_t capacity = FNID_INDEX_MIN_CAPACITY;
+    while (capacity < count * 2)
+    {
+        capacity *= 2;
+    }
+    m_Entries = new Entry[capacity];
+    if (!m_Entries)
+    {
+        return false;
+    }
+    memset(m_Entries, 0, sizeof(Entry) * capacity);
+    m_Capacity = capacity;
+    m_Stats.capacity = capacity;
+
+    for (const exportStub_s* stub = exports; stub && stub->ssize == 0x1C00; stub++)
+    {
+        const uint32_t module = stringid(stub->name, 0);
+        for (int16_t i = 0; i < stub->exports; i++)
+        {
+            if (stub->stub[i])
+            {
+                Insert(Export, module, stub->name, stub->fnid[i], stub->stub[i]);
+            }
+        }
+    }
+    for (const importStub_s* stub = imports; stub && stub->ssize == 0x2C00; stub++)
+    {
+        const uint32_t module = stringid(stub->name, 0);
+        for (int16_t i = 0; i < stub->imports; i++)
+        {
+            if (stub->stub[i])
+            {
+                Insert(Import, module, stub->name, stub->fnid[i], stub->stub[i]);
+            }
+        }
+    }
+    return true;
+}
+
+opd_s* FnidIndex::Find(Kind kind, const char* module, uint32_t fnid)
+{
+    if (!m_Entries || !module)
+    {
+        return nullptr;
+    }
+
+    const uint32_t moduleHash = stringid(module, 0);
+    m_Stats.lookups++;
+    for (uint32_t slot = Slot(kind, moduleHash, fnid);; slot = (slot + 1) & (m_Capacity - 1))
+    {
+        const Entry& entry = m_Entries[slot];
+        m_Stats.probes++;
+        if (!entry.opd)
+        {
+            return nullptr;
+        }
+        if (entry.module == moduleHash && entry.fnid == fnid && entry.kind == (uint32_t)kind && !strcmp(entry.name, module))
+        {
+            return entry.opd;
+        }
+    }
+}
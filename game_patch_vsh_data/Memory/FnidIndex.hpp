@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "Memory.hpp"
+
+// (module, fnid) -> opd of the import and export stubs, filled once from the stub tables.
+// Open addressing with linear probing, every lookup after the build is a hash and a few compares.
+// Names are only compared on a full hash match, so colliding library names still find their own stubs.
+class FnidIndex
+{
+   public:
+    enum Kind
+    {
+        Import = 0,
+        Export = 1
+    };
+
+    struct Stats
+    {
+        uint32_t entries;
+        uint32_t capacity;
+        uint32_t lookups;
+        uint32_t probes;  // slots looked at by all lookups
+    };
+
+   public:
+    FnidIndex();
+    FnidIndex(FnidIndex const&) = delete;
+    FnidIndex& operator=(FnidIndex const&) = delete;
+    ~FnidIndex();
+
+    /***
+     * Indexes every stub of both tables, the first stub wins for duplicate fnids like a linear walk would.
+     * @param exports First export stub, the table ends at the first stub that isn't 0x1C00 bytes.
+     * @param imports First import stub, the table ends at the first stub that isn't 0x2C00 bytes.
+     * @returns false when there was no memory for the table
+     */
+    bool Build(const exportStub_s* exports, const importStub_s* imports);
+    void Clear();
+    bool IsBuilt() const { return m_Entries != nullptr; }
+
+    opd_s* Find(Kind kind, const char* module, uint32_t fnid);
+
+    const Stats& GetStats() const { return m_Stats; }
+
+   private:
+    struct Entry
+    {
+        uint32_t module;  // stringid() of the library name
+        uint32_t fnid;
+        uint32_t kind;
+        const char* name;  // library name of the stub, compared when the hashes match
+        opd_s* opd;  // nullptr for an empty slot
+    };
+
+    uint32_t Slot(uint32_t kind, uint32_t module, uint32_t fnid) const;
+    void Insert(uint32_t kind, uint32_t module, const char* name, uint32_t fnid, opd_s* opd);
+
+   private:
+    Entry* m_Entries;
+    uint32_t m_Capacity;  // power of two
+    Stats m_Stats;
+};
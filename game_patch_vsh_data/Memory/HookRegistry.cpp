@@ -0,0 +1,167 @@
+#include "HookRegistry.hpp"
+#include <string.h>
+
+#if defined(__PPU__)
+#define HOOK_REGISTRY_PUBLISH() __lwsync()
+#else
+#define HOOK_REGISTRY_PUBLISH() __sync_synchronize()
+#endif
+
+struct HookSite
+{
+    uintptr_t address;
+    Detour detour;
+    uint8_t* thunk;                 // calls *head with its toc
+    uint32_t thunkOpd[2];           // what the detour points the function to
+    const uint32_t* volatile head;  // opd of the first callback or the original function
+    HookCallback* first;
+    size_t count;
+};
+
+// per module, see HookRegistry.hpp
+static HookSite* s_Sites[HOOK_REGISTRY_MAX_SITES];
+
+HookSite* HookRegistry::FindSite(uintptr_t fnAddress, bool create)
+{
+    HookSite** free = nullptr;
+    for (size_t i = 0; i < HOOK_REGISTRY_MAX_SITES; i++)
+    {
+        if (s_Sites[i] && s_Sites[i]->address == fnAddress)
+        {
+            return s_Sites[i];
+        }
+        if (!s_Sites[i] && !free)
+        {
+            free = &s_Sites[i];
+        }
+    }
+    if (!create || !free)
+    {
+        return nullptr;
+    }
+
+    // never deleted, a call may still be in the thunk reading head
+    HookSite* site = new HookSite();
+    if (!site)
+    {
+        return nullptr;
+    }
+    site->address = fnAddress;
+    site->first = nullptr;
+    site->count = 0;
+    site->head = site->detour.GetOriginalOpd();
+    site->thunk = Detour::CreateIndirectCall((const void*)&site->head);
+    if (!site->thunk)
+    {
+        delete site;
+        return nullptr;
+    }
+    site->thunkOpd[0] = (uint32_t)(uintptr_t)site->thunk;
+    site->thunkOpd[1] = 0;
+    *free = site;
+    return site;
+}
+
+HookRegistry::Handle HookRegistry::Add(uintptr_t fnAddress, uintptr_t fnCallback, int32_t priority, uintptr_t tocOverride)
+{
+    HookSite* site = FindSite(fnAddress, true);
+    if (!site)
+    {
+        return nullptr;
+    }
+
+    HookCallback* callback = new HookCallback();
+    if (!callback)
+    {
+        return nullptr;
+    }
+    memcpy(callback->opd, (const void*)fnCallback, sizeof(callback->opd));
+    callback->priority = priority;
+    callback->site = site;
+    callback->active = true;
+
+    HookCallback* prev = nullptr;
+    HookCallback* cur = site->first;
+    while (cur && cur->priority >= priority)
+    {
+        prev = cur;
+        cur = cur->link;
+    }
+
+    // fully linked before anything can reach it
+    callback->link = cur;
+    callback->next = cur ? cur->opd : site->detour.GetOriginalOpd();
+    HOOK_REGISTRY_PUBLISH();
+    if (prev)
+    {
+        prev->link = callback;
+        prev->next = callback->opd;
+    }
+    else
+    {
+        site->first = callback;
+        site->head = callback->opd;
+    }
+    HOOK_REGISTRY_PUBLISH();
+    site->count++;
+
+    if (!site->detour.IsHooked())
+    {
+        site->detour.Hook(fnAddress, (uintptr_t)site->thunkOpd, tocOverride);
+        if (!site->detour.IsHooked())
+        {
+            Remove(callback);
+            return nullptr;
+        }
+    }
+    return callback;
+}
+
+bool HookRegistry::Remove(Handle handle)
+{
+    if (!handle || !handle->active)
+    {
+        return false;
+    }
+    HookSite* site = handle->site;
+
+    HookCallback* prev = nullptr;
+    HookCallback* cur = site->first;
+    while (cur && cur != handle)
+    {
+        prev = cur;
+        cur = cur->link;
+    }
+    if (!cur)
+    {
+        return false;
+    }
+
+    // the callback keeps its own next, a call already in it carries on down the list
+    if (prev)
+    {
+        prev->link = handle->link;
+        prev->next = handle->next;
+    }
+    else
+    {
+        site->first = handle->link;
+        site->head = handle->next;
+    }
+    HOOK_REGISTRY_PUBLISH();
+    handle->active = false;
+    site->count--;
+
+    if (!site->first && site->detour.IsHooked())
+    {
+        site->detour.UnHook();
+        site->head = site->detour.GetOriginalOpd();
+    }
+    return true;
+}
+
+size_t HookRegistry::GetCallbackCount(uintptr_t fnAddress)
+{
+    HookSite* site = FindSite(fnAddress, false);
+    return site ? site->count : 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "Detour.hpp"
+
+#define HOOK_REGISTRY_MAX_SITES 32
+
+struct HookSite;
+
+// One callback on a shared hook, stays allocated once added so calls running through it stay valid
+struct HookCallback
+{
+    uint32_t opd[2];                // the callback, what the callback before it calls
+    const uint32_t* volatile next;  // opd of the next callback or the original function
+    int32_t priority;
+    HookCallback* link;  // next in priority order, only used by Add and Remove
+    HookSite* site;
+    bool active;
+};
+
+// Every function hooked through the registry gets one Detour and one trampoline, no matter how
+// many callbacks are added. Callbacks run from the highest priority down, each calls the next
+// with CallNext and the last one reaches the original. A call only ever sees the list before or
+// after an Add/Remove since each is published with a single pointer store.
+// Add and Remove aren't meant to race each other, calls through the hook may run at any time.
+// The sites live in the module that links this, so sharing only works between callbacks of one PRX.
+// Another plugin hooking the same function, through its own registry or a plain Detour, stacks its
+// detour on top of this one like before.
+// The thunk calls the callbacks with the toc of their opd, arguments passed on the stack don't reach them.
+class HookRegistry
+{
+   public:
+    typedef HookCallback* Handle;
+
+    /***
+     * @param fnAddress The function to hook.
+     * @param fnCallback opd of the callback, same signature as the function.
+     * @param priority Higher runs first, equal priorities run in the order added.
+     * @param tocOverride toc of the original function, used by the first callback on the function.
+     * @returns handle for CallNext and Remove, nullptr on failure
+     */
+    static Handle Add(uintptr_t fnAddress, uintptr_t fnCallback, int32_t priority = 0, uintptr_t tocOverride = 0);
+
+    /***
+     * Unlinks the callback, the function is unhooked with its last one.
+     */
+    static bool Remove(Handle handle);
+
+    template <typename R, typename... TArgs>
+    static R CallNext(Handle handle, TArgs... args)
+    {
+        R (*next)(TArgs...) = (R(*)(TArgs...))handle->next;
+        return next(args...);
+    }
+
+    static size_t GetCallbackCount(uintptr_t fnAddress);
+
+   private:
+    static HookSite* FindSite(uintptr_t fnAddress, bool create);
+};
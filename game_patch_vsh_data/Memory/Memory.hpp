@@ -4,6 +4,7 @@
 #include <ppu_asm_intrinsics.h>  // __ALWAYS_INLINE
 #include <sys/process.h>
 #include "Utils/SystemCalls.hpp"
+#include "RemoteMemoryView.hpp"
 
 struct opd_s
 {
@@ -66,6 +67,20 @@ inline void VshSetMem(uint32_t address, T data)
     WriteProcessMemory(sys_process_getpid(), (void*)address, &data, sizeof(T));
 }
 
+// Through a view, for walking tables or setting several fields: neighbouring accesses share one
+// ReadProcessMemory per page, and writes go out together on view.Commit().
+template <typename T>
+inline T VshGetMem(RemoteMemoryView& view, uint32_t address)
+{
+    return view.Get<T>(address);
+}
+
+template <typename T>
+inline void VshSetMem(RemoteMemoryView& view, uint32_t address, T data)
+{
+    view.Set<T>(address, data);
+}
+
 template <typename R, typename... Args>
 __ALWAYS_INLINE R CallByAddr(uint32_t addr, Args... args)
 {
@@ -74,10 +89,11 @@ __ALWAYS_INLINE R CallByAddr(uint32_t addr, Args... args)
     return fn(args...);
 }
 
+// Calls through a copy of the opd, returns 0 without calling when the function or toc is unset
 template <typename R, typename... Args>
 __ALWAYS_INLINE R CallByOpd(opd_s opd, Args... args)
 {
-    if (opd.sub && opd.toc)
+    if (opd.func && opd.toc)
     {
         R (*fn)(Args...) = (R(*)(Args...))&opd;
         return fn(args...);
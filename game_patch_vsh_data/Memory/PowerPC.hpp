@@ -0,0 +1,327 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Typed PowerPC instruction encoders. Where the result is needed as a constant expression
+// (POWERPC_CONSTANT, static_assert) bad operands like out of range branches and misaligned
+// offsets fail to compile. Anywhere else they encode 0 at runtime. SNC has no constexpr, there
+// the encoders are plain inline functions and nothing is checked before the code runs.
+
+#if !defined(__SNC__)
+#define POWERPC_CONSTEXPR constexpr
+#define POWERPC_CONSTANT constexpr
+#else
+#define POWERPC_CONSTEXPR inline
+#define POWERPC_CONSTANT const
+#endif
+
+enum class PowerPCRegister : uint8_t
+{
+    R0 = 0,
+    R1,
+    R2,
+    R3,
+    R4,
+    R5,
+    R6,
+    R7,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+    R16,
+    R17,
+    R18,
+    R19,
+    R20,
+    R21,
+    R22,
+    R23,
+    R24,
+    R25,
+    R26,
+    R27,
+    R28,
+    R29,
+    R30,
+    R31,
+    SP = 1,
+    RTOC = 2
+};
+
+enum PowerPCOpcode : uint32_t
+{
+    PowerPCOpcodeAddi = 14u << 26,
+    PowerPCOpcodeAddis = 15u << 26,
+    PowerPCOpcodeBc = 16u << 26,
+    PowerPCOpcodeB = 18u << 26,
+    PowerPCOpcodeBcctr = 19u << 26,
+    PowerPCOpcodeOri = 24u << 26,
+    PowerPCOpcodeExtended = 31u << 26,
+    PowerPCOpcodeLwz = 32u << 26,
+    PowerPCOpcodeStw = 36u << 26,
+    PowerPCOpcodeLd = 58u << 26,
+    PowerPCOpcodeStd = 62u << 26,
+    PowerPCOpcodeMask = 63u << 26
+};
+
+// Branch related fields.
+#define POWERPC_BRANCH_LINKED 1
+#define POWERPC_BRANCH_ABSOLUTE 2
+#define POWERPC_BRANCH_OPTIONS_ALWAYS 20
+#define POWERPC_SPR_LR 8
+#define POWERPC_SPR_CTR 9
+
+// Not constexpr on purpose, reaching it while evaluating a constant expression stops the compile.
+// At runtime the instruction becomes 0, which traps instead of branching somewhere wrong.
+inline uint32_t PowerPCInvalidOperand()
+{
+    return 0;
+}
+
+// PowerPC most significant bit is addressed as bit 0 in documentation.
+POWERPC_CONSTEXPR uint32_t PowerPCField(uint32_t value, uint32_t lastBit)
+{
+    return value << (31 - lastBit);
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCReg(PowerPCRegister reg, uint32_t lastBit)
+{
+    return PowerPCField((uint32_t)reg, lastBit);
+}
+
+POWERPC_CONSTEXPR uint16_t PowerPCHi(uint32_t value)
+{
+    return (uint16_t)(value >> 16);
+}
+
+POWERPC_CONSTEXPR uint16_t PowerPCLo(uint32_t value)
+{
+    return (uint16_t)(value & 0xFFFF);
+}
+
+// High half when the low half is used as a signed offset
+POWERPC_CONSTEXPR uint16_t PowerPCHa(uint32_t value)
+{
+    return (uint16_t)((value + 0x8000) >> 16);
+}
+
+// Signed `bits` wide byte offset, word aligned
+POWERPC_CONSTEXPR bool PowerPCBranchInRange(int32_t offset, uint32_t bits)
+{
+    return (offset & 3) == 0 && offset >= -(1 << (bits - 1)) && offset < (1 << (bits - 1));
+}
+
+// rD - Destination register.
+// rS - Source register.
+// rA - Register input, r0 reads as 0 for addi/addis and loads.
+// UIMM/SIMM - Unsigned/signed immediate.
+POWERPC_CONSTEXPR uint32_t PowerPCAddi(PowerPCRegister rD, PowerPCRegister rA, int16_t simm)
+{
+    return PowerPCOpcodeAddi | PowerPCReg(rD, 10) | PowerPCReg(rA, 15) | (uint16_t)simm;
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCAddis(PowerPCRegister rD, PowerPCRegister rA, uint16_t simm)
+{
+    return PowerPCOpcodeAddis | PowerPCReg(rD, 10) | PowerPCReg(rA, 15) | simm;
+}
+
+// addi %rD, 0, SIMM
+POWERPC_CONSTEXPR uint32_t PowerPCLi(PowerPCRegister rD, int16_t simm)
+{
+    return PowerPCAddi(rD, PowerPCRegister::R0, simm);
+}
+
+// addis %rD, 0, SIMM
+POWERPC_CONSTEXPR uint32_t PowerPCLis(PowerPCRegister rD, uint16_t simm)
+{
+    return PowerPCAddis(rD, PowerPCRegister::R0, simm);
+}
+
+// ori %rA, %rS, UIMM
+POWERPC_CONSTEXPR uint32_t PowerPCOri(PowerPCRegister rA, PowerPCRegister rS, uint16_t uimm)
+{
+    return PowerPCOpcodeOri | PowerPCReg(rS, 10) | PowerPCReg(rA, 15) | uimm;
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCLwz(PowerPCRegister rD, int16_t d, PowerPCRegister rA)
+{
+    return PowerPCOpcodeLwz | PowerPCReg(rD, 10) | PowerPCReg(rA, 15) | (uint16_t)d;
+}
+
+// DS form, the offset has to be a multiple of 4
+POWERPC_CONSTEXPR uint32_t PowerPCLd(PowerPCRegister rD, int16_t ds, PowerPCRegister rA)
+{
+    return (ds & 3) ? PowerPCInvalidOperand() : PowerPCOpcodeLd | PowerPCReg(rD, 10) | PowerPCReg(rA, 15) | (uint16_t)ds;
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCStd(PowerPCRegister rS, int16_t ds, PowerPCRegister rA)
+{
+    return (ds & 3) ? PowerPCInvalidOperand() : PowerPCOpcodeStd | PowerPCReg(rS, 10) | PowerPCReg(rA, 15) | (uint16_t)ds;
+}
+
+// std with update, pushes a stack frame as stdu %r1, -size(%r1)
+POWERPC_CONSTEXPR uint32_t PowerPCStdu(PowerPCRegister rS, int16_t ds, PowerPCRegister rA)
+{
+    return (ds & 3) ? PowerPCInvalidOperand() : PowerPCOpcodeStd | PowerPCReg(rS, 10) | PowerPCReg(rA, 15) | (uint16_t)ds | 1;
+}
+
+// SPR field is encoded as two 5 bit bitfields.
+POWERPC_CONSTEXPR uint32_t PowerPCMtspr(uint32_t spr, PowerPCRegister rS)
+{
+    return PowerPCOpcodeExtended | PowerPCReg(rS, 10) | PowerPCField(((spr & 0x1F) << 5) | ((spr >> 5) & 0x1F), 20) | (467 << 1);
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCMtctr(PowerPCRegister rS)
+{
+    return PowerPCMtspr(POWERPC_SPR_CTR, rS);
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCMtlr(PowerPCRegister rS)
+{
+    return PowerPCMtspr(POWERPC_SPR_LR, rS);
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCMflr(PowerPCRegister rD)
+{
+    return PowerPCOpcodeExtended | PowerPCReg(rD, 10) | PowerPCField(POWERPC_SPR_LR << 5, 20) | (339 << 1);
+}
+
+// bcctr 20, 0 == bctr
+POWERPC_CONSTEXPR uint32_t PowerPCBcctr(uint32_t branchOptions, uint32_t conditionRegisterBit, bool linked)
+{
+    return PowerPCOpcodeBcctr | PowerPCField(branchOptions & 0x1F, 10) | PowerPCField(conditionRegisterBit & 0x1F, 15) | (528 << 1) | (linked ? POWERPC_BRANCH_LINKED : 0);
+}
+
+// bclr 20, 0 == blr
+POWERPC_CONSTEXPR uint32_t PowerPCBlr()
+{
+    return PowerPCOpcodeBcctr | PowerPCField(POWERPC_BRANCH_OPTIONS_ALWAYS, 10) | (16 << 1);
+}
+
+// b/bl, 26 bit signed offset from the instruction
+POWERPC_CONSTEXPR uint32_t PowerPCB(int32_t offset, bool linked)
+{
+    return !PowerPCBranchInRange(offset, 26) ? PowerPCInvalidOperand() : PowerPCOpcodeB | ((uint32_t)offset & 0x03FFFFFC) | (linked ? POWERPC_BRANCH_LINKED : 0);
+}
+
+// bc/bcl, 16 bit signed offset from the instruction
+POWERPC_CONSTEXPR uint32_t PowerPCBc(uint32_t branchOptions, uint32_t conditionRegisterBit, int32_t offset, bool linked)
+{
+    return !PowerPCBranchInRange(offset, 16) ? PowerPCInvalidOperand()
+                                             : PowerPCOpcodeBc | PowerPCField(branchOptions & 0x1F, 10) | PowerPCField(conditionRegisterBit & 0x1F, 15) | ((uint32_t)offset & 0xFFFC) | (linked ? POWERPC_BRANCH_LINKED : 0);
+}
+
+// Sign extended byte offset of a relative b or bc
+POWERPC_CONSTEXPR int32_t PowerPCBranchOffset(uint32_t instruction)
+{
+    return (instruction & PowerPCOpcodeMask) == PowerPCOpcodeB ? (int32_t)((instruction & 0x03FFFFFC) ^ 0x02000000) - 0x02000000
+                                                               : (int32_t)((instruction & 0xFFFC) ^ 0x8000) - 0x8000;
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCBranchOptions(uint32_t instruction)
+{
+    return (instruction & PowerPCOpcodeMask) == PowerPCOpcodeB ? POWERPC_BRANCH_OPTIONS_ALWAYS : (instruction >> (31 - 10)) & 0x1F;
+}
+
+POWERPC_CONSTEXPR uint32_t PowerPCConditionRegisterBit(uint32_t instruction)
+{
+    return (instruction & PowerPCOpcodeMask) == PowerPCOpcodeB ? 0 : (instruction >> (31 - 15)) & 0x1F;
+}
+
+// Far branch through the count register to any 32 bit address:
+//   std   %rX, -0x30(%r1)   (Preserve)
+//   lis   %rX, target@hi
+//   ori   %rX, %rX, target@lo
+//   mtctr %rX
+//   ld    %rX, -0x30(%r1)   (Preserve)
+//   bcctr BO, BI
+template <bool Preserve>
+struct PowerPCFarJump
+{
+    static const size_t Count = Preserve ? 6 : 4;
+    static const size_t Size = Count * sizeof(uint32_t);
+
+    static size_t Encode(uint32_t* out, uint32_t target, PowerPCRegister reg, uint32_t branchOptions, uint32_t conditionRegisterBit, bool linked)
+    {
+        size_t i = 0;
+        if (Preserve)
+        {
+            out[i++] = PowerPCStd(reg, -0x30, PowerPCRegister::R1);
+        }
+        out[i++] = PowerPCLis(reg, PowerPCHi(target));
+        out[i++] = PowerPCOri(reg, reg, PowerPCLo(target));
+        out[i++] = PowerPCMtctr(reg);
+        if (Preserve)
+        {
+            out[i++] = PowerPCLd(reg, -0x30, PowerPCRegister::R1);
+        }
+        out[i++] = PowerPCBcctr(branchOptions, conditionRegisterBit, linked);
+        return Size;
+    }
+};
+
+// Calls the function of the opd *slot points to when it runs, with the toc of that opd.
+// The caller's r2 is saved in a frame of its own and restored on the way back, r0 and r12 are clobbered:
+//   mflr  %r0
+//   std   %r0, 0x10(%r1)
+//   stdu  %r1, -0x80(%r1)
+//   std   %r2, 0x70(%r1)
+//   lis   %r12, slot@ha
+//   lwz   %r12, slot@l(%r12)
+//   lwz   %r0, 0(%r12)
+//   lwz   %r2, 4(%r12)
+//   mtctr %r0
+//   bctrl
+//   ld    %r2, 0x70(%r1)
+//   addi  %r1, %r1, 0x80
+//   ld    %r0, 0x10(%r1)
+//   mtlr  %r0
+//   blr
+// Arguments past the ones passed in registers aren't forwarded, the callee would look for them in this frame.
+struct PowerPCIndirectCall
+{
+    static const size_t Count = 15;
+    static const size_t Size = Count * sizeof(uint32_t);
+    static const int16_t FrameSize = 0x80;
+    static const int16_t TocSave = 0x70;  // past the 0x70 bytes of linkage and parameter area the callee may use
+
+    static size_t Encode(uint32_t* out, uint32_t slot)
+    {
+        // only the slot changes, everything else is checked and folded where constexpr is available
+        POWERPC_CONSTANT uint32_t Prologue[] = {
+            PowerPCMflr(PowerPCRegister::R0),
+            PowerPCStd(PowerPCRegister::R0, 0x10, PowerPCRegister::SP),
+            PowerPCStdu(PowerPCRegister::SP, -FrameSize, PowerPCRegister::SP),
+            PowerPCStd(PowerPCRegister::RTOC, TocSave, PowerPCRegister::SP),
+        };
+        POWERPC_CONSTANT uint32_t Epilogue[] = {
+            PowerPCLwz(PowerPCRegister::R0, 0, PowerPCRegister::R12),
+            PowerPCLwz(PowerPCRegister::RTOC, 4, PowerPCRegister::R12),
+            PowerPCMtctr(PowerPCRegister::R0),
+            PowerPCBcctr(POWERPC_BRANCH_OPTIONS_ALWAYS, 0, true),
+            PowerPCLd(PowerPCRegister::RTOC, TocSave, PowerPCRegister::SP),
+            PowerPCAddi(PowerPCRegister::SP, PowerPCRegister::SP, FrameSize),
+            PowerPCLd(PowerPCRegister::R0, 0x10, PowerPCRegister::SP),
+            PowerPCMtlr(PowerPCRegister::R0),
+            PowerPCBlr(),
+        };
+
+        size_t i = 0;
+        for (size_t j = 0; j < sizeof(Prologue) / sizeof(Prologue[0]); j++)
+        {
+            out[i++] = Prologue[j];
+        }
+        out[i++] = PowerPCLis(PowerPCRegister::R12, PowerPCHa(slot));
+        out[i++] = PowerPCLwz(PowerPCRegister::R12, (int16_t)PowerPCLo(slot), PowerPCRegister::R12);
+        for (size_t j = 0; j < sizeof(Epilogue) / sizeof(Epilogue[0]); j++)
+        {
+            out[i++] = Epilogue[j];
+        }
+        return Size;
+    }
+};
@@ -0,0 +1,176 @@
+#include "RemoteMemoryView.hpp"
+#include <string.h>
+
+RemoteMemoryView::RemoteMemoryView(uint32_t pid, uint32_t pageSize, uint32_t pageCount)
+    : m_Pid(pid), m_PageSize(pageSize), m_PageCount(pageCount), m_Clock(0)
+{
+    memset(&m_Stats, 0, sizeof(m_Stats));
+    m_Pages = new Page[m_PageCount];
+    m_Buffer = new uint8_t[m_PageSize * m_PageCount];
+    for (uint32_t i = 0; i < m_PageCount; i++)
+    {
+        memset(&m_Pages[i], 0, sizeof(Page));
+        m_Pages[i].data = m_Buffer ? &m_Buffer[i * m_PageSize] : nullptr;
+    }
+}
+
+RemoteMemoryView::~RemoteMemoryView()
+{
+    Commit();
+    delete[] m_Pages;
+    delete[] m_Buffer;
+}
+
+RemoteMemoryView::Page* RemoteMemoryView::Fetch(uint32_t base)
+{
+    Page* victim = nullptr;
+    for (uint32_t i = 0; i < m_PageCount; i++)
+    {
+        Page& page = m_Pages[i];
+        if (page.valid && page.base == base)
+        {
+            page.lastUse = ++m_Clock;
+            m_Stats.hits++;
+            return &page;
+        }
+        // an empty page wins, otherwise the least recently used one
+        if (!victim || (victim->valid && (!page.valid || page.lastUse < victim->lastUse)))
+        {
+            victim = &page;
+        }
+    }
+
+    m_Stats.misses++;
+    if (!victim || !victim->data || !Flush(*victim))
+    {
+        return nullptr;
+    }
+
+    victim->valid = false;
+    m_Stats.reads++;
+    if (ReadProcessMemory(m_Pid, (void*)base, victim->data, m_PageSize) != 0)
+    {
+        return nullptr;
+    }
+    victim->base = base;
+    victim->valid = true;
+    victim->dirtyStart = victim->dirtyEnd = 0;
+    victim->lastUse = ++m_Clock;
+    return victim;
+}
+
+bool RemoteMemoryView::Flush(Page& page)
+{
+    if (!page.valid || page.dirtyStart == page.dirtyEnd)
+    {
+        return true;
+    }
+
+    m_Stats.writes++;
+    const bool okay = WriteProcessMemory(m_Pid, (void*)(page.base + page.dirtyStart), &page.data[page.dirtyStart], page.dirtyEnd - page.dirtyStart) == 0;
+    page.dirtyStart = page.dirtyEnd = 0;
+    return okay;
+}
+
+bool RemoteMemoryView::Read(uint32_t address, void* data, size_t size)
+{
+    uint8_t* out = static_cast<uint8_t*>(data);
+    while (size)
+    {
+        const uint32_t base = address & ~(m_PageSize - 1);
+        const uint32_t offset = address - base;
+        const uint32_t len = (m_PageSize - offset) < size ? (m_PageSize - offset) : size;
+
+        Page* page = Fetch(base);
+        if (page)
+        {
+            memcpy(out, &page->data[offset], len);
+        }
+        else
+        {
+            // the whole page isn't readable, the asked bytes may still be
+            m_Stats.reads++;
+            if (ReadProcessMemory(m_Pid, (void*)address, out, len) != 0)
+            {
+                return false;
+            }
+        }
+
+        address += len;
+        out += len;
+        size -= len;
+    }
+    return true;
+}
+
+bool RemoteMemoryView::Write(uint32_t address, const void* data, size_t size)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    while (size)
+    {
+        const uint32_t base = address & ~(m_PageSize - 1);
+        const uint32_t offset = address - base;
+        const uint32_t len = (m_PageSize - offset) < size ? (m_PageSize - offset) : size;
+
+        Page* page = Fetch(base);
+        if (page)
+        {
+            memcpy(&page->data[offset], in, len);
+            if (page->dirtyStart == page->dirtyEnd)
+            {
+                page->dirtyStart = offset;
+                page->dirtyEnd = offset + len;
+            }
+            else
+            {
+                page->dirtyStart = offset < page->dirtyStart ? offset : page->dirtyStart;
+                page->dirtyEnd = offset + len > page->dirtyEnd ? offset + len : page->dirtyEnd;
+            }
+        }
+        else
+        {
+            m_Stats.writes++;
+            if (WriteProcessMemory(m_Pid, (void*)address, in, len) != 0)
+            {
+                return false;
+            }
+        }
+
+        address += len;
+        in += len;
+        size -= len;
+    }
+    return true;
+}
+
+bool RemoteMemoryView::Commit()
+{
+    bool okay = true;
+    for (uint32_t i = 0; i < m_PageCount; i++)
+    {
+        okay = Flush(m_Pages[i]) && okay;
+    }
+    return okay;
+}
+
+void RemoteMemoryView::Invalidate(uint32_t address, size_t size)
+{
+    for (uint32_t i = 0; i < m_PageCount; i++)
+    {
+        Page& page = m_Pages[i];
+        if (page.valid && page.base < address + size && address < page.base + m_PageSize)
+        {
+            Flush(page);
+            page.valid = false;
+        }
+    }
+}
+
+void RemoteMemoryView::InvalidateAll()
+{
+    Commit();
+    for (uint32_t i = 0; i < m_PageCount; i++)
+    {
+        m_Pages[i].valid = false;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "Memory.h"
+
+// Reads another process (or our own through sys_dbg/PS3MAPI) a page at a time.
+// Writes land in the cached page and go out on Commit(), one WriteProcessMemory per dirty span.
+class RemoteMemoryView
+{
+   public:
+    struct Stats
+    {
+        uint32_t reads;   // ReadProcessMemory calls
+        uint32_t writes;  // WriteProcessMemory calls
+        uint32_t hits;
+        uint32_t misses;
+    };
+
+   public:
+    /***
+     * @param pid Process to access.
+     * @param pageSize Bytes fetched per miss, power of two.
+     * @param pageCount Pages kept, the least recently used one is evicted.
+     */
+    RemoteMemoryView(uint32_t pid, uint32_t pageSize = 0x400, uint32_t pageCount = 4);
+    RemoteMemoryView(RemoteMemoryView const&) = delete;
+    RemoteMemoryView& operator=(RemoteMemoryView const&) = delete;
+    ~RemoteMemoryView();
+
+    bool Read(uint32_t address, void* data, size_t size);
+    bool Write(uint32_t address, const void* data, size_t size);
+
+    // Flushes buffered writes, pages stay cached.
+    bool Commit();
+    // Drops cached pages overlapping the range, for memory written behind our back. Pending writes there are flushed first.
+    void Invalidate(uint32_t address, size_t size);
+    void InvalidateAll();
+
+    const Stats& GetStats() const { return m_Stats; }
+
+    template <typename T>
+    T Get(uint32_t address)
+    {
+        T data;
+        Read(address, &data, sizeof(T));
+        return data;
+    }
+
+    template <typename T>
+    bool Set(uint32_t address, T data)
+    {
+        return Write(address, &data, sizeof(T));
+    }
+
+   private:
+    struct Page
+    {
+        uint32_t base;
+        uint32_t lastUse;
+        uint32_t dirtyStart;
+        uint32_t dirtyEnd;  // == dirtyStart when clean
+        bool valid;
+        uint8_t* data;
+    };
+
+    Page* Fetch(uint32_t base);
+    bool Flush(Page& page);
+
+   private:
+    uint32_t m_Pid;
+    uint32_t m_PageSize;
+    uint32_t m_PageCount;
+    uint32_t m_Clock;
+    Page* m_Pages;
+    uint8_t* m_Buffer;
+    Stats m_Stats;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "SignatureScan.h"
+#include "SignatureSkip.hpp"
+
+// IDA style signatures, "80 1F 00 08 ?? ?? 4? 9E". `??` or `?` is a wildcard byte, `4?` only compares the high nibble.
+// With constexpr the bytes, mask and skip table are built by the compiler. The console build (SNC, Cpp11)
+// has no constexpr: the same code runs when the function local static is first reached, once per signature,
+// and SignatureCompilerCheck is there to run against the tables the constexpr build gives.
+//
+//     SIGNATURE_STORAGE auto search = CompileSignature("80 1F 00 08 ?? ?? ?? ??");
+//     const Signature signature = search.Get(20);
+
+#if defined(SIGNATURE_COMPILE_TIME)
+#define SIGNATURE_STORAGE static constexpr
+#else
+#define SIGNATURE_STORAGE static const
+#endif
+
+template <size_t Capacity>
+struct CompiledSignature
+{
+    uint8_t bytes[Capacity];
+    uint8_t mask[Capacity];
+    uint32_t size;
+    SignatureSkip skip;
+
+    Signature Get(int32_t offset = 0) const
+    {
+        Signature signature = {bytes, mask, size, offset, &skip};
+        return signature;
+    }
+};
+
+// Not constexpr on purpose, reaching it stops compile time evaluation with an error
+inline uint32_t SignatureSyntaxError()
+{
+    return 0;
+}
+
+// 0xff for anything that isn't a hex digit
+SIGNATURE_CONSTEXPR uint8_t SignatureNibble(char c)
+{
+    return (c >= '0' && c <= '9') ? (uint8_t)(c - '0')
+         : (c >= 'a' && c <= 'f') ? (uint8_t)(c - 'a' + 10)
+         : (c >= 'A' && c <= 'F') ? (uint8_t)(c - 'A' + 10)
+                                  : 0xff;
+}
+
+// Parses `length` characters of text. Returns the byte count, 0 when the text is malformed or too long.
+SIGNATURE_CONSTEXPR uint32_t ParseSignatureText(const char* text, size_t length, uint8_t* bytes, uint8_t* mask, size_t capacity)
+{
+    uint32_t size = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        if (text[i] == ' ')
+        {
+            i++;
+            continue;
+        }
+        if (size == capacity)
+        {
+            return SignatureSyntaxError();
+        }
+
+        // "?" alone is a whole wildcard byte like "??"
+        if (text[i] == '?' && (i + 1 >= length || text[i + 1] == ' '))
+        {
+            bytes[size] = 0;
+            mask[size] = 0;
+            size++;
+            i++;
+            continue;
+        }
+        if (i + 1 >= length || text[i + 1] == ' ')
+        {
+            return SignatureSyntaxError();
+        }
+
+        uint8_t value = 0;
+        uint8_t nibbleMask = 0;
+        for (size_t nibble = 0; nibble < 2; nibble++)
+        {
+            const char c = text[i + nibble];
+            value <<= 4;
+            nibbleMask <<= 4;
+            if (c != '?')
+            {
+                const uint8_t digit = SignatureNibble(c);
+                if (digit == 0xff)
+                {
+                    return SignatureSyntaxError();
+                }
+                value |= digit;
+                nibbleMask |= 0xf;
+            }
+        }
+        bytes[size] = value;
+        mask[size] = nibbleMask;
+        size++;
+        i += 2;
+    }
+    return size;
+}
+
+// Every byte takes at least two characters with its separator
+template <size_t Length>
+SIGNATURE_CONSTEXPR CompiledSignature<Length / 2 + 1> CompileSignature(const char (&text)[Length])
+{
+    CompiledSignature<Length / 2 + 1> compiled{};
+    compiled.size = ParseSignatureText(text, Length - 1, compiled.bytes, compiled.mask, Length / 2 + 1);
+    PrepareSignatureSkip(compiled.bytes, compiled.mask, compiled.size, compiled.skip);
+    return compiled;
+}
+
+// What the constexpr build gives for one signature with a nibble mask, wildcards and trailing wildcards.
+// Evaluated at compile time wherever that is possible, at run time on SNC.
+SIGNATURE_CONSTEXPR bool SignatureCompilerCheck()
+{
+    const uint8_t bytes[] = {0x7c, 0x08, 0x02, 0xa6, 0x40, 0x00, 0xf8, 0x21, 0xff, 0x91, 0x38, 0x60, 0x00, 0x01, 0x00, 0x00};
+    const uint8_t mask[] = {0xff, 0xff, 0xff, 0xff, 0xf0, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00};
+    const uint8_t shiftBytes[] = {0x00, 0x21, 0x38, 0x60, 0x91, 0xf8, 0xff};
+    const uint32_t shifts[] = {1, 6, 3, 2, 4, 7, 5};
+    const uint32_t defaultShift = 8;
+
+    const auto compiled = CompileSignature("7C 08 02 A6 4? ?? F8 21 FF 91 38 60 00 01 ? ??");
+    if (compiled.size != sizeof(bytes) || compiled.skip.length != 14 || compiled.skip.rare != 1)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < sizeof(bytes); i++)
+    {
+        if (compiled.bytes[i] != bytes[i] || compiled.mask[i] != mask[i])
+        {
+            return false;
+        }
+    }
+    for (uint32_t value = 0; value < 256; value++)
+    {
+        uint32_t shift = defaultShift;
+        for (uint32_t i = 0; i < sizeof(shiftBytes); i++)
+        {
+            shift = shiftBytes[i] == value ? shifts[i] : shift;
+        }
+        if (compiled.skip.shift[value] != shift)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(SIGNATURE_COMPILE_TIME)
+static_assert(SignatureCompilerCheck(), "CompileSignature no longer builds the reference tables");
+#endif
@@ -0,0 +1,492 @@
+#include "SignatureScan.h"
+#include "SignatureCompiler.hpp"
+#include "Memory.h"
+#include <string.h>
+#if defined(__PPU__)
+#include <sys/ppu_thread.h>
+#else
+#include <pthread.h>
+#endif
+
+// VMX is on every PPU, SNC and ppu-gcc both take the AltiVec intrinsics.
+// Other builds can set SIGNATURE_VECTOR themselves when they provide <altivec.h>.
+#if !defined(SIGNATURE_VECTOR) && defined(__PPU__)
+#define SIGNATURE_VECTOR 1
+#endif
+#if defined(SIGNATURE_VECTOR)
+#include <altivec.h>
+#include <vec_types.h>
+#endif
+
+#define SIGNATURE_WINDOW_SIZE 0x10000
+
+static inline uint8_t SignatureMask(const Signature* signature, uint32_t index)
+{
+    return signature->mask ? signature->mask[index] : 0xff;
+}
+
+#if defined(SIGNATURE_VECTOR)
+// vec_ld only loads aligned quadwords, the two covering data are merged by vec_perm.
+// They are the blocks holding data[0] and data[15], so the load never reaches a page those bytes aren't on.
+static inline vec_uchar16 LoadVector(const uint8_t* data)
+{
+    const vec_uchar16 low = vec_ld(0, data);
+    const vec_uchar16 high = vec_ld(15, data);
+    return vec_perm(low, high, vec_lvsl(0, data));
+}
+
+// Masked compare of a whole signature, 16 bytes at a time
+static inline bool SignatureMatchesVector(const Signature* signature, const uint8_t* data)
+{
+    const vec_uchar16 zero = vec_splats((uint8_t)0);
+    uint32_t i = 0;
+    for (; i + 16 <= signature->size; i += 16)
+    {
+        vec_uchar16 diff = vec_xor(LoadVector(&data[i]), LoadVector(&signature->bytes[i]));
+        if (signature->mask)
+        {
+            diff = vec_and(diff, LoadVector(&signature->mask[i]));
+        }
+        if (vec_any_ne(diff, zero))
+        {
+            return false;
+        }
+    }
+    for (; i < signature->size; i++)
+    {
+        if ((data[i] ^ signature->bytes[i]) & SignatureMask(signature, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finds 16 candidates at a time by comparing against the rare byte, only lanes that hit get the full compare
+static size_t SignatureFindVector(const Signature* signature, const SignatureSkip* skip, const uint8_t* data, size_t size)
+{
+    const uint8_t rare = signature->bytes[skip->rare];
+    const uint8_t* candidates = &data[skip->rare];
+    const size_t count = size - signature->size + 1;
+    const vec_uchar16 needle = vec_splats(rare);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        if (!vec_any_eq(LoadVector(&candidates[i]), needle))
+        {
+            continue;
+        }
+        for (size_t lane = 0; lane < 16; lane++)
+        {
+            if (candidates[i + lane] == rare && SignatureMatchesVector(signature, &data[i + lane]))
+            {
+                return i + lane;
+            }
+        }
+    }
+    for (; i < count; i++)
+    {
+        if (candidates[i] == rare && SignatureMatchesVector(signature, &data[i]))
+        {
+            return i;
+        }
+    }
+    return SIGNATURE_NOT_FOUND;
+}
+#endif
+
+#define SIGNATURE_NO_ENTRY 0xffffffff
+
+// Batch scans bucket every signature by its anchor, the first fully compared byte pair
+// (or byte), so each position only visits the signatures that can start a match there.
+typedef struct
+{
+    uint32_t signature;
+    uint32_t anchor;  // index in the signature of the bucketed byte
+    uint32_t next;
+    uint8_t second;  // byte after the anchor
+    uint8_t secondMask;  // 0 when only the anchor byte is fully compared
+} SignatureEntry;
+
+static inline bool SignatureMatches(const Signature* signature, const uint8_t* data)
+{
+    for (uint32_t i = 0; i < signature->size; i++)
+    {
+        if ((data[i] ^ signature->bytes[i]) & SignatureMask(signature, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SignatureAnchor(const Signature* signature, uint32_t index, SignatureEntry* entry)
+{
+    entry->signature = index;
+    entry->next = SIGNATURE_NO_ENTRY;
+    entry->secondMask = 0;
+
+    uint32_t single = SIGNATURE_NO_ENTRY;
+    for (uint32_t i = 0; i < signature->size; i++)
+    {
+        if (SignatureMask(signature, i) != 0xff)
+        {
+            continue;
+        }
+        if (i + 1 < signature->size && SignatureMask(signature, i + 1) == 0xff)
+        {
+            entry->anchor = i;
+            entry->second = signature->bytes[i + 1];
+            entry->secondMask = 0xff;
+            return;
+        }
+        if (single == SIGNATURE_NO_ENTRY)
+        {
+            single = i;
+        }
+    }
+    entry->anchor = single;
+}
+
+#define SIGNATURE_SLICE_MIN_SIZE 0x40000
+#define SIGNATURE_SCAN_PRIORITY 1000
+#define SIGNATURE_SCAN_STACK_SIZE 0x2000
+
+// Scans [start, end) in windows overlapping by size - 1 bytes, so a match crossing a boundary is seen
+// whole in the next one. Gives up between windows once an earlier slice than `index` has a match.
+static uintptr_t ScanRange(uint32_t pid, uint64_t start, uint64_t end, const Signature* signature, const SignatureSkip* skip, volatile uint32_t* firstHit, uint32_t index)
+{
+    const uint32_t window = signature->size * 2 > SIGNATURE_WINDOW_SIZE ? signature->size * 2 : SIGNATURE_WINDOW_SIZE;
+    uint8_t* buffer = new uint8_t[window];
+    if (!buffer)
+    {
+        return 0;
+    }
+
+    uintptr_t found = 0;
+    for (uint64_t seek = start; seek + signature->size <= end; seek += window - (signature->size - 1))
+    {
+        if (firstHit && *firstHit < index)
+        {
+            break;
+        }
+
+        const size_t length = (end - seek) < window ? (size_t)(end - seek) : window;
+        if (ReadProcessMemory(pid, (void*)(uintptr_t)seek, buffer, length) != 0)
+        {
+            continue;
+        }
+
+        const size_t match = SignatureFind(signature, skip, buffer, length);
+        if (match != SIGNATURE_NOT_FOUND)
+        {
+            found = (uintptr_t)seek + match + signature->offset;
+            break;
+        }
+    }
+
+    delete[] buffer;
+    return found;
+}
+
+struct SignatureSlice
+{
+    uint32_t pid;
+    const Signature* signature;
+    const SignatureSkip* skip;
+    uint64_t start;
+    uint64_t end;
+    uint32_t index;
+    volatile uint32_t* firstHit;  // only a hint to stop later slices early
+    uintptr_t found;
+};
+
+static void ScanSlice(SignatureSlice* slice)
+{
+    slice->found = ScanRange(slice->pid, slice->start, slice->end, slice->signature, slice->skip, slice->firstHit, slice->index);
+    if (slice->found && slice->index < *slice->firstHit)
+    {
+        *slice->firstHit = slice->index;
+    }
+}
+
+#if defined(__PPU__)
+typedef sys_ppu_thread_t ScanThread;
+
+static void ScanSliceThread(uint64_t arg)
+{
+    ScanSlice(reinterpret_cast<SignatureSlice*>((uintptr_t)arg));
+    sys_ppu_thread_exit(0);
+}
+
+static bool StartScanThread(ScanThread* thread, SignatureSlice* slice)
+{
+    return sys_ppu_thread_create(thread, ScanSliceThread, (uint64_t)(uintptr_t)slice, SIGNATURE_SCAN_PRIORITY, SIGNATURE_SCAN_STACK_SIZE, SYS_PPU_THREAD_CREATE_JOINABLE, "signature_scan") == 0;
+}
+
+static void JoinScanThread(ScanThread thread)
+{
+    uint64_t exitCode = 0;
+    sys_ppu_thread_join(thread, &exitCode);
+}
+#else
+typedef pthread_t ScanThread;
+
+static void* ScanSliceThread(void* arg)
+{
+    ScanSlice(static_cast<SignatureSlice*>(arg));
+    return nullptr;
+}
+
+static bool StartScanThread(ScanThread* thread, SignatureSlice* slice)
+{
+    return pthread_create(thread, nullptr, ScanSliceThread, slice) == 0;
+}
+
+static void JoinScanThread(ScanThread thread)
+{
+    pthread_join(thread, nullptr);
+}
+#endif
+
+extern "C"
+{
+uint32_t SignatureParse(const char* text, uint8_t* bytes, uint8_t* mask, size_t capacity)
+{
+    return ParseSignatureText(text, strlen(text), bytes, mask, capacity);
+}
+
+void SignaturePrepare(const Signature* signature, SignatureSkip* skip)
+{
+    PrepareSignatureSkip(signature->bytes, signature->mask, signature->size, *skip);
+}
+
+size_t SignatureFind(const Signature* signature, const SignatureSkip* skip, const uint8_t* data, size_t size)
+{
+    if (signature->size > size)
+    {
+        return SIGNATURE_NOT_FOUND;
+    }
+    if (!skip->length)
+    {
+        return 0;
+    }
+#if defined(SIGNATURE_VECTOR)
+    if (skip->rare != SIGNATURE_NO_RARE)
+    {
+        return SignatureFindVector(signature, skip, data, size);
+    }
+#endif
+
+    const uint32_t last = skip->length - 1;
+    for (size_t i = 0; i + signature->size <= size; i += skip->shift[data[i + last]])
+    {
+        uint32_t j = skip->length;
+        while (j && ((data[i + j - 1] ^ signature->bytes[j - 1]) & SignatureMask(signature, j - 1)) == 0)
+        {
+            j--;
+        }
+        if (!j)
+        {
+            return i;
+        }
+    }
+    return SIGNATURE_NOT_FOUND;
+}
+
+uintptr_t SignatureScan(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature)
+{
+    if (!base || !size || !signature->size || signature->size > size)
+    {
+        return 0;
+    }
+
+    SignatureSkip skip;
+    if (!signature->skip)
+    {
+        SignaturePrepare(signature, &skip);
+    }
+    return ScanRange(pid, base, base + size, signature, signature->skip ? signature->skip : &skip, nullptr, 0);
+}
+
+uintptr_t SignatureScanParallel(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature, uint32_t threads)
+{
+    if (!base || !size || !signature->size || signature->size > size)
+    {
+        return 0;
+    }
+
+    SignatureSkip skip;
+    if (!signature->skip)
+    {
+        SignaturePrepare(signature, &skip);
+    }
+    const SignatureSkip* prepared = signature->skip ? signature->skip : &skip;
+
+    threads = threads > SIGNATURE_SCAN_MAX_THREADS ? SIGNATURE_SCAN_MAX_THREADS : threads;
+    if (threads < 2 || size < (uint64_t)SIGNATURE_SLICE_MIN_SIZE * threads)
+    {
+        return ScanRange(pid, base, base + size, signature, prepared, nullptr, 0);
+    }
+
+    // slices overlap by size - 1 bytes like the windows inside them
+    SignatureSlice slices[SIGNATURE_SCAN_MAX_THREADS];
+    ScanThread workers[SIGNATURE_SCAN_MAX_THREADS];
+    bool started[SIGNATURE_SCAN_MAX_THREADS];
+    volatile uint32_t firstHit = threads;
+    const uint64_t end = base + size;
+    const uint64_t sliceSize = (size + threads - 1) / threads;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        SignatureSlice& slice = slices[i];
+        slice.pid = pid;
+        slice.signature = signature;
+        slice.skip = prepared;
+        slice.start = base + sliceSize * i;
+        slice.end = slice.start + sliceSize + signature->size - 1;
+        slice.end = slice.end > end ? end : slice.end;
+        slice.index = i;
+        slice.firstHit = &firstHit;
+        slice.found = 0;
+    }
+
+    // this thread takes the first slice
+    for (uint32_t i = 1; i < threads; i++)
+    {
+        started[i] = StartScanThread(&workers[i], &slices[i]);
+        if (!started[i])
+        {
+            ScanSlice(&slices[i]);
+        }
+    }
+    ScanSlice(&slices[0]);
+    for (uint32_t i = 1; i < threads; i++)
+    {
+        if (started[i])
+        {
+            JoinScanThread(workers[i]);
+        }
+    }
+
+    // the lowest slice holds the earliest match whatever order the workers finished in
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        if (slices[i].found)
+        {
+            return slices[i].found;
+        }
+    }
+    return 0;
+}
+
+size_t SignatureScanBatch(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signatures, size_t count, uintptr_t* results)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = 0;
+    }
+    if (!base || !size || !count)
+    {
+        return 0;
+    }
+
+    uint32_t maxSize = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        maxSize = signatures[i].size > maxSize ? signatures[i].size : maxSize;
+    }
+    if (!maxSize || maxSize > size)
+    {
+        return 0;
+    }
+
+    const uint32_t window = maxSize * 2 > SIGNATURE_WINDOW_SIZE ? maxSize * 2 : SIGNATURE_WINDOW_SIZE;
+    uint8_t* buffer = new uint8_t[window];
+    SignatureEntry* entries = new SignatureEntry[count];
+    if (!buffer || !entries)
+    {
+        delete[] buffer;
+        delete[] entries;
+        return 0;
+    }
+
+    // signatures without a fully compared byte are tried everywhere
+    uint32_t buckets[256];
+    uint32_t unanchored = SIGNATURE_NO_ENTRY;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        buckets[i] = SIGNATURE_NO_ENTRY;
+    }
+    for (size_t i = count; i-- > 0;)
+    {
+        SignatureEntry* entry = &entries[i];
+        if (!signatures[i].size || signatures[i].size > size)
+        {
+            continue;
+        }
+        SignatureAnchor(&signatures[i], i, entry);
+        if (entry->anchor == SIGNATURE_NO_ENTRY)
+        {
+            entry->anchor = 0;
+            entry->next = unanchored;
+            unanchored = i;
+        }
+        else
+        {
+            uint32_t& head = buckets[signatures[i].bytes[entry->anchor]];
+            entry->next = head;
+            head = i;
+        }
+    }
+
+    size_t found = 0;
+    const uint64_t end = base + size;
+    for (uint64_t seek = base; found < count && seek + 1 <= end; seek += window - (maxSize - 1))
+    {
+        const size_t length = (end - seek) < window ? (size_t)(end - seek) : window;
+        if (ReadProcessMemory(pid, (void*)(uintptr_t)seek, buffer, length) == 0)
+        {
+            for (size_t p = 0; found < count && p < length; p++)
+            {
+                for (uint32_t e = buckets[buffer[p]]; e != SIGNATURE_NO_ENTRY; e = entries[e].next)
+                {
+                    const SignatureEntry* entry = &entries[e];
+                    const Signature* signature = &signatures[entry->signature];
+                    if (results[entry->signature] || p < entry->anchor)
+                    {
+                        continue;
+                    }
+                    const size_t start = p - entry->anchor;
+                    if (start + signature->size > length || (p + 1 < length && (buffer[p + 1] ^ entry->second) & entry->secondMask))
+                    {
+                        continue;
+                    }
+                    if (SignatureMatches(signature, &buffer[start]))
+                    {
+                        results[entry->signature] = (uintptr_t)seek + start + signature->offset;
+                        found++;
+                    }
+                }
+                for (uint32_t e = unanchored; e != SIGNATURE_NO_ENTRY; e = entries[e].next)
+                {
+                    const Signature* signature = &signatures[e];
+                    if (!results[e] && p + signature->size <= length && SignatureMatches(signature, &buffer[p]))
+                    {
+                        results[e] = (uintptr_t)seek + p + signature->offset;
+                        found++;
+                    }
+                }
+            }
+        }
+        if (seek + length >= end)
+        {
+            break;
+        }
+    }
+
+    delete[] buffer;
+    delete[] entries;
+    return found;
+}
+}
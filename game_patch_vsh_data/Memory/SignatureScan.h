@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#define SIGNATURE_NOT_FOUND ((size_t)-1)
+#define SIGNATURE_SCAN_MAX_THREADS 4
+#define SIGNATURE_NO_RARE 0xffffffff
+
+// Horspool shift per last window byte, built once per signature
+typedef struct
+{
+    uint32_t shift[256];
+    uint32_t length;  // signature size without the trailing wildcards
+    uint32_t rare;    // index of the least common fully compared byte, candidates are searched for it
+} SignatureSkip;
+
+typedef struct
+{
+    const uint8_t* bytes;
+    const uint8_t* mask;  // per byte, set bits are compared. nullptr compares every byte
+    uint32_t size;
+    int32_t offset;  // added to the address of the match
+    const SignatureSkip* skip;  // precomputed, nullptr builds it for every scan
+} Signature;
+
+// Runtime counterpart of CompileSignature for IDA style text ("80 1F ?? 4?").
+// Returns the byte count, 0 when the text is malformed or needs more than `capacity` bytes.
+uint32_t SignatureParse(const char* text, uint8_t* bytes, uint8_t* mask, size_t capacity);
+
+void SignaturePrepare(const Signature* signature, SignatureSkip* skip);
+
+// Index of the first match in data, or SIGNATURE_NOT_FOUND
+size_t SignatureFind(const Signature* signature, const SignatureSkip* skip, const uint8_t* data, size_t size);
+
+// Scans [base, base + size) of a process in large overlapping reads.
+// Returns the match address plus signature->offset, 0 if not found.
+uintptr_t SignatureScan(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature);
+
+// SignatureScan with the range split in slices scanned by up to `threads` threads (the caller included).
+// The earliest match wins, slices after it stop early.
+uintptr_t SignatureScanParallel(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature, uint32_t threads);
+
+// Looks for all signatures in a single pass over [base, base + size).
+// results[i] gets what SignatureScan would return for signatures[i]. Returns how many were found.
+size_t SignatureScanBatch(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signatures, size_t count, uintptr_t* results);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+#include <stdint.h>
+#include "SignatureScan.h"
+
+// Shared by SignaturePrepare and the compile time signatures of SignatureCompiler.hpp.
+// Only C++14 compilers other than SNC evaluate these at compile time. The vcxproj builds with SNC and
+// Cpp11, so on the console they are plain inline functions and every table is computed at run time.
+#if __cplusplus >= 201402L && !defined(__SNC__)
+#define SIGNATURE_COMPILE_TIME 1
+#define SIGNATURE_CONSTEXPR constexpr
+#else
+#define SIGNATURE_CONSTEXPR inline
+#endif
+
+// Rough byte frequency in PPU code, lower is rarer
+SIGNATURE_CONSTEXPR uint32_t ByteCommonness(uint8_t value)
+{
+    switch (value)
+    {
+        case 0x00:
+            return 4;
+        case 0xff:
+            return 3;
+        case 0x38:
+        case 0x39:
+        case 0x3c:
+        case 0x40:
+        case 0x41:
+        case 0x48:
+        case 0x4b:
+        case 0x4e:
+        case 0x60:
+        case 0x7c:
+        case 0x80:
+        case 0x81:
+        case 0x90:
+        case 0xe8:
+        case 0xf8:
+            return 2;
+        case 0x01:
+        case 0x10:
+        case 0x20:
+        case 0x2f:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+SIGNATURE_CONSTEXPR void PrepareSignatureSkip(const uint8_t* bytes, const uint8_t* mask, uint32_t size, SignatureSkip& skip)
+{
+    // trailing wildcards can't reject anything, the window is aligned on the last compared byte
+    uint32_t length = size;
+    while (length && mask && mask[length - 1] == 0)
+    {
+        length--;
+    }
+    skip.length = length;
+
+    skip.rare = SIGNATURE_NO_RARE;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if ((!mask || mask[i] == 0xff) && (skip.rare == SIGNATURE_NO_RARE || ByteCommonness(bytes[i]) < ByteCommonness(bytes[skip.rare])))
+        {
+            skip.rare = i;
+        }
+    }
+
+    // a partially masked byte matches several values, shifting past it is only safe like for a wildcard
+    uint32_t shift = length;
+    for (uint32_t i = 0; i + 1 < length; i++)
+    {
+        if (mask && mask[i] != 0xff)
+        {
+            shift = length - 1 - i;
+        }
+    }
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        skip.shift[i] = shift;
+    }
+    for (uint32_t i = 0; i + 1 < length; i++)
+    {
+        if ((!mask || mask[i] == 0xff) && length - 1 - i < shift)
+        {
+            skip.shift[bytes[i]] = length - 1 - i;
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include "TrampolinePool.hpp"
+#include <string.h>
+#include <sys/process.h>
+#include "Utils/SystemCalls.hpp"
+
+#define BUCKET_INDEX(SIZE) (((SIZE) / TRAMPOLINE_POOL_GRANULE) - 1)
+#define BUCKET_SIZE(INDEX) (((INDEX) + 1) * TRAMPOLINE_POOL_GRANULE)
+
+TrampolinePool::TrampolinePool(uint8_t* buffer, size_t size)
+    : m_ChunkCount(0)
+{
+    memset(m_Chunks, 0, sizeof(m_Chunks));
+    memset(m_Buckets, 0, sizeof(m_Buckets));
+    memset(&m_Stats, 0, sizeof(m_Stats));
+
+    if (buffer && size)
+    {
+        m_Chunks[0].base = buffer;
+        m_Chunks[0].size = size;
+        m_ChunkCount = 1;
+        m_Stats.freeBytes = size;
+        m_Stats.chunks = 1;
+    }
+}
+
+TrampolinePool::~TrampolinePool()
+{
+    // the pages stay mapped, something may still be running a trampoline
+    for (uint32_t i = 0; i < TRAMPOLINE_POOL_BUCKETS; i++)
+    {
+        delete[] m_Buckets[i].blocks;
+    }
+}
+
+uint8_t* TrampolinePool::Allocate(size_t size)
+{
+    if (size == 0 || size > TRAMPOLINE_POOL_MAX_BLOCK)
+    {
+        return nullptr;
+    }
+    const uint32_t rounded = (size + TRAMPOLINE_POOL_GRANULE - 1) & ~(TRAMPOLINE_POOL_GRANULE - 1);
+
+    uint8_t* block = TakeFree(rounded);
+    if (!block)
+    {
+        Chunk* chunk = m_ChunkCount ? &m_Chunks[m_ChunkCount - 1] : nullptr;
+        if (!chunk || chunk->size - chunk->used < rounded)
+        {
+            // the rest of the old chunk is still good for smaller trampolines
+            if (chunk && chunk->size - chunk->used >= TRAMPOLINE_POOL_GRANULE)
+            {
+                const uint32_t rest = chunk->size - chunk->used;
+                if (PutFree((uint32_t)&chunk->base[chunk->used], rest))
+                {
+                    chunk->used += rest;
+                    m_Stats.fragmentedBytes += rest;
+                }
+            }
+            if (!Grow())
+            {
+                return nullptr;
+            }
+            chunk = &m_Chunks[m_ChunkCount - 1];
+        }
+
+        block = &chunk->base[chunk->used];
+        chunk->used += rounded;
+    }
+    else
+    {
+        m_Stats.fragmentedBytes -= rounded;
+    }
+
+    m_Stats.liveBytes += rounded;
+    m_Stats.freeBytes -= rounded;
+    m_Stats.liveBlocks++;
+    return block;
+}
+
+void TrampolinePool::Free(uint8_t* block, size_t size)
+{
+    if (!block || size == 0 || size > TRAMPOLINE_POOL_MAX_BLOCK)
+    {
+        return;
+    }
+    const uint32_t rounded = (size + TRAMPOLINE_POOL_GRANULE - 1) & ~(TRAMPOLINE_POOL_GRANULE - 1);
+
+    m_Stats.liveBytes -= rounded;
+    m_Stats.liveBlocks--;
+    if (PutFree((uint32_t)block, rounded))
+    {
+        m_Stats.freeBytes += rounded;
+        m_Stats.fragmentedBytes += rounded;
+    }
+}
+
+uint8_t* TrampolinePool::TakeFree(uint32_t size)
+{
+    // the exact size first, otherwise split the smallest larger block
+    for (uint32_t i = BUCKET_INDEX(size); i < TRAMPOLINE_POOL_BUCKETS; i++)
+    {
+        Bucket& bucket = m_Buckets[i];
+        if (!bucket.count)
+        {
+            continue;
+        }
+
+        const uint32_t block = bucket.blocks[--bucket.count];
+        const uint32_t rest = BUCKET_SIZE(i) - size;
+        if (rest && !PutFree(block + size, rest))
+        {
+            // no room to track the rest, it's lost
+            m_Stats.freeBytes -= rest;
+            m_Stats.fragmentedBytes -= rest;
+        }
+        return (uint8_t*)block;
+    }
+    return nullptr;
+}
+
+bool TrampolinePool::PutFree(uint32_t block, uint32_t size)
+{
+    Bucket& bucket = m_Buckets[BUCKET_INDEX(size)];
+    if (bucket.count == bucket.capacity)
+    {
+        const uint32_t capacity = bucket.capacity ? bucket.capacity * 2 : 8;
+        uint32_t* blocks = new uint32_t[capacity];
+        if (!blocks)
+        {
+            return false;
+        }
+        if (bucket.count)
+        {
+            memcpy(blocks, bucket.blocks, bucket.count * sizeof(uint32_t));
+        }
+        delete[] bucket.blocks;
+        bucket.blocks = blocks;
+        bucket.capacity = capacity;
+    }
+    bucket.blocks[bucket.count++] = block;
+    return true;
+}
+
+bool TrampolinePool::Grow()
+{
+    if (m_ChunkCount == TRAMPOLINE_POOL_MAX_CHUNKS)
+    {
+        return false;
+    }
+
+    // page_table[0] is the kernel address of the pages, page_table[1] where they are mapped in the process
+    uint64_t page_table[2] = {0, 0};
+    if (ps3mapi_process_page_allocate(sys_process_getpid(), TRAMPOLINE_POOL_PAGE_SIZE, 0x100, 0x2F, 1, page_table) != 0 || !page_table[1])
+    {
+        return false;
+    }
+
+    Chunk& chunk = m_Chunks[m_ChunkCount++];
+    chunk.base = (uint8_t*)(uint32_t)page_table[1];
+    chunk.size = TRAMPOLINE_POOL_PAGE_SIZE;
+    chunk.used = 0;
+    m_Stats.freeBytes += chunk.size;
+    m_Stats.chunks++;
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRAMPOLINE_POOL_GRANULE 4  // one instruction
+#define TRAMPOLINE_POOL_BUCKETS 32  // exact size free lists up to 128 bytes
+#define TRAMPOLINE_POOL_MAX_BLOCK (TRAMPOLINE_POOL_GRANULE * TRAMPOLINE_POOL_BUCKETS)
+#define TRAMPOLINE_POOL_MAX_CHUNKS 8
+#define TRAMPOLINE_POOL_PAGE_SIZE 0x10000
+
+// Hands out executable memory for trampolines. Starts on a static buffer and takes
+// executable pages from PS3MAPI once it's used up. Freed blocks go on a free list per size.
+// The memory itself isn't writable, free lists are kept out of it.
+class TrampolinePool
+{
+   public:
+    struct Stats
+    {
+        uint32_t liveBytes;        // in blocks handed out
+        uint32_t freeBytes;        // on the free lists plus never used chunk space
+        uint32_t fragmentedBytes;  // the part of freeBytes on the free lists
+        uint32_t liveBlocks;
+        uint32_t chunks;
+    };
+
+   public:
+    /***
+     * @param buffer Executable memory used before any page is allocated.
+     * @param size Size of buffer in bytes.
+     */
+    TrampolinePool(uint8_t* buffer, size_t size);
+    TrampolinePool(TrampolinePool const&) = delete;
+    TrampolinePool& operator=(TrampolinePool const&) = delete;
+    ~TrampolinePool();
+
+    /***
+     * @param size Bytes needed, at most TRAMPOLINE_POOL_MAX_BLOCK.
+     * @returns executable block, nullptr when no page could be allocated
+     */
+    uint8_t* Allocate(size_t size);
+
+    /***
+     * @param block Block from Allocate.
+     * @param size The size it was allocated with.
+     */
+    void Free(uint8_t* block, size_t size);
+
+    const Stats& GetStats() const { return m_Stats; }
+
+   private:
+    struct Chunk
+    {
+        uint8_t* base;
+        uint32_t size;
+        uint32_t used;
+    };
+
+    struct Bucket
+    {
+        uint32_t* blocks;
+        uint32_t count;
+        uint32_t capacity;
+    };
+
+    uint8_t* TakeFree(uint32_t size);
+    bool PutFree(uint32_t block, uint32_t size);
+    bool Grow();
+
+   private:
+    Chunk m_Chunks[TRAMPOLINE_POOL_MAX_CHUNKS];
+    uint32_t m_ChunkCount;
+    Bucket m_Buckets[TRAMPOLINE_POOL_BUCKETS];
+    Stats m_Stats;
+};
@@ -0,0 +1,149 @@
+#include "ScanCache.hpp"
+#include <stdio.h>
+#include <vsh/stdc.hpp>
+#include "SystemCalls.hpp"
+#include "../Memory/Memory.h"
+#include "../../shared/GamePatchInfo.h"
+#include "../../shared/stringid.h"
+
+#define SCAN_CACHE_MAGIC 0x5343414e  // SCAN
+#define SCAN_CACHE_VERSION 2
+#define SCAN_CACHE_ENTRIES 16
+
+// Each entry belongs to the range it was scanned in, so scans of different segments don't evict each other
+struct ScanCacheEntry
+{
+    uint64_t base;
+    uint64_t size;
+    uint32_t signature;  // hash of the signature itself
+    uint32_t address;    // match address, without the signature offset
+    uint32_t bytesHash;  // hash of the matched bytes, wildcards included
+    uint32_t pad;
+};
+
+struct ScanCache
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fwVersion;
+    uint32_t count;
+    ScanCacheEntry entries[SCAN_CACHE_ENTRIES];
+};
+
+static uint32_t SignatureHash(const Signature* signature)
+{
+    uint32_t hash = memid(signature->bytes, signature->size, 0);
+    if (signature->mask)
+    {
+        hash = memid(signature->mask, signature->size, hash);
+    }
+    return memid(&signature->offset, sizeof(signature->offset), hash);
+}
+
+// Hash of the bytes at address if the signature matches there, 0 otherwise
+static uint32_t MatchedBytesHash(uint32_t pid, uint32_t address, const Signature* signature)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(vsh::malloc(signature->size));
+    if (!bytes)
+    {
+        return 0;
+    }
+
+    uint32_t hash = 0;
+    if (ReadProcessMemory(pid, (void*)address, bytes, signature->size) == 0)
+    {
+        SignatureSkip skip;
+        if (!signature->skip)
+        {
+            SignaturePrepare(signature, &skip);
+        }
+        if (SignatureFind(signature, signature->skip ? signature->skip : &skip, bytes, signature->size) == 0)
+        {
+            hash = memid(bytes, signature->size, 0) | 1;
+        }
+    }
+    vsh::free(bytes);
+    return hash;
+}
+
+static bool ReadScanCache(ScanCache& cache)
+{
+    FILE* fd = vsh::fopen(GAME_PATCH_SCAN_CACHE_PATH, "rb");
+    if (!fd)
+    {
+        return false;
+    }
+    const bool okay = vsh::fread(&cache, sizeof(cache), 1, fd) == 1;
+    vsh::fclose(fd);
+    return okay;
+}
+
+static void WriteScanCache(const ScanCache& cache)
+{
+    FILE* fd = vsh::fopen(GAME_PATCH_SCAN_CACHE_PATH, "wb");
+    if (fd)
+    {
+        vsh::fwrite(&cache, sizeof(cache), 1, fd);
+        vsh::fclose(fd);
+    }
+}
+
+uintptr_t CachedSignatureScan(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature)
+{
+    const uint32_t fwVersion = ps3mapi_get_fw_version();
+    const uint32_t signatureHash = SignatureHash(signature);
+
+    ScanCache cache;
+    vsh::memset(&cache, 0, sizeof(cache));
+    if (!ReadScanCache(cache) || cache.magic != SCAN_CACHE_MAGIC || cache.version != SCAN_CACHE_VERSION ||
+        cache.fwVersion != fwVersion || cache.count > SCAN_CACHE_ENTRIES)
+    {
+        vsh::memset(&cache, 0, sizeof(cache));
+        cache.magic = SCAN_CACHE_MAGIC;
+        cache.version = SCAN_CACHE_VERSION;
+        cache.fwVersion = fwVersion;
+    }
+
+    uint32_t slot = cache.count;
+    for (uint32_t i = 0; i < cache.count; i++)
+    {
+        const ScanCacheEntry& entry = cache.entries[i];
+        if (entry.base != base || entry.size != size || entry.signature != signatureHash)
+        {
+            continue;
+        }
+        if (entry.bytesHash && MatchedBytesHash(pid, entry.address, signature) == entry.bytesHash)
+        {
+            vsh::printf("signature 0x%08x cached at 0x%x\n", signatureHash, entry.address);
+            return entry.address + signature->offset;
+        }
+        slot = i;
+        break;
+    }
+
+    // both PPU hardware threads take part in a full scan
+    const uintptr_t found = SignatureScanParallel(pid, base, size, signature, 2);
+    if (!found)
+    {
+        return 0;
+    }
+
+    if (slot == SCAN_CACHE_ENTRIES)
+    {
+        // full, the oldest entry makes room
+        for (uint32_t i = 1; i < SCAN_CACHE_ENTRIES; i++)
+        {
+            cache.entries[i - 1] = cache.entries[i];
+        }
+        slot = SCAN_CACHE_ENTRIES - 1;
+    }
+    ScanCacheEntry& entry = cache.entries[slot];
+    entry.base = base;
+    entry.size = size;
+    entry.signature = signatureHash;
+    entry.address = found - signature->offset;
+    entry.bytesHash = MatchedBytesHash(pid, entry.address, signature);
+    cache.count = slot + 1 > cache.count ? slot + 1 : cache.count;
+    WriteScanCache(cache);
+    return found;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include "../Memory/SignatureScan.h"
+
+/***
+ * SignatureScan backed by GAME_PATCH_SCAN_CACHE_PATH. A cached address is trusted when it was found in the same range
+ * (base and size) on the same firmware, the signature still matches there and the matched bytes hash as when it was found.
+ * Only a miss scans the range, its result is written back.
+ * @returns the match address plus signature->offset, 0 if not found.
+ */
+uintptr_t CachedSignatureScan(uint32_t pid, uintptr_t base, uint64_t size, const Signature* signature);
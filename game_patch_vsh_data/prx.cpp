@@ -4,6 +4,9 @@
 #include <sys/timer.h>
 #include <sys/stat.h>
 #include "Memory/Detour.hpp"
+#include "Memory/ElfSegments.h"
+#include "Memory/SignatureCompiler.hpp"
+#include "Utils/ScanCache.hpp"
 #include <vsh/newDelete.hpp>
 #include <vsh/stdc.hpp>
 #include <vshlib.hpp>
@@ -11,6 +14,7 @@
 #include "../shared/GamePatchInfo.h"
 #include "../shared/memory.h"
 #include "../shared/macros.h"
+#include "../shared/stringid.h"
 
 #include "../data/game_plugins.yml.inc.h"
 #include "../data/game_plugin_bootloader.sprx.inc.h"
@@ -20,57 +24,6 @@ SYS_MODULE_INFO(game_patch_vsh_data, 0, 1, 1);
 SYS_MODULE_START(module_start);
 SYS_MODULE_STOP(module_stop);
 
-// SNC is too old to constexpr?
-static uint32_t stringid(const char* str, uint32_t base = 0x811c9dc5)
-{
-    while (*str)
-    {
-        base = 0x01000193 * (base ^ *str++);
-    }
-    return base;
-}
-
-// masked by ff
-static uintptr_t PatternScan(sys_pid_t process, const uintptr_t module_base, const uint64_t module_size, const void* signature, const uint64_t signature_size, const uint64_t offset)
-{
-#define seek_size 256
-    if (!module_base || !module_size || !signature_size || signature_size > seek_size)
-    {
-        return 0;
-    }
-    for (uintptr_t seek = module_base; seek < ((module_base + module_size) - signature_size); seek += seek_size)
-    {
-        uint8_t seek_buf[seek_size];
-        memset(seek_buf, 0, sizeof(seek_buf));
-        if (ReadProcessMemory(process, (void*)seek, seek_buf, sizeof(seek_buf)) == 0)
-        {
-            const uint8_t* scanBytes = seek_buf;
-            const uint8_t* patternBytes = (uint8_t*)signature;
-            for (uint64_t i = 0; i < sizeof(seek_buf); i++)
-            {
-                uint8_t found = 1;
-                for (int32_t j = 0; j < signature_size; j++)
-                {
-                    if (scanBytes[i + j] != patternBytes[j] &&
-                        patternBytes[j] != 0xff)
-                    {
-                        found = 0;
-                        break;
-                    }
-                }
-                if (found)
-                {
-                    const uintptr_t found_addr = (seek + (((uintptr_t)&scanBytes[i] - (uintptr_t)&scanBytes[0]) + offset));
-                    // DPRINTF2("found_addr %lx\n", found_addr);
-                    return found_addr;
-                }
-            }
-        }
-    }
-#undef seek_size
-    return 0;
-}
-
 static uint64_t GetVshSize()
 {
     const uint64_t* memsz = reinterpret_cast<uint64_t*>(0x00010068);  // ElfHeader->Elf64[0].p_memsz
@@ -97,6 +50,64 @@ MARK_AS_EXECUTABLE static uint32_t m_JumpBuff[16] = {0};
 
 STATIC_FUNCTION_PTR(void, load_plugin_main, void* p);
 
+// Sequence of the last launch record, the notify thread only reads the record while it waits for its result
+static uint32_t s_launch_sequence = 0;
+static volatile uint32_t s_pending_sequence = 0;
+
+// Same hash game_patch keys its cached plan with, chunk by chunk
+static uint32_t file_checksum(const char* path)
+{
+    FILE* fd = vsh::fopen(path, "rb");
+    if (!fd)
+    {
+        return 0;
+    }
+    uint32_t hash = 0;
+    uint8_t buf[512];
+    size_t readcount = 0;
+    while ((readcount = vsh::fread(buf, 1, sizeof(buf), fd)) > 0)
+    {
+        hash = memid(buf, readcount, hash);
+    }
+    vsh::fclose(fd);
+    return hash;
+}
+
+static void write_launch_record(const vsh::GamePluginInterface::gameInfo& gameInfo, const vsh::GamePluginInterface::AppVerInfo& appVer)
+{
+    GameLaunchRecord record;
+    vsh::memset(&record, 0, sizeof(record));
+    record.magic = GAME_LAUNCH_RECORD_MAGIC;
+    record.version = GAME_LAUNCH_RECORD_VERSION;
+    record.size = sizeof(record);
+    record.sequence = ++s_launch_sequence;
+    vsh::memcpy(&record.info.titleid, &gameInfo.titleid, sizeof(gameInfo.titleid));
+    vsh::memcpy(&record.info.app_ver, &appVer.buf, sizeof(appVer.buf));
+    vsh::snprintf(record.patch_path, _countof_1(record.patch_path), GAME_PATCH_FILES_PATH "/%s.yml", record.info.titleid);
+
+    stat sb;
+    vsh::memset(&sb, 0, sizeof(sb));
+    if (vsh::stat(record.patch_path, &sb) == 0)
+    {
+        record.flags |= GAME_LAUNCH_HAS_PATCH_FILE;
+        record.patch_file_size = sb.st_size;
+        record.patch_file_mtime = sb.st_mtime;
+
+        char settings_path[MAX_PATH + 1];
+        vsh::snprintf(settings_path, _countof_1(settings_path), GAME_PATCH_SETTINGS "/%s.bin", record.info.titleid);
+        record.state_checksum = file_checksum(settings_path);
+    }
+
+    // the game can write into this file but can't create it
+    FILE* fd = vsh::fopen(GAME_LAUNCH_RECORD_PATH, "wb");
+    if (fd)
+    {
+        vsh::fwrite(&record, sizeof(record), 1, fd);
+        vsh::fclose(fd);
+        s_pending_sequence = (record.flags & GAME_LAUNCH_HAS_PATCH_FILE) ? record.sequence : 0;
+    }
+}
+
 static void load_plugin_main(void* _p)
 {
     struct my_Data
@@ -109,11 +120,11 @@ static void load_plugin_main(void* _p)
     static uint32_t hash_gp = 0;
     if (!hash_gp)
     {
-        hash_gp = stringid("game_plugin");
+        hash_gp = stringid("game_plugin", 0);
     }
     paf::View* gamePlugin = paf::View::Find("game_plugin");
     const char* plugin_str = p->plugin_name.c_str();
-    if (gamePlugin && stringid(plugin_str) == hash_gp)
+    if (gamePlugin && stringid(plugin_str, 0) == hash_gp)
     {
         vsh::printf("gamePlugin %p\n", gamePlugin);
         if (vsh::GamePluginInterface* gameInterface = gamePlugin->GetInterface<vsh::GamePluginInterface*>(1))
@@ -127,30 +138,7 @@ static void load_plugin_main(void* _p)
             vsh::GamePluginInterface::AppVerInfo app_ver = {0};
             gameInterface->GetAppVer(app_ver);
             vsh::printf("%s\n", app_ver.buf);
-            GamePatchInfo write_info;
-            vsh::memset(&write_info, 0, sizeof(write_info));
-            vsh::memcpy(&write_info.titleid, &_gameInfo.titleid, sizeof(_gameInfo.titleid));
-            vsh::memcpy(&write_info.app_ver, &app_ver.buf, sizeof(app_ver.buf));
-            {
-                FILE* fd = vsh::fopen(GAME_INFO_PATH, "wb");
-                if (fd)
-                {
-                    vsh::fwrite(&write_info, sizeof(write_info), 1, fd);
-                    vsh::fclose(fd);
-                }
-            }
-            // need vsh to create this file first
-            // because game from prx can't create it for some reason
-            // or maybe i'm just setting up `sys_fs_open` wrong
-            {
-                FILE* fd = vsh::fopen(GAME_PATCH_NOTIFY_MSG_FILE, "wb");
-                if (fd)
-                {
-                    char buf = CHECK_BYTE;
-                    vsh::fwrite(&buf, sizeof(buf), 1, fd);
-                    vsh::fclose(fd);
-                }
-            }
+            write_launch_record(_gameInfo, app_ver);
         }
     }
     load_plugin_main_ptr(p);
@@ -219,56 +207,6 @@ char* read_file(const char* filename, int& file_size)
     return buffer;
 }
 
-static bool read_file(const char* filename, char* buffer, const size_t max_size, int& file_size)
-{
-    if (buffer == NULL)
-    {
-        vsh::printf("Error: Buffer is NULL\n");
-        return false;
-    }
-
-    FILE* file = vsh::fopen(filename, "rb");
-    if (file == NULL)
-    {
-        vsh::perror("Error opening file");
-        return false;
-    }
-
-    vsh::fseek(file, 0, SEEK_END);
-    int size = vsh::ftell(file);
-    vsh::fseek(file, 0, SEEK_SET);
-
-    if (size < 0)
-    {
-        vsh::perror("Error getting file size");
-        vsh::fclose(file);
-        return false;
-    }
-
-    if ((size_t)size >= max_size)
-    {
-        vsh::printf("Error: File size (%d bytes) exceeds maximum buffer size of %ld bytes\n", size, max_size);
-        vsh::fclose(file);
-        return false;
-    }
-
-    vsh::memset(buffer, 0, max_size);
-
-    size_t bytes_read = vsh::fread(buffer, 1, size, file);
-    if (bytes_read != (size_t)size)
-    {
-        vsh::perror("Error reading file");
-        vsh::fclose(file);
-        return false;
-    }
-
-    vsh::fclose(file);
-
-    file_size = size;
-
-    return true;
-}
-
 static void write_default_blob(const char* path, const void* data, const size_t data_sz)
 {
     const int ret = file_exists(path);
@@ -296,14 +234,14 @@ static void make_folders()
         GAME_PATCH_SETTINGS,
         GAME_PATCH_FILES_PATH,
         GAME_PATCH_WORK_PATH,
+        GAME_PATCH_CACHE_PATH,
     };
     for (size_t i = 0; i < _countof(paths); i++)
     {
         vsh::mkdir(paths[i], 0777);
     }
-    // delete temp info file
-    vsh::unlink(GAME_PATCH_NOTIFY_MSG_FILE);
-    vsh::unlink(GAME_INFO_PATH);
+    // delete the last launch record
+    vsh::unlink(GAME_LAUNCH_RECORD_PATH);
     write_default_blob(PLUGINS_PATH, game_plugins_yml_data, sizeof(game_plugins_yml_data));
     write_default_blob(BOOTLOADER_PATH, game_plugin_bootloader_sprx_data, sizeof(game_plugin_bootloader_sprx_data));
 }
@@ -321,21 +259,37 @@ static void run_patch(uint64_t)
 #endif
     make_folders();
     vsh::printf("patching now!\n");
-    static const uint32_t start_plugin_search[] = {
-        0x801f0008,
-        0x2f800000,
-        0x781f0020,
-        0x7fe3fb78,
-        0x419effff,
-        0xffffffff,
-        0x7fe3fb78,
-        0xffffffff,
-    };
+    SIGNATURE_STORAGE auto start_plugin_search = CompileSignature("80 1F 00 08 2F 80 00 00 78 1F 00 20 7F E3 FB 78 41 9E ?? ?? ?? ?? ?? ?? 7F E3 FB 78 ?? ?? ?? ??");
+    const Signature start_plugin_signature = start_plugin_search.Get(20);
     const uint32_t vsh_pid = sys_process_getpid();
     bool patch_okay = false;
-    if (vsh_pid)
+#if defined(SIGNATURE_COMPILE_TIME)
+    const bool tables_okay = true;
+#else
+    // the signature tables were built just now, not by the compiler
+    const bool tables_okay = SignatureCompilerCheck();
+    if (!tables_okay)
+    {
+        vsh::printf("CompileSignature differs from the constexpr build, not patching\n");
+    }
+#endif
+    if (vsh_pid && tables_okay)
     {
-        const uintptr_t start_plugin_search_addr = PatternScan(vsh_pid, 0x00010000, GetVshSize(), start_plugin_search, sizeof(start_plugin_search), 20);
+        // only code is worth scanning, the whole first segment if the headers can't be read
+        CodeSegment segments[CODE_SEGMENTS_MAX];
+        size_t segment_count = ElfCodeSegments(vsh_pid, 0x00010000, segments, CODE_SEGMENTS_MAX);
+        if (!segment_count)
+        {
+            segments[0].base = 0x00010000;
+            segments[0].size = GetVshSize();
+            segment_count = 1;
+        }
+        uintptr_t start_plugin_search_addr = 0;
+        for (size_t i = 0; i < segment_count && !start_plugin_search_addr; i++)
+        {
+            vsh::printf("scanning 0x%08x-0x%08x\n", segments[i].base, segments[i].base + segments[i].size);
+            start_plugin_search_addr = CachedSignatureScan(vsh_pid, segments[i].base, segments[i].size, &start_plugin_signature);
+        }
         vsh::printf("start_plugin_search_addr %x\n", start_plugin_search_addr);
         if (start_plugin_search_addr)
         {
@@ -350,26 +304,54 @@ static void run_patch(uint64_t)
     sys_ppu_thread_exit(0);
 }
 
+static bool read_launch_result(GameLaunchResult& result)
+{
+    FILE* fd = vsh::fopen(GAME_LAUNCH_RECORD_PATH, "rb");
+    if (!fd)
+    {
+        return false;
+    }
+    const bool okay = vsh::fseek(fd, GAME_LAUNCH_RESULT_OFFSET, SEEK_SET) == 0 && vsh::fread(&result, sizeof(result), 1, fd) == 1;
+    vsh::fclose(fd);
+    return okay;
+}
+
+// how long a launch waits for game_patch to answer
+#define NOTIFY_TIMEOUT_SECONDS 120
+
 static void notify_thread(uint64_t arg)
 {
+    uint32_t done = 0;
+    uint32_t last = 0;
+    int waited = 0;
     while (1)
     {
-        if (file_exists(GAME_PATCH_NOTIFY_MSG_FILE) == 0)
+        const uint32_t waiting_for = s_pending_sequence;
+        if (waiting_for != last)
+        {
+            last = waiting_for;
+            waited = 0;
+        }
+        if (waiting_for && waiting_for != done)
         {
-            // vsh::printf("%s exist\n", GAME_PATCH_NOTIFY_MSG_FILE);
-            int notify_buf_sz = 0;
-            char notify_buf[256 + 1];
-            if (read_file(GAME_PATCH_NOTIFY_MSG_FILE, notify_buf, sizeof(notify_buf), notify_buf_sz) && notify_buf[0] != CHECK_BYTE && notify_buf_sz > 1)
+            GameLaunchResult result;
+            vsh::memset(&result, 0, sizeof(result));
+            const bool answered = read_launch_result(result) && result.sequence == waiting_for && result.state != GAME_LAUNCH_RESULT_PENDING;
+            if (answered && result.state == GAME_LAUNCH_RESULT_APPLIED)
             {
-                wchar_t buf[_countof(notify_buf)];
+                result.message[_countof_1(result.message)] = 0;
+                wchar_t buf[_countof(result.message)];
                 vsh::memset(buf, 0, sizeof(buf));
-                vsh::swprintf(buf, _countof_1(buf), L"%hs", notify_buf);
+                vsh::swprintf(buf, _countof_1(buf), L"%hs", result.message);
                 const int wait = 2;
                 vsh::printf("waiting for %d seconds\n", wait);
                 sys_timer_sleep(wait);
-                vsh::printf("notify: %s\n", notify_buf);
+                vsh::printf("notify: %s\n", result.message);
                 vsh::ShowNotificationWithIcon(buf, vsh::NotifyIcon::Info);
-                vsh::unlink(GAME_PATCH_NOTIFY_MSG_FILE);
+            }
+            if (answered || ++waited >= NOTIFY_TIMEOUT_SECONDS)
+            {
+                done = waiting_for;
             }
         }
         sys_timer_sleep(1);
@@ -380,7 +362,7 @@ CDECL_BEGIN
 int module_start(unsigned int args, void* argp)
 {
     sys_ppu_thread_t gVshMenuPpuThreadId = SYS_PPU_THREAD_ID_INVALID;
-    sys_ppu_thread_create(&gVshMenuPpuThreadId, run_patch, 0, 1059, 4096, SYS_PPU_THREAD_CREATE_JOINABLE, "game_patch_vsh_data_start");
+    sys_ppu_thread_create(&gVshMenuPpuThreadId, run_patch, 0, 1059, 8192, SYS_PPU_THREAD_CREATE_JOINABLE, "game_patch_vsh_data_start");
     sys_ppu_thread_create(&gVshMenuPpuThreadId, notify_thread, 0, 1059, 4096, SYS_PPU_THREAD_CREATE_JOINABLE, "game_patch_vsh_notify_thread");
 
     // Exit thread using directly the syscall and not the user mode library or else we will crash
@@ -79,16 +79,16 @@ static int parse_load_file(const char* filename, program_args& args)
         return -1;
     }
 
-    GamePatchInfo info;
-    bzero(&info, sizeof(info));
-    if (load_game_info(GAME_INFO_PATH, info) == 0)
+    GameLaunchRecord record;
+    bzero(&record, sizeof(record));
+    if (load_launch_record(record) == 0)
     {
         puts("failed to retrive game info");
         return -1;
     }
     LoadPluginData data;
     bzero(&data, sizeof(data));
-    data.game_info = &info;
+    data.game_info = &record.info;
     data.callback = load_plugin_callback;
     data.main_arg = &args;
     load_plugins(filename, &data);
@@ -0,0 +1,230 @@
+// The load_module hook of game_patch finds sys_prx_load_module through the game's own import
+// table. The fake EBOOT here has nothing at the vsh.self stub table location, its PRX param and
+// import stubs sit wherever its data segment puts them.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/ElfSegments.h"
+#include "Memory/HookRegistry.hpp"
+
+#include <string.h>
+#include <sys/process.h>
+
+#define EXE_BASE 0x10000
+#define EXE_SIZE 0x10000
+#define GAME_BASE HOST_GAME_WINDOW_BASE
+#define GAME_SIZE 0x10000
+#define GAME_TOC 0x10208000
+
+#define PT_LOAD 1
+#define PT_PROC_PRX_PARAM 0x60000002
+#define PF_X 1
+#define PF_R 4
+#define FNID_SYS_PRX_LOAD_MODULE 0x26090058
+
+extern "C" bool deferred_hook_install(void);
+
+static int s_loads = 0;
+
+extern "C" void deferred_patches_on_load(const char* path, int32_t prx_id)
+{
+    (void)path, (void)prx_id;
+    s_loads++;
+}
+
+struct Elf64Header
+{
+    uint8_t ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct Elf64Phdr
+{
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+};
+
+struct PrxParam
+{
+    uint32_t size;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sdkVersion;
+    uint32_t libentStart;
+    uint32_t libentEnd;
+    uint32_t libstubStart;
+    uint32_t libstubEnd;
+    uint16_t ver;
+    uint16_t pad0;
+    uint32_t pad1;
+};
+
+struct ImportStub
+{
+    uint8_t size;
+    uint8_t unknown;
+    uint16_t version;
+    uint16_t attributes;
+    uint16_t functions;
+    uint16_t variables;
+    uint16_t tlsVariables;
+    uint32_t hashInfo;
+    uint32_t name;
+    uint32_t fnids;
+    uint32_t stubs;
+    uint32_t reserved[4];
+};
+
+static uint32_t address_of(uint8_t* exe, const void* p)
+{
+    return EXE_BASE + (uint32_t)((const uint8_t*)p - exe);
+}
+
+// An EBOOT that imports cellSysutil and sysPrxForUser. The liblv2 opds live in the game window.
+static void make_executable(uint8_t* exe, uint16_t sysPrxFunctions, bool prxParam)
+{
+    memset(exe, 0, EXE_SIZE);
+    Elf64Header* eh = (Elf64Header*)exe;
+    memcpy(eh->ident, "\x7f" "ELF\x02\x02\x01", 7);
+    eh->type = 2;
+    eh->machine = 0x15;
+    eh->phoff = 0x40;
+    eh->ehsize = sizeof(Elf64Header);
+    eh->phentsize = sizeof(Elf64Phdr);
+    eh->phnum = 3;
+
+    PrxParam* param = (PrxParam*)(exe + 0x3100);
+    Elf64Phdr* ph = (Elf64Phdr*)(exe + 0x40);
+    ph[0].type = PT_LOAD, ph[0].flags = PF_R | PF_X, ph[0].vaddr = EXE_BASE, ph[0].filesz = ph[0].memsz = 0x3000;
+    ph[1].type = PT_LOAD, ph[1].flags = PF_R, ph[1].vaddr = EXE_BASE + 0x3000, ph[1].filesz = ph[1].memsz = 0x2000;
+    ph[2].type = prxParam ? PT_PROC_PRX_PARAM : 4, ph[2].flags = PF_R, ph[2].vaddr = address_of(exe, param), ph[2].filesz = ph[2].memsz = sizeof(PrxParam);
+
+    // 0x1008C is program header data of this ELF, the vsh.self table pointer would be garbage
+    CHECK(*(uint32_t*)(exe + 0x8C) == 0);
+
+    char* names = (char*)(exe + 0x3400);
+    strcpy(names, "cellSysutil");
+    strcpy(names + 0x10, "sysPrxForUser");
+    uint32_t* fnids = (uint32_t*)(exe + 0x3500);
+    uint32_t* stubs = (uint32_t*)(exe + 0x3600);
+    opd_s* opds = (opd_s*)(exe + 0x3700);
+    static const uint32_t sysutilFnids[] = { 0x9d98afa0, 0x189a74da };
+    static const uint32_t sysPrxFnids[] = { 0x744680a2, 0x42b23552, FNID_SYS_PRX_LOAD_MODULE, 0xa2c7ba64 };
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        fnids[i] = i < 2 ? sysutilFnids[i] : sysPrxFnids[i - 2];
+        opds[i].func = GAME_BASE + 0x1000 * (i + 1);
+        opds[i].toc = GAME_TOC;
+        stubs[i] = address_of(exe, &opds[i]);
+    }
+
+    ImportStub* imports = (ImportStub*)(exe + 0x3200);
+    imports[0].size = sizeof(ImportStub);
+    imports[0].functions = 2;
+    imports[0].name = address_of(exe, names);
+    imports[0].fnids = address_of(exe, fnids);
+    imports[0].stubs = address_of(exe, stubs);
+    imports[1].size = sizeof(ImportStub);
+    imports[1].functions = sysPrxFunctions;
+    imports[1].name = address_of(exe, names + 0x10);
+    imports[1].fnids = address_of(exe, fnids + 2);
+    imports[1].stubs = address_of(exe, stubs + 2);
+    // a stub past the end of the table isn't looked at
+    imports[2] = imports[1];
+    imports[2].functions = 4;
+
+    param->size = sizeof(PrxParam);
+    param->magic = 0x1b434cec;
+    param->version = 4;
+    param->libstubStart = address_of(exe, imports);
+    param->libstubEnd = address_of(exe, imports + 2);
+
+    // GetCurrentToc() reads the entry opd through 0x1001C
+    *(uint32_t*)(exe + 0x1C) = EXE_BASE + 0x100;
+    *(uint32_t*)(exe + 0x104) = GAME_TOC - 0x8000;
+}
+
+static void import_lookup(uint8_t* exe)
+{
+    const uint32_t pid = sys_process_getpid();
+    make_executable(exe, 4, true);
+    const opd_s* opds = (const opd_s*)(exe + 0x3700);
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == address_of(exe, &opds[4]));
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", 0xa2c7ba64) == address_of(exe, &opds[5]));
+    CHECK(ElfImportOpd(pid, EXE_BASE, "cellSysutil", 0x189a74da) == address_of(exe, &opds[1]));
+    // fnids are per library, names have to match whole
+    CHECK(ElfImportOpd(pid, EXE_BASE, "cellSysutil", FNID_SYS_PRX_LOAD_MODULE) == 0);
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUse", FNID_SYS_PRX_LOAD_MODULE) == 0);
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", 0xdeadbeef) == 0);
+    CHECK(ElfImportOpd(pid, EXE_BASE, NULL, FNID_SYS_PRX_LOAD_MODULE) == 0);
+
+    // the count of the stub bounds the search
+    make_executable(exe, 2, true);
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == 0);
+
+    // no PRX param header, or a bad magic, finds nothing
+    make_executable(exe, 4, false);
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == 0);
+    make_executable(exe, 4, true);
+    ((PrxParam*)(exe + 0x3100))->magic = 0;
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == 0);
+
+    // a stub table pointing at unmapped memory stops the walk
+    make_executable(exe, 4, true);
+    ((ImportStub*)(exe + 0x3200))->name = 0x30000000;
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == address_of(exe, (const opd_s*)(exe + 0x3700) + 4));
+    ((ImportStub*)(exe + 0x3200))->size = 0;
+    CHECK(ElfImportOpd(pid, EXE_BASE, "sysPrxForUser", FNID_SYS_PRX_LOAD_MODULE) == 0);
+}
+
+// deferred_hook_install hooks the function the import leads to
+static void install(uint8_t* exe, uint8_t* game)
+{
+    make_executable(exe, 4, true);
+    const uint32_t fn = GAME_BASE + 0x5000;  // opds[4]
+    static const uint32_t code[] = { 0x7C0802A6, 0xF8010010, 0xF821FF81, 0x38600000 };
+    memcpy(game + 0x5000, code, sizeof(code));
+
+    CHECK(deferred_hook_install());
+    CHECK(HookRegistry::GetCallbackCount(fn) == 1);
+    CHECK(memcmp(game + 0x5000, code, sizeof(code)) != 0);
+    CHECK(HookRegistry::GetCallbackCount(GAME_BASE + 0x6000) == 0);
+    // installed once
+    CHECK(deferred_hook_install());
+    CHECK(HookRegistry::GetCallbackCount(fn) == 1);
+}
+
+int test_main(void)
+{
+    uint8_t* exe = (uint8_t*)host_map(EXE_BASE, EXE_SIZE);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(exe != NULL && game != NULL);
+    if (!exe || !game)
+    {
+        return TEST_RESULT();
+    }
+
+    import_lookup(exe);
+    install(exe, game);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    host_unmap(EXE_BASE, EXE_SIZE);
+    return TEST_RESULT();
+}
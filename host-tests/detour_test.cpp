@@ -0,0 +1,179 @@
+// Detour stubs against hand assembled words, and the memory writes a hook costs.
+// Nothing runs the stubs here, they are only compared as instruction words.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/Detour.hpp"
+
+#include <string.h>
+
+#define EXE_BASE 0x10000
+#define GAME_BASE HOST_GAME_WINDOW_BASE
+#define GAME_SIZE 0x10000
+#define GAME_TOC 0x10208000
+#define BATCH 8
+
+static void check_words(const char* what, const uint32_t* actual, const uint32_t* expected, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (actual[i] != expected[i])
+        {
+            printf("%s word %zu: 0x%08x, expected 0x%08x\n", what, i, actual[i], expected[i]);
+            g_test_failures++;
+        }
+    }
+}
+
+static void encoders()
+{
+    uint32_t words[16];
+
+    // lis/ori/mtctr/bctr, r0 isn't saved
+    static const uint32_t jump[] = { 0x3C001234, 0x60005678, 0x7C0903A6, 0x4E800420 };
+    CHECK(PowerPCFarJump<false>::Encode(words, 0x12345678, PowerPCRegister::R0, POWERPC_BRANCH_OPTIONS_ALWAYS, 0, false) == sizeof(jump));
+    check_words("far jump", words, jump, 4);
+
+    // std/ld around it keep r0, bctrl calls
+    static const uint32_t call[] = { 0xF801FFD0, 0x3C001234, 0x60005678, 0x7C0903A6, 0xE801FFD0, 0x4E800421 };
+    CHECK(PowerPCFarJump<true>::Encode(words, 0x12345678, PowerPCRegister::R0, POWERPC_BRANCH_OPTIONS_ALWAYS, 0, true) == sizeof(call));
+    check_words("far call", words, call, 6);
+
+    // beqctr through r11
+    static const uint32_t beq[] = { 0x3D601234, 0x616B5678, 0x7D6903A6, 0x4D820420 };
+    PowerPCFarJump<false>::Encode(words, 0x12345678, PowerPCRegister::R11, 12, 2, false);
+    check_words("far beq", words, beq, 4);
+
+    // frame, r2 saved, opd loaded from the slot, call with its toc, r2 and the frame restored.
+    // The low half of the slot is a negative offset, @ha rounds the high half up.
+    static const uint32_t indirect[] = { 0x7C0802A6, 0xF8010010, 0xF821FF81, 0xF8410070, 0x3D801235, 0x818C8000, 0x800C0000, 0x804C0004,
+                                         0x7C0903A6, 0x4E800421, 0xE8410070, 0x38210080, 0xE8010010, 0x7C0803A6, 0x4E800020 };
+    CHECK(PowerPCIndirectCall::Encode(words, 0x12348000) == sizeof(indirect));
+    check_words("indirect call", words, indirect, 15);
+}
+
+// A function start with every kind of instruction the relocation cares about
+static void write_function(uint8_t* game, uint32_t offset)
+{
+    const uint32_t code[] = {
+        0x7C0802A6,  // mflr r0
+        0x48000101,  // bl +0x100
+        0x41820020,  // beq +0x20
+        0x48000102,  // ba 0x100, absolute stays as it is
+    };
+    memcpy(game + offset, code, sizeof(code));
+}
+
+static void trampoline(uint8_t* game)
+{
+    const uint32_t fn = GAME_BASE + 0x1000;
+    write_function(game, 0x1000);
+    static const opd_s callback = { GAME_BASE + 0x2000, GAME_TOC };
+
+    host_memory_stats_reset();
+    Detour detour;
+    detour.Hook(fn, (uintptr_t)&callback);
+    CHECK(detour.IsHooked());
+    // one read of the hook site, then the trampoline and the hook each go out in one write
+    CHECK(g_host_memory_stats.reads == 1);
+    CHECK(g_host_memory_stats.writes == 2);
+
+    static const uint32_t site[] = { 0x3C004000, 0x60002000, 0x7C0903A6, 0x4E800420 };
+    check_words("hook site", (const uint32_t*)(game + 0x1000), site, 4);
+
+    static const uint32_t expected[] = {
+        0x7C0802A6,
+        // bl to fn + 4 + 0x100, as a preserving far call
+        0xF801FFD0, 0x3C004000, 0x60001104, 0x7C0903A6, 0xE801FFD0, 0x4E800421,
+        // beq to fn + 8 + 0x20, BO and BI kept on the bcctr
+        0xF801FFD0, 0x3C004000, 0x60001028, 0x7C0903A6, 0xE801FFD0, 0x4D820420,
+        0x48000102,
+        // back to the instruction after the hook
+        0xF801FFD0, 0x3C004000, 0x60001010, 0x7C0903A6, 0xE801FFD0, 0x4E800420,
+    };
+    const uint32_t* opd = detour.GetOriginalOpd();
+    CHECK(opd[1] == GAME_TOC - 0x8000);
+    check_words("trampoline", (const uint32_t*)(uintptr_t)opd[0], expected, sizeof(expected) / sizeof(expected[0]));
+    CHECK(Detour::GetTrampolineStats().liveBytes == sizeof(expected));
+
+    host_memory_stats_reset();
+    CHECK(detour.UnHook());
+    CHECK(g_host_memory_stats.writes == 1);
+    CHECK(g_host_memory_stats.reads == 0);
+    uint8_t original[16];
+    memset(original, 0, sizeof(original));
+    write_function(original, 0);
+    CHECK(memcmp(game + 0x1000, original, sizeof(original)) == 0);
+    CHECK(Detour::GetTrampolineStats().liveBytes == 0);
+}
+
+static void batch(uint8_t* game)
+{
+    static const opd_s callback = { GAME_BASE + 0x2000, GAME_TOC };
+    Detour detours[BATCH];
+    Detour::HookRequest requests[BATCH];
+    for (uint32_t i = 0; i < BATCH; i++)
+    {
+        write_function(game, 0x4000 + i * 0x100);
+        requests[i].detour = &detours[i];
+        requests[i].fnAddress = GAME_BASE + 0x4000 + i * 0x100;
+        requests[i].fnCallback = (uintptr_t)&callback;
+        requests[i].tocOverride = 0;
+    }
+
+    // one read per site, every trampoline in a single write, one write per site
+    host_memory_stats_reset();
+    CHECK(Detour::HookBatch(requests, BATCH) == BATCH);
+    printf("HookBatch of %d: %llu reads, %llu writes (Hook one by one: %d and %d)\n", BATCH, (unsigned long long)g_host_memory_stats.reads,
+           (unsigned long long)g_host_memory_stats.writes, BATCH, BATCH * 2);
+    CHECK(g_host_memory_stats.reads == BATCH);
+    CHECK(g_host_memory_stats.writes == BATCH + 1);
+
+    // the trampolines were laid out back to back, each site jumps to the callback
+    for (uint32_t i = 0; i < BATCH; i++)
+    {
+        CHECK(detours[i].IsHooked());
+        CHECK(detours[i].GetOriginalOpd()[0] == detours[0].GetOriginalOpd()[0] + i * 80);
+        CHECK(*(const uint32_t*)(game + 0x4000 + i * 0x100 + 4) == 0x60002000);
+    }
+
+    for (uint32_t i = 0; i < BATCH; i++)
+    {
+        CHECK(detours[i].UnHook());
+        CHECK(*(const uint32_t*)(game + 0x4000 + i * 0x100 + 4) == 0x48000101);
+    }
+    CHECK(Detour::GetTrampolineStats().liveBytes == 0);
+
+    // an unreadable site fails alone
+    requests[3].fnAddress = 0x30000000;
+    host_memory_stats_reset();
+    CHECK(Detour::HookBatch(requests, BATCH) == BATCH - 1);
+    CHECK(!detours[3].IsHooked());
+    CHECK(detours[4].IsHooked());
+    for (uint32_t i = 0; i < BATCH; i++)
+    {
+        detours[i].UnHook();
+    }
+    CHECK(Detour::GetTrampolineStats().liveBytes == 0);
+}
+
+int test_main(void)
+{
+    // GetCurrentToc() follows e_entry of the executable to its opd
+    uint8_t* exe = (uint8_t*)host_map(EXE_BASE, 0x1000);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(exe != NULL && game != NULL);
+    if (!exe || !game)
+    {
+        return TEST_RESULT();
+    }
+    *(uint32_t*)(exe + 0x1C) = EXE_BASE + 0x100;
+    *(uint32_t*)(exe + 0x104) = GAME_TOC - 0x8000;
+
+    encoders();
+    trampoline(game);
+    batch(game);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    host_unmap(EXE_BASE, 0x1000);
+    return TEST_RESULT();
+}
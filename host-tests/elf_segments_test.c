@@ -0,0 +1,219 @@
+// ElfCodeSegments, PrxCodeSegments and SignatureScanSegments over ELF fixtures mapped in the
+// fake game. The headers are in host byte order, the code reads them natively like the console.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/ElfSegments.h"
+
+#include <string.h>
+#include <sys/process.h>
+
+#define IMAGE_BASE HOST_GAME_WINDOW_BASE
+#define IMAGE_SIZE 0x100000
+
+#define PT_LOAD 1
+#define PT_NOTE 4
+#define PT_TLS 7
+#define PF_X 1
+#define PF_W 2
+#define PF_R 4
+
+typedef struct
+{
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} Elf64Header;
+
+typedef struct
+{
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} Elf64Phdr;
+
+typedef struct
+{
+    uint32_t type;
+    uint32_t flags;
+    uint32_t vaddr;
+    uint32_t memsz;
+} Segment;
+
+static Elf64Header* make_elf(uint8_t* image, uint32_t phoff, const Segment* segments, uint16_t count)
+{
+    memset(image, 0, 0x1000);
+    Elf64Header* eh = (Elf64Header*)image;
+    memcpy(eh->e_ident, "\x7f" "ELF\x02\x02\x01", 7);  // 64 bit, big endian
+    eh->e_type = 2;
+    eh->e_machine = 0x15;  // PPC64
+    eh->e_phoff = phoff;
+    eh->e_ehsize = sizeof(Elf64Header);
+    eh->e_phentsize = sizeof(Elf64Phdr);
+    eh->e_phnum = count;
+
+    Elf64Phdr* ph = (Elf64Phdr*)(image + phoff);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        ph[i].p_type = segments[i].type;
+        ph[i].p_flags = segments[i].flags;
+        ph[i].p_vaddr = ph[i].p_paddr = segments[i].vaddr;
+        ph[i].p_filesz = ph[i].p_memsz = segments[i].memsz;
+        ph[i].p_align = 0x10000;
+    }
+    return eh;
+}
+
+static size_t code_segments(CodeSegment* out, size_t max)
+{
+    return ElfCodeSegments(sys_process_getpid(), IMAGE_BASE, out, max);
+}
+
+// The layout of an EBOOT: text, data, then a TLS and a note header that aren't loaded on their own
+static void executable(uint8_t* image)
+{
+    static const Segment layout[] = {
+        { PT_LOAD, PF_R | PF_X, 0x10000, 0x5f0000 },
+        { PT_LOAD, PF_R | PF_W, 0x610000, 0x80000 },
+        { PT_TLS, PF_R, 0x690000, 0x100 },
+        { PT_NOTE, PF_R | PF_X, 0, 0x40 },
+        { PT_LOAD, PF_R | PF_X, 0x700000, 0x20000 },
+        { PT_LOAD, PF_R | PF_X, 0x800000, 0 },  // nothing to scan
+    };
+    make_elf(image, sizeof(Elf64Header), layout, 6);
+
+    CodeSegment segments[CODE_SEGMENTS_MAX];
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 2);
+    CHECK(segments[0].base == 0x10000 && segments[0].size == 0x5f0000);
+    CHECK(segments[1].base == 0x700000 && segments[1].size == 0x20000);
+
+    // the caller's capacity is respected
+    memset(segments, 0, sizeof(segments));
+    CHECK(code_segments(segments, 1) == 1);
+    CHECK(segments[0].base == 0x10000 && segments[1].size == 0);
+
+    // program headers placed away from the elf header
+    make_elf(image, 0x800, layout, 6);
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 2);
+    CHECK(segments[1].base == 0x700000);
+
+    // the most program headers the reader takes
+    Segment many[32];
+    for (uint16_t i = 0; i < 32; i++)
+    {
+        many[i].type = PT_LOAD;
+        many[i].flags = (i & 1) ? PF_R | PF_W : PF_R | PF_X;
+        many[i].vaddr = 0x10000 * (i + 1);
+        many[i].memsz = 0x1000;
+    }
+    make_elf(image, sizeof(Elf64Header), many, 32);
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == CODE_SEGMENTS_MAX);
+    CHECK(segments[CODE_SEGMENTS_MAX - 1].base == 0x10000 * (2 * CODE_SEGMENTS_MAX - 1));
+}
+
+// Anything that isn't an ELF64 big endian image with the expected header size lists nothing
+static void malformed(uint8_t* image)
+{
+    static const Segment text = { PT_LOAD, PF_R | PF_X, 0x10000, 0x1000 };
+    CodeSegment segments[CODE_SEGMENTS_MAX];
+
+    make_elf(image, sizeof(Elf64Header), &text, 1);
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 1);
+
+    Elf64Header* eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_ident[1] = 'X';
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_ident[4] = 1;  // 32 bit
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_ident[5] = 1;  // little endian
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_phentsize = 0x20;
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_phnum = 0;
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_phnum = 33;
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    // headers pointing outside mapped memory
+    eh = make_elf(image, sizeof(Elf64Header), &text, 1);
+    eh->e_phoff = 0x30000000;
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+
+    memset(image, 0, 0x1000);
+    CHECK(code_segments(segments, CODE_SEGMENTS_MAX) == 0);
+}
+
+static void prx(void)
+{
+    CodeSegment segments[CODE_SEGMENTS_MAX];
+    const int32_t id = host_module_add("/dev_flash/sys/external/libsysutil.sprx", 0x01000000, 0x8000, 0x01010000, 0x1000);
+    CHECK(PrxCodeSegments(sys_process_getpid(), id, segments, CODE_SEGMENTS_MAX) == 1);
+    CHECK(segments[0].base == 0x01000000 && segments[0].size == 0x8000);
+    CHECK(PrxCodeSegments(sys_process_getpid(), id, segments, 0) == 0);
+    CHECK(PrxCodeSegments(sys_process_getpid(), 0x7fffffff, segments, CODE_SEGMENTS_MAX) == 0);
+    host_modules_clear();
+}
+
+static void scan_segments(uint8_t* image)
+{
+    static const uint8_t bytes[] = { 0x7c, 0x08, 0x02, 0xa6, 0xf8, 0x01, 0x00, 0x10 };
+    const Signature signature = { bytes, NULL, sizeof(bytes), 8, NULL };
+    CodeSegment segments[2] = { { IMAGE_BASE + 0x1000, 0x4000 }, { IMAGE_BASE + 0x20000, 0x4000 } };
+    const uint32_t pid = sys_process_getpid();
+
+    memset(image, 0, IMAGE_SIZE);
+    // between the segments: not code, not found
+    memcpy(image + 0x10000, bytes, sizeof(bytes));
+    CHECK(SignatureScanSegments(pid, segments, 2, &signature) == 0);
+
+    memcpy(image + 0x22000, bytes, sizeof(bytes));
+    CHECK(SignatureScanSegments(pid, segments, 2, &signature) == IMAGE_BASE + 0x22000 + 8);
+
+    // the first segment wins
+    memcpy(image + 0x1100, bytes, sizeof(bytes));
+    CHECK(SignatureScanSegments(pid, segments, 2, &signature) == IMAGE_BASE + 0x1100 + 8);
+    CHECK(SignatureScanSegments(pid, segments, 0, &signature) == 0);
+}
+
+int test_main(void)
+{
+    uint8_t* image = (uint8_t*)host_map(IMAGE_BASE, IMAGE_SIZE);
+    CHECK(image != NULL);
+    if (!image)
+    {
+        return TEST_RESULT();
+    }
+
+    executable(image);
+    malformed(image);
+    prx();
+    scan_segments(image);
+
+    host_unmap(IMAGE_BASE, IMAGE_SIZE);
+    return TEST_RESULT();
+}
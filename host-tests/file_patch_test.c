@@ -0,0 +1,103 @@
+// File backed patches: checksum validation and streaming into simulated memory
+#include "host_test.h"
+#include "host_lv2.h"
+#include "patch_plan.h"
+#include "../shared/stringid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAME_BASE 0x40000000
+#define GAME_SIZE 0x01000000
+#define BLOB_PATH "blobs/level.bin"
+#define BLOB_HEADER 0x100
+#define BLOB_SIZE (8 * 1024 * 1024)
+#define BENCH_ROUNDS 8
+
+static uint8_t* make_blob(size_t size)
+{
+    uint8_t* blob = (uint8_t*)malloc(size);
+    uint32_t x = 0x9e3779b9;
+    for (size_t i = 0; i < size; i++)
+    {
+        x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+        blob[i] = (uint8_t)x;
+    }
+    return blob;
+}
+
+static void apply_file(uint32_t addr, uint32_t offset, uint32_t size, uint32_t checksum)
+{
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    CHECK(patch_plan_add_file(&plan, 0x1234, 0, addr, BLOB_PATH, offset, size, checksum));
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+    patch_plan_free(&plan);
+}
+
+static uint32_t chunks(uint32_t size)
+{
+    return (size + PATCH_FILE_CHUNK_SIZE - 1) / PATCH_FILE_CHUNK_SIZE;
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    const size_t file_size = BLOB_HEADER + BLOB_SIZE;
+    uint8_t* blob = make_blob(file_size);
+    CHECK(host_fs_write(GAME_PATCH_DATA_PATH "/" BLOB_PATH, blob, file_size) == 0);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+
+    // fits in one chunk: one write
+    const uint32_t small = 0x1000;
+    host_memory_stats_reset();
+    apply_file(GAME_BASE, BLOB_HEADER, small, memid(blob + BLOB_HEADER, small, 0));
+    CHECK(memcmp(game, blob + BLOB_HEADER, small) == 0);
+    CHECK(g_host_memory_stats.writes == 1);
+
+    // streamed, one write per chunk
+    const uint32_t odd = 3 * PATCH_FILE_CHUNK_SIZE + 0x123;
+    host_memory_stats_reset();
+    apply_file(GAME_BASE + 0x100000, BLOB_HEADER + 7, odd, memid(blob + BLOB_HEADER + 7, odd, 0));
+    CHECK(memcmp(game + 0x100000, blob + BLOB_HEADER + 7, odd) == 0);
+    CHECK(g_host_memory_stats.writes == chunks(odd));
+    CHECK(g_host_memory_stats.written_bytes == odd);
+
+    // nothing is written when the checksum doesn't match
+    memset(game, 0, GAME_SIZE);
+    host_memory_stats_reset();
+    apply_file(GAME_BASE, BLOB_HEADER, odd, memid(blob + BLOB_HEADER, odd, 0) ^ 1);
+    CHECK(g_host_memory_stats.writes == 0);
+
+    // nor when the file is shorter than the range
+    apply_file(GAME_BASE, file_size - 0x10, 0x20, memid(blob + file_size - 0x10, 0x10, 0));
+    CHECK(g_host_memory_stats.writes == 0);
+
+    // a missing file
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    CHECK(patch_plan_add_file(&plan, 0x1234, 0, GAME_BASE, "blobs/missing.bin", 0, 0x10, 0));
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+    patch_plan_free(&plan);
+    CHECK(g_host_memory_stats.writes == 0);
+
+    // whole blob: hashing pass plus streaming pass
+    const uint32_t checksum = memid(blob + BLOB_HEADER, BLOB_SIZE, 0);
+    const uint64_t start = host_time_ns();
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+    {
+        apply_file(GAME_BASE, BLOB_HEADER, BLOB_SIZE, checksum);
+    }
+    const double seconds = (double)(host_time_ns() - start) / 1e9 / BENCH_ROUNDS;
+    CHECK(memcmp(game, blob + BLOB_HEADER, BLOB_SIZE) == 0);
+    printf("file patch of %d MB: %.2f ms, %.0f MB/s\n", BLOB_SIZE >> 20, seconds * 1e3, BLOB_SIZE / seconds / (1024 * 1024));
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    free(blob);
+    return TEST_RESULT();
+}
@@ -0,0 +1,121 @@
+// exe_image_fingerprint() over a synthetic 30 MB executable. The headers are in
+// host byte order here, the hash only cares that they parse.
+#include "host_test.h"
+#include "fingerprint.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGE_VADDR 0x10000
+#define TEXT_SIZE (28 * 1024 * 1024)
+#define DATA_SIZE (2 * 1024 * 1024)
+#define IMAGE_SIZE (TEXT_SIZE + DATA_SIZE)
+#define BENCH_ROUNDS 200
+
+typedef struct
+{
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} Elf64Header;
+
+typedef struct
+{
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} Elf64Phdr;
+
+static uint8_t* make_image(void)
+{
+    uint8_t* image = (uint8_t*)malloc(IMAGE_SIZE);
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+    {
+        x = x * 1103515245 + 12345;
+        image[i] = (uint8_t)(x >> 16);
+    }
+
+    Elf64Header* eh = (Elf64Header*)image;
+    memset(eh, 0, sizeof(*eh));
+    memcpy(eh->e_ident, "\x7f" "ELF", 4);
+    eh->e_phoff = sizeof(*eh);
+    eh->e_phentsize = sizeof(Elf64Phdr);
+    eh->e_phnum = 2;
+
+    Elf64Phdr* ph = (Elf64Phdr*)(image + eh->e_phoff);
+    memset(ph, 0, 2 * sizeof(*ph));
+    ph[0].p_type = 1;  // PT_LOAD
+    ph[0].p_flags = 5;  // R+X
+    ph[0].p_vaddr = IMAGE_VADDR;
+    ph[0].p_filesz = ph[0].p_memsz = TEXT_SIZE;
+    ph[1].p_type = 1;
+    ph[1].p_flags = 6;  // R+W
+    ph[1].p_offset = TEXT_SIZE;
+    ph[1].p_vaddr = IMAGE_VADDR + TEXT_SIZE;
+    ph[1].p_filesz = ph[1].p_memsz = DATA_SIZE;
+    return image;
+}
+
+int test_main(void)
+{
+    uint8_t* image = make_image();
+    const uint64_t base = exe_image_fingerprint(image, IMAGE_VADDR);
+    CHECK(base != 0);
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) == base);
+
+    // first pages of the code are hashed whole
+    image[0x2000] ^= 1;
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) != base);
+    image[0x2000] ^= 1;
+
+    // the tail of the code segment is always sampled
+    image[TEXT_SIZE - 8] ^= 1;
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) != base);
+    image[TEXT_SIZE - 8] ^= 1;
+
+    // data isn't part of the fingerprint
+    image[TEXT_SIZE + 0x100] ^= 1;
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) == base);
+    image[TEXT_SIZE + 0x100] ^= 1;
+
+    // a longer build of the same code
+    Elf64Phdr* ph = (Elf64Phdr*)(image + sizeof(Elf64Header));
+    ph[0].p_filesz -= 0x1000;
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) != base);
+    ph[0].p_filesz += 0x1000;
+
+    memset(image, 0, 4);
+    CHECK(exe_image_fingerprint(image, IMAGE_VADDR) == 0);
+    memcpy(image, "\x7f" "ELF", 4);
+
+    uint64_t sink = 0;
+    const uint64_t start = host_time_ns();
+    for (int i = 0; i < BENCH_ROUNDS; i++)
+    {
+        sink += exe_image_fingerprint(image, IMAGE_VADDR);
+    }
+    const double us = (double)(host_time_ns() - start) / BENCH_ROUNDS / 1000.0;
+    printf("fingerprint of a %d MB image: %.1f us (%llx)\n", IMAGE_SIZE >> 20, us, (unsigned long long)sink);
+    // sampling keeps it independent of the image size, stays far below 1 ms
+    CHECK(us < 1000.0);
+
+    free(image);
+    return TEST_RESULT();
+}
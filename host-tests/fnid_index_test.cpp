@@ -0,0 +1,153 @@
+// FnidIndex built from synthetic stub tables: same answers as walking the tables, library
+// names whose hashes collide kept apart, and short probe runs on a large table.
+#include "host_test.h"
+#include "Memory/FnidIndex.hpp"
+#include "../shared/stringid.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MODULES 400
+#define FNIDS_PER_MODULE 24
+
+static uint32_t s_seed = 0x1badb002;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static exportStub_s make_export(const char* name, uint32_t* fnids, opd_s** stubs, int16_t count)
+{
+    exportStub_s stub;
+    memset(&stub, 0, sizeof(stub));
+    stub.ssize = 0x1C00;
+    stub.exports = count;
+    stub.name = name;
+    stub.fnid = fnids;
+    stub.stub = stubs;
+    return stub;
+}
+
+static importStub_s make_import(const char* name, uint32_t* fnids, opd_s** stubs, int16_t count)
+{
+    importStub_s stub;
+    memset(&stub, 0, sizeof(stub));
+    stub.ssize = 0x2C00;
+    stub.imports = count;
+    stub.name = name;
+    stub.fnid = fnids;
+    stub.stub = stubs;
+    return stub;
+}
+
+// What FindExportByName did before the index
+static opd_s* walk_exports(const exportStub_s* stub, const char* module, uint32_t fnid)
+{
+    for (; stub->ssize == 0x1C00; stub++)
+    {
+        for (int16_t i = 0; !strcmp(module, stub->name) && i < stub->exports; i++)
+        {
+            if (stub->fnid[i] == fnid)
+            {
+                return stub->stub[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+static void collisions()
+{
+    // both hash to 0x5663862e with stringid()
+    static const char first[] = "cellLib189db";
+    static const char second[] = "cellLib57828";
+    static opd_s opds[6];
+    static uint32_t sharedFnid[] = { 0x9d98afa0 };
+    static opd_s* firstStubs[] = { &opds[0] };
+    static opd_s* secondStubs[] = { &opds[1] };
+    static uint32_t sysutilFnids[] = { 0x9d98afa0, 0x189a74da, 0x9d98afa0 };
+    static opd_s* sysutilStubs[] = { &opds[2], &opds[3], &opds[4] };
+
+    CHECK(stringid(first, 0) == stringid(second, 0));
+    exportStub_s exports[] = {
+        make_export(first, sharedFnid, firstStubs, 1),
+        make_export(second, sharedFnid, secondStubs, 1),
+        make_export("", nullptr, nullptr, 0),
+    };
+    exports[2].ssize = 0;
+    importStub_s imports[] = {
+        make_import("cellSysutil", sysutilFnids, sysutilStubs, 3),
+        make_import(first, sharedFnid, secondStubs, 1),
+        make_import("", nullptr, nullptr, 0),
+    };
+    imports[2].ssize = 0;
+
+    FnidIndex index;
+    CHECK(index.Build(exports, imports));
+    CHECK(index.GetStats().entries == 5);
+    CHECK(index.Find(FnidIndex::Export, first, 0x9d98afa0) == &opds[0]);
+    CHECK(index.Find(FnidIndex::Export, second, 0x9d98afa0) == &opds[1]);
+    CHECK(index.Find(FnidIndex::Import, first, 0x9d98afa0) == &opds[1]);
+    CHECK(index.Find(FnidIndex::Import, second, 0x9d98afa0) == nullptr);
+    CHECK(index.Find(FnidIndex::Export, "cellLib00000", 0x9d98afa0) == nullptr);
+
+    // the first stub wins for a repeated fnid, kinds don't mix
+    CHECK(index.Find(FnidIndex::Import, "cellSysutil", 0x9d98afa0) == &opds[2]);
+    CHECK(index.Find(FnidIndex::Import, "cellSysutil", 0x189a74da) == &opds[3]);
+    CHECK(index.Find(FnidIndex::Export, "cellSysutil", 0x189a74da) == nullptr);
+    CHECK(index.Find(FnidIndex::Import, nullptr, 0x189a74da) == nullptr);
+
+    index.Clear();
+    CHECK(!index.IsBuilt());
+    CHECK(index.Find(FnidIndex::Import, "cellSysutil", 0x189a74da) == nullptr);
+}
+
+static void large_table()
+{
+    static char names[MODULES][16];
+    static uint32_t fnids[MODULES][FNIDS_PER_MODULE];
+    static opd_s opds[MODULES][FNIDS_PER_MODULE];
+    static opd_s* stubs[MODULES][FNIDS_PER_MODULE];
+    static exportStub_s exports[MODULES + 1];
+
+    for (uint32_t m = 0; m < MODULES; m++)
+    {
+        snprintf(names[m], sizeof(names[m]), "lib%u", m % (MODULES / 2));  // every name twice, like a library exported in two parts
+        for (uint32_t i = 0; i < FNIDS_PER_MODULE; i++)
+        {
+            fnids[m][i] = i < 4 ? 0x1000 + i : next_random();  // a few fnids every module has
+            opds[m][i].func = m * FNIDS_PER_MODULE + i;
+            stubs[m][i] = &opds[m][i];
+        }
+        exports[m] = make_export(names[m], fnids[m], stubs[m], FNIDS_PER_MODULE);
+    }
+    memset(&exports[MODULES], 0, sizeof(exports[MODULES]));
+
+    FnidIndex index;
+    CHECK(index.Build(exports, nullptr));
+    uint32_t mismatches = 0;
+    for (uint32_t m = 0; m < MODULES; m++)
+    {
+        for (uint32_t i = 0; i < FNIDS_PER_MODULE; i++)
+        {
+            mismatches += index.Find(FnidIndex::Export, names[m], fnids[m][i]) != walk_exports(exports, names[m], fnids[m][i]);
+        }
+        mismatches += index.Find(FnidIndex::Export, names[m], 0xdeadbeef) != nullptr;
+    }
+    CHECK(mismatches == 0);
+
+    const FnidIndex::Stats& stats = index.GetStats();
+    const double probes = (double)stats.probes / stats.lookups;
+    printf("%u entries in %u slots, %.2f probes per lookup\n", stats.entries, stats.capacity, probes);
+    CHECK(stats.capacity >= stats.entries * 2);
+    CHECK(probes < 2.0);
+}
+
+int test_main(void)
+{
+    collisions();
+    large_table();
+    return TEST_RESULT();
+}
@@ -0,0 +1,95 @@
+// HookRegistry: callbacks chained in priority order, one detour per function however many are
+// added, and the function back to its own code once the last one goes.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/HookRegistry.hpp"
+
+#include <string.h>
+
+#define EXE_BASE 0x10000
+#define GAME_BASE HOST_GAME_WINDOW_BASE
+#define GAME_SIZE 0x10000
+#define GAME_TOC 0x10208000
+
+static void write_function(uint8_t* game, uint32_t offset)
+{
+    const uint32_t code[] = { 0x7C0802A6, 0x48000101, 0x38600000, 0x4E800020 };  // mflr r0, bl +0x100, li r3,0, blr
+    memcpy(game + offset, code, sizeof(code));
+}
+
+static void chaining(uint8_t* game)
+{
+    const uint32_t fn = GAME_BASE + 0x1000;
+    write_function(game, 0x1000);
+    uint8_t original[Detour::HookSize];
+    memcpy(original, game + 0x1000, sizeof(original));
+    static const opd_s callbacks[] = { { GAME_BASE + 0x2000, GAME_TOC }, { GAME_BASE + 0x3000, GAME_TOC + 0x100 }, { GAME_BASE + 0x4000, GAME_TOC } };
+
+    host_memory_stats_reset();
+    HookRegistry::Handle a = HookRegistry::Add(fn, (uintptr_t)&callbacks[0]);
+    CHECK(a != nullptr);
+    if (!a)
+    {
+        return;
+    }
+    const uint64_t writes = g_host_memory_stats.writes;
+    const uint32_t site[] = { *(const uint32_t*)(game + 0x1000), *(const uint32_t*)(game + 0x1004) };
+    CHECK(memcmp(game + 0x1000, original, sizeof(original)) != 0);
+
+    // b runs first, c after a, the last one reaches the original through the trampoline
+    HookRegistry::Handle b = HookRegistry::Add(fn, (uintptr_t)&callbacks[1], 10);
+    HookRegistry::Handle c = HookRegistry::Add(fn, (uintptr_t)&callbacks[2]);
+    CHECK(b != nullptr && c != nullptr);
+    CHECK(HookRegistry::GetCallbackCount(fn) == 3);
+    CHECK(g_host_memory_stats.writes == writes);
+    CHECK(*(const uint32_t*)(game + 0x1000) == site[0] && *(const uint32_t*)(game + 0x1004) == site[1]);
+    CHECK(b->next == a->opd);
+    CHECK(a->next == c->opd);
+    const uint32_t* originalOpd = c->next;
+    CHECK(b->opd[0] == GAME_BASE + 0x3000 && b->opd[1] == GAME_TOC + 0x100);
+
+    // the thunk the site jumps to loads the opd the head points at, with its toc
+    const uint32_t* thunk = (const uint32_t*)(uintptr_t)((site[0] & 0xffff) << 16 | (site[1] & 0xffff));
+    uint32_t words[PowerPCIndirectCall::Count];
+    PowerPCIndirectCall::Encode(words, 0);
+    CHECK(thunk[0] == words[0] && thunk[3] == words[3]);
+    CHECK(thunk[6] == 0x800C0000 && thunk[7] == 0x804C0004);
+    CHECK(thunk[PowerPCIndirectCall::Count - 1] == 0x4E800020);
+
+    // removing from the middle relinks around it, the removed one keeps its next
+    CHECK(HookRegistry::Remove(a));
+    CHECK(!HookRegistry::Remove(a));
+    CHECK(b->next == c->opd);
+    CHECK(a->next == c->opd);
+    CHECK(HookRegistry::GetCallbackCount(fn) == 2);
+
+    CHECK(HookRegistry::Remove(b));
+    CHECK(HookRegistry::Remove(c));
+    CHECK(HookRegistry::GetCallbackCount(fn) == 0);
+    CHECK(memcmp(game + 0x1000, original, sizeof(original)) == 0);
+
+    // the site is kept, hooking it again refills the same original opd with a fresh trampoline
+    HookRegistry::Handle d = HookRegistry::Add(fn, (uintptr_t)&callbacks[0]);
+    CHECK(d != nullptr && d->next == originalOpd && originalOpd[0] != 0);
+    CHECK(HookRegistry::Remove(d));
+    CHECK(memcmp(game + 0x1000, original, sizeof(original)) == 0);
+}
+
+int test_main(void)
+{
+    uint8_t* exe = (uint8_t*)host_map(EXE_BASE, 0x1000);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(exe != NULL && game != NULL);
+    if (!exe || !game)
+    {
+        return TEST_RESULT();
+    }
+    *(uint32_t*)(exe + 0x1C) = EXE_BASE + 0x100;
+    *(uint32_t*)(exe + 0x104) = GAME_TOC - 0x8000;
+
+    chaining(game);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    host_unmap(EXE_BASE, 0x1000);
+    return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+// Hot reload against a boot plan whose overlaps were already resolved. What counts as applied
+// comes from the journal, so a prx patch whose module isn't loaded yet isn't.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "hot_reload.h"
+#include "journal.h"
+#include "patch.h"
+#include "patch_overlap.h"
+#include "patch_plan.h"
+
+#include <string.h>
+#include <sys/timer.h>
+
+#define GAME_BASE 0x40000000
+#define GAME_SIZE 0x10000
+#define EXE_BASE 0x10000  // EXE_ELF_BASE, a reload fingerprints the executable
+#define PATCH_YML_PATH GAME_PATCH_FILES_PATH "/BLES00001.yml"
+#define SETTINGS_PATH GAME_PATCH_SETTINGS "/BLES00001.bin"
+#define WAIT_US (3 * 1000 * 1000)
+#define LIB_PATH "/dev_hdd0/game/BLES00001/USRDIR/libgame.sprx"
+#define LIB_TEXT 0x8000  // from GAME_BASE
+
+// "Loser" is shadowed by "Winner" everywhere, "Late" is turned on while the game runs,
+// "Prx" targets a module that is loaded after it's turned on
+static const char* s_yml =
+    "titleid: [\"BLES00001\"]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Loser\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x40000000\", \"0x11111111\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Winner\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x40000000\", \"0x22222222\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Late\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x40000100\", \"0x33333333\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Prx\"\n"
+    "  app_bin: \"libgame.sprx\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x100\", \"0x44444444\" ]\n";
+
+static uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static bool wait_for(const uint8_t* p, uint32_t value)
+{
+    for (uint32_t waited = 0; waited < WAIT_US; waited += 10000)
+    {
+        if (read32(p) == value)
+        {
+            return true;
+        }
+        sys_timer_usleep(10000);
+    }
+    return false;
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    CHECK(host_fs_write(PATCH_YML_PATH, s_yml, strlen(s_yml)) == 0);
+    CHECK(host_fs_write(GAME_PATCH_HOT_RELOAD_PATH, "100", 3) == 0);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(game != NULL);
+    // no ELF there, the fingerprint is just 0
+    CHECK(host_map(EXE_BASE, 0x1000) != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+
+    GamePatchInfo info;
+    memset(&info, 0, sizeof(info));
+    strcpy(info.titleid, "BLES00001");
+    strcpy(info.app_ver, "01.00");
+
+    PatchPlan all;
+    patch_plan_init(&all);
+    CHECK(build_patch_plan(&info, PATCH_YML_PATH, 0, true, &all) == 0);
+    CHECK(all.record_count == 4);
+    if (all.record_count != 4)
+    {
+        return TEST_RESULT();
+    }
+    const uint32_t loser = all.records[0].hash;
+    const uint32_t winner = all.records[1].hash;
+    const uint32_t late = all.records[2].hash;
+    const uint32_t prx = all.records[3].hash;
+    patch_plan_free(&all);
+    CHECK(toggle_patch_state(SETTINGS_PATH, loser) == 1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, winner) == 1);
+
+    // the boot path, as run_patch does it
+    CHECK(hot_reload_init());
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    CHECK(build_patch_plan(&info, PATCH_YML_PATH, 0, false, &plan) == 0);
+    patch_plan_resolve_overlaps(&plan);
+    CHECK(plan.record_count == 1);
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+    patch_plan_free(&plan);
+    CHECK(read32(game) == 0x22222222);
+    CHECK(hot_reload_start(&info, PATCH_YML_PATH, SETTINGS_PATH));
+
+    // turning on another patch must not bring back the loser's bytes
+    CHECK(toggle_patch_state(SETTINGS_PATH, late) == 1);
+    CHECK(wait_for(game + 0x100, 0x33333333));
+    CHECK(read32(game) == 0x22222222);
+
+    // off again: its original bytes come back. Same size, so the mtime (in seconds) has to change
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, late) == 0);
+    CHECK(wait_for(game + 0x100, 0));
+    CHECK(read32(game) == 0x22222222);
+
+    // on while its module isn't loaded: nothing written, so nothing applied
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, prx) == 1);
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, late) == 1);
+    CHECK(wait_for(game + 0x100, 0x33333333));
+    CHECK(read32(game + LIB_TEXT + 0x100) == 0);
+
+    // once it is, the next reload writes it
+    CHECK(host_module_add(LIB_PATH, GAME_BASE + LIB_TEXT, 0x1000, GAME_BASE + LIB_TEXT + 0x1000, 0x1000) != 0);
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, late) == 0);
+    CHECK(wait_for(game + 0x100, 0));
+    CHECK(wait_for(game + LIB_TEXT + 0x100, 0x44444444));
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, prx) == 0);
+    CHECK(wait_for(game + LIB_TEXT + 0x100, 0));
+
+    // the loser never wrote anything, with the winner off it gets its bytes
+    sys_timer_sleep(1);
+    CHECK(toggle_patch_state(SETTINGS_PATH, winner) == 0);
+    CHECK(wait_for(game, 0x11111111));
+    host_modules_clear();
+
+    return TEST_RESULT();
+}
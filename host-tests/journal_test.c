@@ -0,0 +1,218 @@
+// Layered patches reverted in random order against a replay of the ones still applied, and a
+// large journal where a revert may only touch the entries over the bytes it writes back
+#include "host_test.h"
+#include "host_lv2.h"
+#include "journal.h"
+#include "Memory/Memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/process.h>
+
+#define GAME_BASE 0x40000000
+#define AREA 256
+#define PATCHES 24
+#define MAX_RANGES 3
+#define ROUNDS 200
+#define SCALE_RANGES 8192
+#define SCALE_PATCHES 128  // JOURNAL_MAX_PATCHES is shared with the later ones
+#define SCALE_SIZE 16
+#define SCALE_AREA (SCALE_RANGES * SCALE_SIZE * 2)
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t range_count;
+    uint32_t addr[MAX_RANGES];
+    uint32_t size[MAX_RANGES];
+    uint8_t value;
+    bool live;
+} TestPatch;
+
+static uint32_t s_seed = 0x12345678;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static void write_patch(const TestPatch* p)
+{
+    uint8_t buf[AREA];
+    memset(buf, p->value, sizeof(buf));
+    for (uint32_t r = 0; r < p->range_count; r++)
+    {
+        WriteProcessMemory(sys_process_getpid(), (void*)(GAME_BASE + p->addr[r]), buf, p->size[r]);
+    }
+}
+
+// what the game should show: the original with the live patches written in the order they were applied
+static void expected(const TestPatch* patches, const uint8_t* original, uint8_t* out)
+{
+    memcpy(out, original, AREA);
+    for (size_t i = 0; i < PATCHES; i++)
+    {
+        for (uint32_t r = 0; patches[i].live && r < patches[i].range_count; r++)
+        {
+            memset(out + patches[i].addr[r], patches[i].value, patches[i].size[r]);
+        }
+    }
+}
+
+static bool run_round(uint8_t* game)
+{
+    uint8_t original[AREA];
+    for (size_t i = 0; i < AREA; i++)
+    {
+        original[i] = game[i] = (uint8_t)next_random();
+    }
+
+    static PatchJournal journal;
+    journal_init(&journal);
+    TestPatch patches[PATCHES];
+    for (size_t i = 0; i < PATCHES; i++)
+    {
+        TestPatch* p = &patches[i];
+        p->hash = 0x1000 + i;
+        p->value = (uint8_t)(0x80 + i);
+        p->range_count = 1 + next_random() % MAX_RANGES;
+        for (uint32_t r = 0; r < p->range_count; r++)
+        {
+            p->size[r] = 1 + next_random() % 32;
+            p->addr[r] = next_random() % (AREA - p->size[r]);
+            journal_reserve(&journal, p->hash, GAME_BASE + p->addr[r], p->size[r]);
+        }
+        journal_commit(&journal);
+        write_patch(p);
+        p->live = true;
+    }
+
+    bool ok = true;
+    uint8_t want[AREA];
+    for (size_t left = PATCHES; left > 0 && ok; left--)
+    {
+        // one or two at a time, like hot reload turning patches off
+        uint32_t off[2];
+        size_t off_count = 0;
+        for (size_t n = 1 + next_random() % 2; n > 0 && off_count < left; n--)
+        {
+            size_t pick;
+            do
+            {
+                pick = next_random() % PATCHES;
+            } while (!patches[pick].live);
+            patches[pick].live = false;
+            off[off_count++] = patches[pick].hash;
+        }
+        left -= off_count - 1;
+        journal_revert_set(&journal, off, off_count);
+        expected(patches, original, want);
+        ok = memcmp(game, want, AREA) == 0;
+    }
+    journal_free(&journal);
+    return ok && memcmp(game, original, AREA) == 0;
+}
+
+// Every other 16 byte slot holds a range of an early patch, every 8th one has a later patch over its second half.
+// Reverting the early ones writes back exactly their unshadowed bytes and hands the rest on.
+static void scale(uint8_t* game)
+{
+    static PatchJournal journal;
+    journal_init(&journal);
+    for (size_t i = 0; i < SCALE_AREA; i++)
+    {
+        game[i] = (uint8_t)i;
+    }
+    uint8_t* original = (uint8_t*)malloc(SCALE_AREA);
+    memcpy(original, game, SCALE_AREA);
+
+    uint8_t fill[SCALE_SIZE];
+    memset(fill, 0xa5, sizeof(fill));
+    for (uint32_t i = 0; i < SCALE_RANGES; i++)
+    {
+        CHECK(journal_reserve(&journal, 0x10000 + i % SCALE_PATCHES, GAME_BASE + i * SCALE_SIZE * 2, SCALE_SIZE));
+    }
+    journal_commit(&journal);
+    for (uint32_t i = 0; i < SCALE_RANGES; i++)
+    {
+        WriteProcessMemory(sys_process_getpid(), (void*)(GAME_BASE + i * SCALE_SIZE * 2), fill, SCALE_SIZE);
+    }
+    for (uint32_t i = 0; i < SCALE_RANGES; i += 8)
+    {
+        CHECK(journal_reserve(&journal, 0x20000 + i % SCALE_PATCHES, GAME_BASE + i * SCALE_SIZE * 2 + SCALE_SIZE / 2, SCALE_SIZE));
+    }
+    journal_commit(&journal);
+    for (uint32_t i = 0; i < SCALE_RANGES; i += 8)
+    {
+        WriteProcessMemory(sys_process_getpid(), (void*)(GAME_BASE + i * SCALE_SIZE * 2 + SCALE_SIZE / 2), fill, SCALE_SIZE);
+    }
+
+    static uint32_t hashes[SCALE_PATCHES];
+    for (uint32_t i = 0; i < SCALE_PATCHES; i++)
+    {
+        hashes[i] = 0x10000 + i;
+    }
+    host_memory_stats_reset();
+    const uint64_t start = host_time_ns();
+    journal_revert_set(&journal, hashes, SCALE_PATCHES);
+    const uint64_t ns = host_time_ns() - start;
+    printf("reverted %d of %d entries in %.2f ms, %llu bytes written back\n", SCALE_RANGES, SCALE_RANGES + SCALE_RANGES / 8, (double)ns / 1e6,
+           (unsigned long long)g_host_memory_stats.written_bytes);
+    const uint32_t shadowed = SCALE_RANGES / 8 * SCALE_SIZE / 2;
+    CHECK(g_host_memory_stats.written_bytes == (uint64_t)SCALE_RANGES * SCALE_SIZE - shadowed);
+    CHECK(g_host_memory_stats.writes == SCALE_RANGES);
+
+    // the later patches end at the original too
+    for (uint32_t i = 0; i < SCALE_PATCHES; i += 8)
+    {
+        hashes[i / 8] = 0x20000 + i;
+    }
+    journal_revert_set(&journal, hashes, SCALE_PATCHES / 8);
+    CHECK(memcmp(game, original, SCALE_AREA) == 0);
+    journal_free(&journal);
+    free(original);
+}
+
+int test_main(void)
+{
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, SCALE_AREA);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+
+    // the simple case: the later patch stays, the earlier one is turned off
+    static PatchJournal journal;
+    journal_init(&journal);
+    memset(game, 0xee, 16);
+    const uint8_t a[8] = {0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7};
+    const uint8_t b[4] = {0xb0, 0xb1, 0xb2, 0xb3};
+    CHECK(journal_reserve(&journal, 0xa, GAME_BASE, sizeof(a)));
+    journal_commit(&journal);
+    WriteProcessMemory(sys_process_getpid(), (void*)GAME_BASE, a, sizeof(a));
+    CHECK(journal_reserve(&journal, 0xb, GAME_BASE + 2, sizeof(b)));
+    journal_commit(&journal);
+    WriteProcessMemory(sys_process_getpid(), (void*)(GAME_BASE + 2), b, sizeof(b));
+    journal_revert(&journal, 0xa);
+    const uint8_t after_a[8] = {0xee, 0xee, 0xb0, 0xb1, 0xb2, 0xb3, 0xee, 0xee};
+    CHECK(memcmp(game, after_a, sizeof(after_a)) == 0);
+    journal_revert(&journal, 0xb);
+    const uint8_t after_b[8] = {0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee};
+    CHECK(memcmp(game, after_b, sizeof(after_b)) == 0);
+    journal_free(&journal);
+
+    int failed_rounds = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        failed_rounds += !run_round(game);
+    }
+    CHECK(failed_rounds == 0);
+    printf("%d of %d random rounds failed\n", failed_rounds, ROUNDS);
+
+    scale(game);
+
+    host_unmap(GAME_BASE, SCALE_AREA);
+    return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+// Module relative addresses resolved against a fake ps3mapi module list
+#include "host_test.h"
+#include "host_lv2.h"
+#include "module_table.h"
+#include "patch_plan.h"
+
+#include <string.h>
+
+// text and data are 64K aligned, so there is padding between them like on a real prx
+#define LIB_TEXT_BASE 0x40000000
+#define LIB_TEXT_SIZE 0x1234
+#define LIB_DATA_BASE 0x40010000
+#define LIB_DATA_SIZE 0x800
+#define LIB_PATH "/dev_hdd0/game/BLUS00000/USRDIR/libgame.sprx"
+
+static void test_resolve(const ModuleSegments* lib)
+{
+    uint32_t addr = 0;
+    CHECK(module_table_resolve(lib, 0x10, 4, &addr) && addr == LIB_TEXT_BASE + 0x10);
+    CHECK(module_table_resolve(lib, LIB_TEXT_SIZE - 4, 4, &addr) && addr == LIB_TEXT_BASE + LIB_TEXT_SIZE - 4);
+    // data is addressed by its vaddr distance from text, not by text_size
+    CHECK(module_table_resolve(lib, LIB_DATA_BASE - LIB_TEXT_BASE, 4, &addr) && addr == LIB_DATA_BASE);
+    CHECK(module_table_resolve(lib, LIB_DATA_BASE - LIB_TEXT_BASE + LIB_DATA_SIZE - 8, 8, &addr) && addr == LIB_DATA_BASE + LIB_DATA_SIZE - 8);
+
+    addr = 0xdeadbeef;
+    CHECK(!module_table_resolve(lib, LIB_TEXT_SIZE - 2, 4, &addr));                              // straddles the end of text
+    CHECK(!module_table_resolve(lib, LIB_TEXT_SIZE, 4, &addr));                                  // padding
+    CHECK(!module_table_resolve(lib, LIB_DATA_BASE - LIB_TEXT_BASE - 4, 4, &addr));              // padding
+    CHECK(!module_table_resolve(lib, LIB_DATA_BASE - LIB_TEXT_BASE + LIB_DATA_SIZE - 2, 4, &addr));  // past data
+    CHECK(!module_table_resolve(lib, 0xfffffff0, 0x20, &addr));                                  // wraps
+    CHECK(addr == 0xdeadbeef);
+
+    ModuleSegments text_only = *lib;
+    text_only.data_base = text_only.data_size = 0;
+    CHECK(!module_table_resolve(&text_only, LIB_DATA_BASE - LIB_TEXT_BASE, 4, &addr));
+}
+
+int test_main(void)
+{
+    char name[64];
+    host_modules_clear();
+    // fill the table with neighbours so lookups have to probe
+    for (int i = 0; i < 40; i++)
+    {
+        snprintf(name, sizeof(name), "/dev_flash/sys/external/lib%d.sprx", i);
+        CHECK(host_module_add(name, 0x00800000 + i * 0x20000, 0x10000, 0x00810000 + i * 0x20000, 0x1000) != 0);
+    }
+    CHECK(host_module_add(LIB_PATH, LIB_TEXT_BASE, LIB_TEXT_SIZE, LIB_DATA_BASE, LIB_DATA_SIZE) != 0);
+
+    static ModuleTable table;
+    CHECK(module_table_build(&table, 1));
+    CHECK(table.count == 41);
+    CHECK(module_name_hash("LIBGAME.SPRX") == module_name_hash(LIB_PATH));
+    CHECK(module_table_find(&table, module_name_hash("libmissing.sprx")) == NULL);
+    snprintf(name, sizeof(name), "lib%d.sprx", 17);
+    const ModuleSegments* neighbour = module_table_find(&table, module_name_hash(name));
+    CHECK(neighbour && neighbour->text_base == 0x00800000 + 17 * 0x20000);
+
+    const ModuleSegments* lib = module_table_find(&table, module_name_hash("libgame.sprx"));
+    CHECK(lib != NULL);
+    if (!lib)
+    {
+        return TEST_RESULT();
+    }
+    CHECK(lib->text_base == LIB_TEXT_BASE && lib->text_size == LIB_TEXT_SIZE);
+    CHECK(lib->data_base == LIB_DATA_BASE && lib->data_size == LIB_DATA_SIZE);
+    test_resolve(lib);
+
+    // a plan record into the data segment lands at data_base, and one into the padding is dropped
+    uint8_t* image = (uint8_t*)host_map(LIB_TEXT_BASE, LIB_DATA_BASE - LIB_TEXT_BASE + LIB_DATA_SIZE);
+    CHECK(image != NULL);
+    if (image)
+    {
+        const uint32_t hash = module_name_hash("libgame.sprx");
+        const uint8_t value[4] = {0x12, 0x34, 0x56, 0x78};
+        PatchPlan plan;
+        patch_plan_init(&plan);
+        CHECK(patch_plan_add(&plan, 0x1111, hash, PATCH_PLAN_WRITE, LIB_DATA_BASE - LIB_TEXT_BASE + 0x20, value, sizeof(value)));
+        CHECK(patch_plan_add(&plan, 0x2222, hash, PATCH_PLAN_WRITE, LIB_TEXT_SIZE + 0x20, value, sizeof(value)));
+        host_memory_stats_reset();
+        patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+        patch_plan_free(&plan);
+        CHECK(memcmp(image + (LIB_DATA_BASE - LIB_TEXT_BASE) + 0x20, value, sizeof(value)) == 0);
+        CHECK(g_host_memory_stats.writes == 1);
+        host_unmap(LIB_TEXT_BASE, LIB_DATA_BASE - LIB_TEXT_BASE + LIB_DATA_SIZE);
+    }
+
+    host_modules_clear();
+    return TEST_RESULT();
+}
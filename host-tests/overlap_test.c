@@ -0,0 +1,203 @@
+// Overlap resolution against applying the unresolved plan record by record
+#include "host_test.h"
+#include "host_lv2.h"
+#include "patch_overlap.h"
+#include "patch_plan.h"
+#include "../shared/stringid.h"
+
+#include <string.h>
+
+#define GAME_BASE 0x40000000
+#define AREA 512
+#define BLOB_PATH "blobs/overlap.bin"
+#define BLOB_SIZE 4096
+#define ROUNDS 150
+#define MAX_RECORDS 24
+
+static uint32_t s_seed = 0xc0ffee11;
+static uint8_t s_blob[BLOB_SIZE];
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static void add_random_record(PatchPlan* plan, bool with_copies)
+{
+    const uint32_t hash = 0x100 + next_random() % 6;
+    const uint32_t size = 1 + next_random() % 64;
+    const uint32_t addr = GAME_BASE + next_random() % (AREA - size);
+    plan->phase = next_random() % 4 == 0 ? PATCH_PHASE_DEFERRED : PATCH_PHASE_EARLY;
+    switch (next_random() % (with_copies ? 4 : 3))
+    {
+        case 0:
+        {
+            uint8_t bytes[64];
+            for (uint32_t i = 0; i < size; i++)
+            {
+                bytes[i] = (uint8_t)next_random();
+            }
+            patch_plan_add(plan, hash, 0, PATCH_PLAN_WRITE, addr, bytes, size);
+            break;
+        }
+        case 1:
+        {
+            uint8_t pattern[5];
+            const uint32_t pattern_size = 1 + next_random() % sizeof(pattern);
+            for (uint32_t i = 0; i < pattern_size; i++)
+            {
+                pattern[i] = (uint8_t)next_random();
+            }
+            patch_plan_add_fill(plan, hash, 0, addr, pattern, pattern_size, size);
+            break;
+        }
+        case 2:
+        {
+            const uint32_t offset = next_random() % (BLOB_SIZE - size);
+            patch_plan_add_file(plan, hash, 0, addr, BLOB_PATH, offset, size, memid(s_blob + offset, size, 0));
+            break;
+        }
+        default:
+        {
+            const uint32_t src = GAME_BASE + next_random() % (AREA - size);
+            patch_plan_add_copy(plan, hash, 0, addr, src, size);
+            break;
+        }
+    }
+}
+
+static void apply(const PatchPlan* plan, uint8_t* game, const uint8_t* original)
+{
+    memcpy(game, original, AREA);
+    patch_plan_apply(plan, PATCH_PHASE_EARLY, NULL);
+    patch_plan_apply(plan, PATCH_PHASE_DEFERRED, NULL);
+}
+
+// bytes covered by the interval records of any phase
+static size_t union_size(const PatchPlan* plan)
+{
+    uint8_t covered[AREA];
+    memset(covered, 0, sizeof(covered));
+    size_t total = 0;
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        const PatchPlanRecord* rec = &plan->records[i];
+        for (uint32_t b = 0; b < rec->size; b++)
+        {
+            total += !covered[rec->addr - GAME_BASE + b];
+            covered[rec->addr - GAME_BASE + b] = 1;
+        }
+    }
+    return total;
+}
+
+static bool run_round(uint8_t* game, bool with_copies)
+{
+    uint8_t original[AREA];
+    uint8_t naive[AREA];
+    for (size_t i = 0; i < AREA; i++)
+    {
+        original[i] = (uint8_t)next_random();
+    }
+
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    const size_t count = 2 + next_random() % (MAX_RECORDS - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        add_random_record(&plan, with_copies);
+    }
+    PatchPlan resolved;
+    patch_plan_init(&resolved);
+    for (size_t i = 0; i < plan.record_count; i++)
+    {
+        patch_plan_add_record(&resolved, &plan, &plan.records[i]);
+    }
+    bool okay = patch_plan_resolve_overlaps(&resolved);
+
+    apply(&plan, game, original);
+    memcpy(naive, game, AREA);
+    host_memory_stats_reset();
+    apply(&resolved, game, original);
+    okay = okay && memcmp(naive, game, AREA) == 0;
+    if (!with_copies)
+    {
+        // every byte once, across both phases
+        okay = okay && g_host_memory_stats.written_bytes == union_size(&plan);
+    }
+
+    patch_plan_free(&plan);
+    patch_plan_free(&resolved);
+    return okay;
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    for (size_t i = 0; i < BLOB_SIZE; i++)
+    {
+        s_blob[i] = (uint8_t)next_random();
+    }
+    CHECK(host_fs_write(GAME_PATCH_DATA_PATH "/" BLOB_PATH, s_blob, sizeof(s_blob)) == 0);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, 0x1000);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+
+    // a fill cut in the middle keeps its pattern going
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    const uint8_t pattern[3] = {1, 2, 3};
+    CHECK(patch_plan_add_fill(&plan, 1, 0, GAME_BASE, pattern, sizeof(pattern), 12));
+    CHECK(patch_plan_add(&plan, 2, 0, PATCH_PLAN_WRITE, GAME_BASE + 2, "\xff\xff", 2));
+    CHECK(patch_plan_resolve_overlaps(&plan));
+    CHECK(plan.record_count == 3 && plan.records[1].kind == PATCH_PLAN_FILL && plan.records[1].addr == GAME_BASE + 4);
+    memset(game, 0, AREA);
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+    const uint8_t want[12] = {1, 2, 0xff, 0xff, 2, 3, 1, 2, 3, 1, 2, 3};
+    CHECK(memcmp(game, want, sizeof(want)) == 0);
+    patch_plan_free(&plan);
+
+    // a deferred write wins over a later early one and the shadowed early bytes are dropped
+    patch_plan_init(&plan);
+    plan.phase = PATCH_PHASE_DEFERRED;
+    CHECK(patch_plan_add(&plan, 1, 0, PATCH_PLAN_WRITE, GAME_BASE + 4, "\xdd\xdd\xdd\xdd", 4));
+    plan.phase = PATCH_PHASE_EARLY;
+    CHECK(patch_plan_add(&plan, 2, 0, PATCH_PLAN_WRITE, GAME_BASE, "\xee\xee\xee\xee\xee\xee\xee\xee", 8));
+    CHECK(patch_plan_resolve_overlaps(&plan));
+    CHECK(plan.record_count == 2);
+    CHECK(plan.records[0].phase == PATCH_PHASE_DEFERRED && plan.records[0].addr == GAME_BASE + 4 && plan.records[0].size == 4);
+    CHECK(plan.records[1].phase == PATCH_PHASE_EARLY && plan.records[1].addr == GAME_BASE && plan.records[1].size == 4);
+    memset(game, 0, AREA);
+    host_memory_stats_reset();
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+    patch_plan_apply(&plan, PATCH_PHASE_DEFERRED, NULL);
+    CHECK(memcmp(game, "\xee\xee\xee\xee\xdd\xdd\xdd\xdd", 8) == 0);
+    CHECK(g_host_memory_stats.written_bytes == 8);
+    patch_plan_free(&plan);
+
+    // records ending at the top of the address space don't wrap to 0
+    patch_plan_init(&plan);
+    CHECK(patch_plan_add(&plan, 1, 0, PATCH_PLAN_WRITE, 0xfffffff0, "\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11\x11", 16));
+    CHECK(patch_plan_add(&plan, 2, 0, PATCH_PLAN_WRITE, 0xfffffff8, "\x22\x22\x22\x22\x22\x22\x22\x22", 8));
+    CHECK(patch_plan_resolve_overlaps(&plan));
+    CHECK(plan.record_count == 2);
+    CHECK(plan.records[0].addr == 0xfffffff0 && plan.records[0].size == 8);
+    CHECK(plan.records[1].addr == 0xfffffff8 && plan.records[1].size == 8);
+    patch_plan_free(&plan);
+
+    int failed = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        failed += !run_round(game, false);
+        failed += !run_round(game, true);
+    }
+    printf("%d of %d random rounds differ from the naive apply\n", failed, ROUNDS * 2);
+    CHECK(failed == 0);
+
+    host_unmap(GAME_BASE, 0x1000);
+    return TEST_RESULT();
+}
@@ -0,0 +1,315 @@
+// Signature patches from yml to plan: signature and signature_offset parsing, records rebased onto
+// the match, dropped when it isn't found, a hit in one code segment not scanned for again in the
+// next, and the .sig cache trusted only for the exe fingerprint it was written for.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "patch.h"
+#include "patch_plan.h"
+#include "patch_signature.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#define EXE_BASE 0x10000  // EXE_ELF_BASE
+#define SEGMENT_SIZE 0x10000
+#define SECOND_SEGMENT 0x30000
+#define EXE_SIZE (SECOND_SEGMENT + SEGMENT_SIZE - EXE_BASE)
+#define FIRST_MATCH (EXE_BASE + 0x2000)
+#define DUPLICATE_MATCH (SECOND_SEGMENT + 0x400)
+#define SECOND_MATCH (SECOND_SEGMENT + 0x800)
+#define PT_LOAD 1
+#define PF_X 1
+#define PF_R 4
+
+#define FIRST_TEXT "7C 08 02 A6 F8 21 FF ?? FB E1 00 88"
+#define SECOND_TEXT "38 60 00 01 4E 80 00 20 3? 80 ?? ??"
+
+static const uint8_t s_first[] = {0x7c, 0x08, 0x02, 0xa6, 0xf8, 0x21, 0xff, 0x71, 0xfb, 0xe1, 0x00, 0x88};
+static const uint8_t s_second[] = {0x38, 0x60, 0x00, 0x01, 0x4e, 0x80, 0x00, 0x20, 0x3d, 0x80, 0x12, 0x34};
+
+// "First" and "Second" are found, in different segments, "Missing" isn't, "Absolute" has no signature
+static const char* s_yml =
+    "titleid: [\"BLES00002\"]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"First\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  signature: \"" FIRST_TEXT "\"\n"
+    "  signature_offset: \"0x10\"\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x0\", \"0x60000000\" ]\n"
+    "    - [ \"be32\", \"0x8\", \"0x4e800020\" ]\n"
+    "    - [ \"copy\", \"0x20\", \"0x0\", \"4\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Second\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  signature_offset: \"-0x8\"\n"
+    "  signature: \"" SECOND_TEXT "\"\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x0\", \"0x38600000\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Missing\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  signature: \"DE AD BE EF DE AD BE EF\"\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x0\", \"0x11111111\" ]\n"
+    "    - [ \"be32\", \"0x4\", \"0x22222222\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Absolute\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x10100\", \"0x33333333\" ]\n";
+
+// Only signatures the scan finds, so a cached run doesn't scan at all
+static const char* s_cached_yml =
+    "titleid: [\"BLES00003\"]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"First\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  signature: \"" FIRST_TEXT "\"\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x0\", \"0x60000000\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Second\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  signature: \"" SECOND_TEXT "\"\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x0\", \"0x38600000\" ]\n";
+
+typedef struct
+{
+    uint8_t e_ident[16];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint64_t e_entry;
+    uint64_t e_phoff;
+    uint64_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} Elf64Header;
+
+typedef struct
+{
+    uint32_t p_type;
+    uint32_t p_flags;
+    uint64_t p_offset;
+    uint64_t p_vaddr;
+    uint64_t p_paddr;
+    uint64_t p_filesz;
+    uint64_t p_memsz;
+    uint64_t p_align;
+} Elf64Phdr;
+
+// Two code segments with a gap between them, the first holds the headers like an EBOOT's
+static void make_exe(uint8_t* exe)
+{
+    Elf64Header* eh = (Elf64Header*)exe;
+    memcpy(eh->e_ident, "\x7f" "ELF\x02\x02\x01", 7);
+    eh->e_type = 2;
+    eh->e_machine = 0x15;
+    eh->e_phoff = sizeof(Elf64Header);
+    eh->e_ehsize = sizeof(Elf64Header);
+    eh->e_phentsize = sizeof(Elf64Phdr);
+    eh->e_phnum = 2;
+
+    const uint32_t bases[2] = {EXE_BASE, SECOND_SEGMENT};
+    Elf64Phdr* ph = (Elf64Phdr*)(exe + sizeof(Elf64Header));
+    for (int i = 0; i < 2; i++)
+    {
+        ph[i].p_type = PT_LOAD;
+        ph[i].p_flags = PF_R | PF_X;
+        ph[i].p_vaddr = ph[i].p_paddr = bases[i];
+        ph[i].p_filesz = ph[i].p_memsz = SEGMENT_SIZE;
+        ph[i].p_align = 0x10000;
+    }
+
+    memcpy(exe + FIRST_MATCH - EXE_BASE, s_first, sizeof(s_first));
+    memcpy(exe + DUPLICATE_MATCH - EXE_BASE, s_first, sizeof(s_first));
+    memcpy(exe + SECOND_MATCH - EXE_BASE, s_second, sizeof(s_second));
+}
+
+static GamePatchInfo make_info(const char* titleid)
+{
+    GamePatchInfo info;
+    memset(&info, 0, sizeof(info));
+    strcpy(info.titleid, titleid);
+    strcpy(info.app_ver, "01.00");
+    return info;
+}
+
+static int build(const char* titleid, const char* yml, uint64_t fingerprint, PatchPlan* plan)
+{
+    char lv2_path[256];
+    char yml_path[1024];
+    snprintf(lv2_path, sizeof(lv2_path), GAME_PATCH_FILES_PATH "/%s.yml", titleid);
+    host_fs_path(lv2_path, yml_path, sizeof(yml_path));
+    CHECK(host_fs_write(lv2_path, yml, strlen(yml)) == 0);
+    const GamePatchInfo info = make_info(titleid);
+    patch_plan_init(plan);
+    host_memory_stats_reset();
+    return build_patch_plan(&info, yml_path, fingerprint, true, plan);
+}
+
+static uint32_t record_value(const PatchPlan* plan, const PatchPlanRecord* rec)
+{
+    uint32_t value = 0;
+    memcpy(&value, plan->data + rec->data_offset, sizeof(value));
+    return value;
+}
+
+static const PatchPlanRecord* find_value(const PatchPlan* plan, uint32_t value)
+{
+    for (size_t i = 0; i < plan->record_count; i++)
+    {
+        if (plan->records[i].kind == PATCH_PLAN_WRITE && record_value(plan, &plan->records[i]) == value)
+        {
+            return &plan->records[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_signatures(void)
+{
+    PatchSignatures signatures;
+    patch_signatures_init(&signatures);
+    CHECK(patch_signatures_add(&signatures, 1, FIRST_TEXT, 0, false));
+    // one signature per patch, the first one counts
+    CHECK(patch_signatures_add(&signatures, 1, SECOND_TEXT, 4, false));
+    CHECK(patch_signatures_add(&signatures, 2, "7C 0G", 0, false));
+    CHECK(signatures.count == 2 && signatures.items[0].offset == 0 && strcmp(signatures.items[0].text, FIRST_TEXT) == 0);
+
+    // the duplicate in the second segment isn't scanned for again, a malformed signature stays unresolved
+    patch_signatures_resolve(&signatures, GAME_PATCH_CACHE_PATH "/none.sig", 0);
+    CHECK(signatures.items[0].resolved && signatures.items[0].match == FIRST_MATCH);
+    CHECK(!signatures.items[1].resolved);
+    printf("%llu bytes read for a signature in the first segment\n", (unsigned long long)g_host_memory_stats.read_bytes);
+    CHECK(g_host_memory_stats.read_bytes < 2 * SEGMENT_SIZE);
+    patch_signatures_free(&signatures);
+
+    for (int i = 0; i < PATCH_SIGNATURES_MAX; i++)
+    {
+        CHECK(patch_signatures_add(&signatures, 0x100 + i, FIRST_TEXT, 0, false));
+    }
+    CHECK(!patch_signatures_add(&signatures, 0x1000, FIRST_TEXT, 0, false));
+    CHECK(signatures.count == PATCH_SIGNATURES_MAX);
+    patch_signatures_free(&signatures);
+}
+
+static void test_rebase(void)
+{
+    PatchPlan plan;
+    CHECK(build("BLES00002", s_yml, 0, &plan) == 0);
+    CHECK(plan.patch_count == 4);
+
+    // offsets from the match plus signature_offset, "Missing" is dropped, "Absolute" is left alone
+    CHECK(plan.record_count == 5);
+    const PatchPlanRecord* rec = find_value(&plan, 0x60000000);
+    CHECK(rec && rec->addr == FIRST_MATCH + 0x10);
+    rec = find_value(&plan, 0x4e800020);
+    CHECK(rec && rec->addr == FIRST_MATCH + 0x10 + 8);
+    rec = find_value(&plan, 0x38600000);
+    CHECK(rec && rec->addr == SECOND_MATCH - 8);
+    rec = find_value(&plan, 0x33333333);
+    CHECK(rec && rec->addr == 0x10100);
+    CHECK(!find_value(&plan, 0x11111111) && !find_value(&plan, 0x22222222));
+
+    // both ends of a copy are block offsets
+    bool copy = false;
+    for (size_t i = 0; i < plan.record_count; i++)
+    {
+        rec = &plan.records[i];
+        if (rec->kind == PATCH_PLAN_COPY)
+        {
+            copy = rec->addr == FIRST_MATCH + 0x10 + 0x20 && record_value(&plan, rec) == FIRST_MATCH + 0x10;
+        }
+    }
+    CHECK(copy);
+
+    // nothing is cached without a fingerprint
+    char path[1024];
+    struct stat st;
+    CHECK(stat(host_fs_path(GAME_PATCH_CACHE_PATH "/BLES00002.sig", path, sizeof(path)), &st) != 0);
+    patch_plan_free(&plan);
+}
+
+static void test_cache(uint8_t* exe)
+{
+    char path[1024];
+    struct stat st;
+    host_fs_path(GAME_PATCH_CACHE_PATH "/BLES00003.sig", path, sizeof(path));
+
+    // miss: scanned and written
+    PatchPlan plan;
+    CHECK(build("BLES00003", s_cached_yml, 0x1111, &plan) == 0);
+    const uint64_t scanned = g_host_memory_stats.read_bytes;
+    CHECK(scanned >= SEGMENT_SIZE);
+    CHECK(stat(path, &st) == 0 && st.st_size == sizeof(SignatureCacheHeader) + 2 * sizeof(SignatureCacheEntry));
+    const PatchPlanRecord* rec = find_value(&plan, 0x60000000);
+    CHECK(rec && rec->addr == FIRST_MATCH);
+    patch_plan_free(&plan);
+
+    // hit: the matches come from the cache even though a scan wouldn't find the first one now
+    memset(exe + FIRST_MATCH - EXE_BASE, 0, sizeof(s_first));
+    memset(exe + DUPLICATE_MATCH - EXE_BASE, 0, sizeof(s_first));
+    CHECK(build("BLES00003", s_cached_yml, 0x1111, &plan) == 0);
+    CHECK(g_host_memory_stats.read_bytes == 0);
+    rec = find_value(&plan, 0x60000000);
+    CHECK(rec && rec->addr == FIRST_MATCH);
+    rec = find_value(&plan, 0x38600000);
+    CHECK(rec && rec->addr == SECOND_MATCH);
+    patch_plan_free(&plan);
+
+    // another executable: the cache is ignored, the scan drops "First" and the cache is rewritten
+    CHECK(build("BLES00003", s_cached_yml, 0x2222, &plan) == 0);
+    CHECK(g_host_memory_stats.read_bytes >= SEGMENT_SIZE);
+    CHECK(!find_value(&plan, 0x60000000));
+    rec = find_value(&plan, 0x38600000);
+    CHECK(rec && rec->addr == SECOND_MATCH);
+    CHECK(stat(path, &st) == 0 && st.st_size == sizeof(SignatureCacheHeader) + sizeof(SignatureCacheEntry));
+    patch_plan_free(&plan);
+
+    // and the old fingerprint isn't trusted any more
+    CHECK(build("BLES00003", s_cached_yml, 0x1111, &plan) == 0);
+    CHECK(!find_value(&plan, 0x60000000));
+    patch_plan_free(&plan);
+
+    memcpy(exe + FIRST_MATCH - EXE_BASE, s_first, sizeof(s_first));
+    memcpy(exe + DUPLICATE_MATCH - EXE_BASE, s_first, sizeof(s_first));
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    uint8_t* exe = (uint8_t*)host_map(EXE_BASE, EXE_SIZE);
+    CHECK(exe != NULL);
+    if (!exe)
+    {
+        return TEST_RESULT();
+    }
+    make_exe(exe);
+
+    test_signatures();
+    test_rebase();
+    test_cache(exe);
+
+    host_unmap(EXE_BASE, EXE_SIZE);
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+// Patch entry parsing and the yml -> plan -> file -> memory round trip
+#include "host_test.h"
+#include "host_lv2.h"
+#include "patch.h"
+#include "patch_plan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GAME_BASE 0x40000000
+#define GAME_SIZE 0x100000
+#define PLAN_PATH GAME_PATCH_CACHE_PATH "/BLES00000.plan"
+
+static const char* s_yml =
+    "titleid: [\"BLES00000\"]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Round trip\"\n"
+    "  author: \"host\"\n"
+    "  version: \"1\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"01.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x40000000\", \"0x60000000\" ]\n"
+    "    - [ \"bytes\", \"0x40000010\", \"DEADBEEF0102\" ]\n"
+    "    - [ \"fill\", \"0x40000020\", \"AABB\", \"3\" ]\n"
+    "    - [ \"fill\", \"0x40010000\", \"90\", \"0x30000\" ]\n"
+    "    - [ \"copy\", \"0x40000100\", \"0x40000010\", \"6\" ]\n"
+    "    - [ \"fill\", \"0x40000000\", \"AABB\", \"0x100000000\" ]\n"
+    "    - [ \"fill\", \"0xFFFFFFF0\", \"00\", \"0x20\" ]\n"
+    "patch:\n"
+    "  title: \"Test Game\"\n"
+    "  name: \"Other version\"\n"
+    "  app_bin: \"EBOOT.BIN\"\n"
+    "  app_ver: [\"02.00\"]\n"
+    "  patches:\n"
+    "    - [ \"be32\", \"0x40000004\", \"0x1\" ]\n";
+
+static PatchEntry make_entry(const char* a, const char* b, const char* c, const char* d)
+{
+    PatchEntry e;
+    memset(&e, 0, sizeof(e));
+    const char* params[] = {a, b, c, d};
+    for (size_t i = 0; i < 4 && params[i]; i++)
+    {
+        e.params[i] = (char*)params[i];
+        e.param_count++;
+    }
+    return e;
+}
+
+static void test_entries(void)
+{
+    PatchEntry e = make_entry("be32", "0x10000", "0x60000000", NULL);
+    CHECK(get_patch_entry_type(&e) == PATCH_ENTRY_BYTES32);
+    CHECK(validate_patch_entry(&e));
+
+    e = make_entry("be32", "0x10000", "nop", NULL);
+    CHECK(!validate_patch_entry(&e));
+
+    uint8_t bytes[4];
+    CHECK(parse_hex_bytes("DEADBEEF", bytes, sizeof(bytes)) == 4 && bytes[0] == 0xde && bytes[3] == 0xef);
+    CHECK(parse_hex_bytes("DEADBEE", NULL, 0) == 0);
+
+    e = make_entry("fill", "0x10000", "AABB", "16");
+    CHECK(get_patch_entry_type(&e) == PATCH_ENTRY_FILL);
+    CHECK(validate_patch_entry(&e));
+    e = make_entry("fill", "0x10000", "AABB", "0");
+    CHECK(!validate_patch_entry(&e));
+    // pattern * count doesn't fit in 32 bits
+    e = make_entry("fill", "0x10000", "AABBCCDD", "0x40000000");
+    CHECK(!validate_patch_entry(&e));
+    e = make_entry("fill", "0x10000", "AA", "0x10000000000000001");
+    CHECK(!validate_patch_entry(&e));
+    // ends past the end of the address space
+    e = make_entry("fill", "0xFFFFFF00", "AABB", "0x81");
+    CHECK(!validate_patch_entry(&e));
+    e = make_entry("fill", "0xFFFFFF00", "AABB", "0x80");
+    CHECK(validate_patch_entry(&e));
+
+    e = make_entry("copy", "0x10000", "0x20000", "0x100");
+    CHECK(validate_patch_entry(&e));
+    e = make_entry("copy", "0x10000", "0xFFFFFFF0", "0x100");
+    CHECK(!validate_patch_entry(&e));
+}
+
+static bool plans_equal(const PatchPlan* a, const PatchPlan* b)
+{
+    return a->record_count == b->record_count && a->data_size == b->data_size && a->patch_count == b->patch_count &&
+           memcmp(a->records, b->records, sizeof(PatchPlanRecord) * a->record_count) == 0 &&
+           memcmp(a->data, b->data, a->data_size) == 0;
+}
+
+static void test_round_trip(void)
+{
+    char yml_path[1024];
+    host_fs_path(GAME_PATCH_FILES_PATH "/BLES00000.yml", yml_path, sizeof(yml_path));
+    CHECK(host_fs_write(GAME_PATCH_FILES_PATH "/BLES00000.yml", s_yml, strlen(s_yml)) == 0);
+
+    GameLaunchRecord launch;
+    memset(&launch, 0, sizeof(launch));
+    launch.flags = GAME_LAUNCH_HAS_PATCH_FILE;
+    strcpy(launch.info.titleid, "BLES00000");
+    strcpy(launch.info.app_ver, "01.00");
+    launch.patch_file_size = strlen(s_yml);
+
+    // the host parser reads host paths, nothing is enabled without a settings file
+    PatchPlan plan;
+    patch_plan_init(&plan);
+    CHECK(build_patch_plan(&launch.info, yml_path, 0, true, &plan) == 0);
+    CHECK(plan.patch_count == 1);
+    // the overflowing and wrapping fills are dropped, the 02.00 patch doesn't match
+    CHECK(plan.record_count == 5);
+    CHECK(plan.record_count == 5 && plan.records[3].kind == PATCH_PLAN_FILL && plan.records[3].size == 0x30000);
+
+    PatchPlanKey key;
+    CHECK(patch_plan_make_key(&key, &launch, "/dev_hdd0/game/BLES00000/USRDIR/EBOOT.BIN", 0x1234));
+    CHECK(patch_plan_save(&plan, PLAN_PATH, &key));
+
+    PatchPlan loaded;
+    patch_plan_init(&loaded);
+    CHECK(patch_plan_load(&loaded, PLAN_PATH, &key));
+    CHECK(plans_equal(&plan, &loaded));
+    patch_plan_free(&loaded);
+
+    // any change to the key makes the cached plan stale
+    PatchPlanKey other = key;
+    other.state_checksum++;
+    CHECK(!patch_plan_load(&loaded, PLAN_PATH, &other));
+    patch_plan_free(&loaded);
+
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        patch_plan_free(&plan);
+        return;
+    }
+
+    host_memory_stats_reset();
+    patch_plan_apply(&plan, PATCH_PHASE_EARLY, NULL);
+
+    const int32_t nop = 0x60000000;
+    CHECK(memcmp(game, &nop, sizeof(nop)) == 0);
+    const uint8_t blob[] = {0xde, 0xad, 0xbe, 0xef, 0x01, 0x02};
+    CHECK(memcmp(game + 0x10, blob, sizeof(blob)) == 0);
+    const uint8_t fill[] = {0xaa, 0xbb, 0xaa, 0xbb, 0xaa, 0xbb, 0x00};
+    CHECK(memcmp(game + 0x20, fill, sizeof(fill)) == 0);
+    CHECK(memcmp(game + 0x100, blob, sizeof(blob)) == 0);
+    size_t nops = 0;
+    for (size_t i = 0x10000; i < 0x40000; i++)
+    {
+        nops += game[i] == 0x90;
+    }
+    CHECK(nops == 0x30000 && game[0x40000] == 0);
+
+    // the big fill goes out a chunk at a time
+    CHECK(g_host_memory_stats.writes == 4 + 0x30000 / PATCH_FILE_CHUNK_SIZE);
+    printf("%llu writes, %llu bytes\n", (unsigned long long)g_host_memory_stats.writes, (unsigned long long)g_host_memory_stats.written_bytes);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    patch_plan_free(&plan);
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    test_entries();
+    test_round_trip();
+    return TEST_RESULT();
+}
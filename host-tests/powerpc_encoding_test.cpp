@@ -0,0 +1,115 @@
+// Every PowerPC encoder against the word an assembler gives for the same instruction, the
+// branch field decoders, and bad operands encoding 0 when they only show up at runtime.
+#include "host_test.h"
+#include "Memory/PowerPC.hpp"
+
+struct Encoding
+{
+    const char* text;
+    uint32_t word;
+    uint32_t expected;
+};
+
+#define R(n) PowerPCRegister::R##n
+
+static const Encoding s_encodings[] = {
+    { "addi r3, r1, 0x70", PowerPCAddi(R(3), R(1), 0x70), 0x38610070 },
+    { "addi r1, r1, -0x80", PowerPCAddi(R(1), R(1), -0x80), 0x3821FF80 },
+    { "addis r11, r2, 0x1234", PowerPCAddis(R(11), R(2), 0x1234), 0x3D621234 },
+    { "li r3, -1", PowerPCLi(R(3), -1), 0x3860FFFF },
+    { "lis r12, 0x8001", PowerPCLis(R(12), 0x8001), 0x3D808001 },
+    { "ori r0, r0, 0x5678", PowerPCOri(R(0), R(0), 0x5678), 0x60005678 },
+    { "ori r31, r3, 0xffff", PowerPCOri(R(31), R(3), 0xFFFF), 0x607FFFFF },
+    { "lwz r12, -0x8000(r12)", PowerPCLwz(R(12), -0x8000, R(12)), 0x818C8000 },
+    { "lwz r2, 4(r12)", PowerPCLwz(R(2), 4, R(12)), 0x804C0004 },
+    { "ld r0, -0x30(r1)", PowerPCLd(R(0), -0x30, R(1)), 0xE801FFD0 },
+    { "ld r2, 0x28(r1)", PowerPCLd(R(2), 0x28, R(1)), 0xE8410028 },
+    { "std r0, 0x10(r1)", PowerPCStd(R(0), 0x10, R(1)), 0xF8010010 },
+    { "std r31, -8(r1)", PowerPCStd(R(31), -8, R(1)), 0xFBE1FFF8 },
+    { "stdu r1, -0x80(r1)", PowerPCStdu(R(1), -0x80, R(1)), 0xF821FF81 },
+    { "mtctr r0", PowerPCMtctr(R(0)), 0x7C0903A6 },
+    { "mtctr r11", PowerPCMtctr(R(11)), 0x7D6903A6 },
+    { "mtlr r0", PowerPCMtlr(R(0)), 0x7C0803A6 },
+    { "mflr r0", PowerPCMflr(R(0)), 0x7C0802A6 },
+    { "mflr r12", PowerPCMflr(R(12)), 0x7D8802A6 },
+    { "mtspr 256, r3", PowerPCMtspr(256, R(3)), 0x7C6043A6 },
+    { "bctr", PowerPCBcctr(POWERPC_BRANCH_OPTIONS_ALWAYS, 0, false), 0x4E800420 },
+    { "bctrl", PowerPCBcctr(POWERPC_BRANCH_OPTIONS_ALWAYS, 0, true), 0x4E800421 },
+    { "beqctr", PowerPCBcctr(12, 2, false), 0x4D820420 },
+    { "bnectr cr7", PowerPCBcctr(4, 30, false), 0x4C9E0420 },
+    { "blr", PowerPCBlr(), 0x4E800020 },
+    { "b +0x100", PowerPCB(0x100, false), 0x48000100 },
+    { "bl +0x100", PowerPCB(0x100, true), 0x48000101 },
+    { "b -4", PowerPCB(-4, false), 0x4BFFFFFC },
+    { "b +0x1fffffc", PowerPCB(0x1FFFFFC, false), 0x49FFFFFC },
+    { "b -0x2000000", PowerPCB(-0x2000000, false), 0x4A000000 },
+    { "beq +0x20", PowerPCBc(12, 2, 0x20, false), 0x41820020 },
+    { "bnel -8", PowerPCBc(4, 2, -8, true), 0x4082FFF9 },
+    { "bdnz -0x8000", PowerPCBc(16, 0, -0x8000, false), 0x42008000 },
+};
+
+// Folded while compiling, a bad operand in any of these would stop the build
+static_assert(PowerPCB(0x100, true) == 0x48000101, "bl");
+static_assert(PowerPCLd(R(2), 0x70, R(1)) == 0xE8410070, "ld");
+static_assert(PowerPCHa(0x12348000) == 0x1235 && PowerPCLo(0x12348000) == 0x8000, "@ha/@l");
+static_assert(PowerPCBranchOffset(0x4BFFFFFC) == -4, "b offset");
+
+static void encodings()
+{
+    for (size_t i = 0; i < sizeof(s_encodings) / sizeof(s_encodings[0]); i++)
+    {
+        if (s_encodings[i].word != s_encodings[i].expected)
+        {
+            printf("%s: 0x%08x, expected 0x%08x\n", s_encodings[i].text, s_encodings[i].word, s_encodings[i].expected);
+            g_test_failures++;
+        }
+    }
+}
+
+static void decoders()
+{
+    CHECK(PowerPCBranchOffset(0x48000101) == 0x100);
+    CHECK(PowerPCBranchOffset(0x4A000000) == -0x2000000);
+    CHECK(PowerPCBranchOffset(0x4082FFF9) == -8);
+    CHECK(PowerPCBranchOffset(0x42008000) == -0x8000);
+    CHECK(PowerPCBranchOptions(0x48000101) == POWERPC_BRANCH_OPTIONS_ALWAYS);
+    CHECK(PowerPCBranchOptions(0x41820020) == 12);
+    CHECK(PowerPCConditionRegisterBit(0x48000101) == 0);
+    CHECK(PowerPCConditionRegisterBit(0x4C9E0420) == 30);
+
+    // a relative branch survives a decode/encode round trip
+    static const uint32_t branches[] = { 0x48000101, 0x4BFFFFFC, 0x49FFFFFC, 0x41820020, 0x4082FFF9, 0x42008000 };
+    for (size_t i = 0; i < sizeof(branches) / sizeof(branches[0]); i++)
+    {
+        const uint32_t b = branches[i];
+        const bool linked = b & POWERPC_BRANCH_LINKED;
+        const uint32_t encoded = (b & PowerPCOpcodeMask) == PowerPCOpcodeB ? PowerPCB(PowerPCBranchOffset(b), linked)
+                                                                           : PowerPCBc(PowerPCBranchOptions(b), PowerPCConditionRegisterBit(b), PowerPCBranchOffset(b), linked);
+        CHECK(encoded == b);
+    }
+}
+
+// Operands only known at runtime can't stop the compile, the instruction is 0 instead
+static void invalid_operands()
+{
+    volatile int32_t offsets[] = { 0x2000000, -0x2000004, 0x102 };
+    CHECK(PowerPCB(offsets[0], false) == 0);
+    CHECK(PowerPCB(offsets[1], false) == 0);
+    CHECK(PowerPCB(offsets[2], false) == 0);
+    volatile int32_t conditional[] = { 0x8000, -0x8004, 0x22 };
+    CHECK(PowerPCBc(12, 2, conditional[0], false) == 0);
+    CHECK(PowerPCBc(12, 2, conditional[1], false) == 0);
+    CHECK(PowerPCBc(12, 2, conditional[2], false) == 0);
+    volatile int16_t ds = 0x12;
+    CHECK(PowerPCLd(R(0), ds, R(1)) == 0);
+    CHECK(PowerPCStd(R(0), ds, R(1)) == 0);
+    CHECK(PowerPCStdu(R(1), ds, R(1)) == 0);
+}
+
+int test_main(void)
+{
+    encodings();
+    decoders();
+    invalid_operands();
+    return TEST_RESULT();
+}
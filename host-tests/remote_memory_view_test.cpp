@@ -0,0 +1,179 @@
+// RemoteMemoryView against the counting fake lv2: fewer memory syscalls for the small
+// accesses of the scan and detour paths, same bytes as going direct.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/Memory.hpp"
+#include "Memory/ElfSegments.h"
+
+#include <string.h>
+#include <sys/process.h>
+
+#define GAME_BASE 0x40000000
+#define GAME_SIZE 0x10000
+#define TABLE_ENTRIES 64
+
+struct TableEntry
+{
+    uint32_t nid;
+    uint32_t stub;
+    uint32_t flags;
+    uint32_t pad;
+};
+
+// the scan path: ElfCodeSegments reads the elf header, then the program headers right after it
+static void elf_workload(uint8_t* game)
+{
+    // host byte order, the code reads the fields natively like the console does
+    struct
+    {
+        uint8_t ident[16];
+        uint16_t type, machine;
+        uint32_t version;
+        uint64_t entry, phoff, shoff;
+        uint32_t flags;
+        uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+    } header;
+    struct
+    {
+        uint32_t type, flags;
+        uint64_t offset, vaddr, paddr, filesz, memsz, align;
+    } ph[3];
+    memset(&header, 0, sizeof(header));
+    memset(ph, 0, sizeof(ph));
+    memcpy(header.ident, "\x7f" "ELF\x02\x02", 6);
+    header.phoff = sizeof(header);
+    header.phentsize = sizeof(ph[0]);
+    header.phnum = 3;
+    ph[0].type = 1, ph[0].flags = 5, ph[0].vaddr = 0x10000, ph[0].memsz = 0x1000;
+    ph[1].type = 1, ph[1].flags = 6, ph[1].vaddr = 0x20000, ph[1].memsz = 0x800;
+    ph[2].type = 1, ph[2].flags = 1, ph[2].vaddr = 0x30000, ph[2].memsz = 0x400;
+    memcpy(game, &header, sizeof(header));
+    memcpy(game + sizeof(header), ph, sizeof(ph));
+
+    host_memory_stats_reset();
+    CodeSegment segments[CODE_SEGMENTS_MAX];
+    const size_t count = ElfCodeSegments(sys_process_getpid(), GAME_BASE, segments, CODE_SEGMENTS_MAX);
+    CHECK(count == 2);
+    CHECK(segments[0].base == 0x10000 && segments[0].size == 0x1000);
+    CHECK(segments[1].base == 0x30000 && segments[1].size == 0x400);
+    printf("elf headers: %llu read(s), direct took 2\n", (unsigned long long)g_host_memory_stats.reads);
+    CHECK(g_host_memory_stats.reads == 1);
+}
+
+// walking a stub table field by field, VshGetMem per field against the view
+static void table_workload(uint8_t* game)
+{
+    TableEntry* table = (TableEntry*)(game + 0x2000);
+    for (uint32_t i = 0; i < TABLE_ENTRIES; i++)
+    {
+        table[i].nid = 0x1000 + i;
+        table[i].stub = 0x20000 + i * 8;
+        table[i].flags = i & 1;
+    }
+    const uint32_t tableAddr = GAME_BASE + 0x2000;
+
+    host_memory_stats_reset();
+    uint32_t direct = 0;
+    for (uint32_t i = 0; i < TABLE_ENTRIES; i++)
+    {
+        const uint32_t entry = tableAddr + i * sizeof(TableEntry);
+        direct += VshGetMem<uint32_t>(entry) ^ VshGetMem<uint32_t>(entry + 4) ^ VshGetMem<uint32_t>(entry + 8);
+    }
+    const uint64_t directReads = g_host_memory_stats.reads;
+
+    host_memory_stats_reset();
+    uint32_t viewed = 0;
+    {
+        RemoteMemoryView view(sys_process_getpid());
+        for (uint32_t i = 0; i < TABLE_ENTRIES; i++)
+        {
+            const uint32_t entry = tableAddr + i * sizeof(TableEntry);
+            viewed += VshGetMem<uint32_t>(view, entry) ^ VshGetMem<uint32_t>(view, entry + 4) ^ VshGetMem<uint32_t>(view, entry + 8);
+        }
+        CHECK(view.GetStats().reads == g_host_memory_stats.reads);
+    }
+    printf("table walk: %llu read(s) direct, %llu through the view\n", (unsigned long long)directReads, (unsigned long long)g_host_memory_stats.reads);
+    CHECK(viewed == direct);
+    CHECK(directReads == TABLE_ENTRIES * 3);
+    CHECK(g_host_memory_stats.reads == TABLE_ENTRIES * sizeof(TableEntry) / 0x400);
+}
+
+// the detour path: read the instructions being replaced, then write the branch one word at a time
+static void detour_workload(uint8_t* game)
+{
+    const uint32_t target = GAME_BASE + 0x4000;
+    for (uint32_t i = 0; i < 0x40; i++)
+    {
+        game[0x4000 + i] = (uint8_t)i;
+    }
+    const uint32_t stub[4] = { 0x3D600000, 0x616B1234, 0x7D6903A6, 0x4E800420 };
+
+    uint32_t saved[4];
+    host_memory_stats_reset();
+    {
+        RemoteMemoryView view(sys_process_getpid());
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            saved[i] = VshGetMem<uint32_t>(view, target + i * 4);
+        }
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            VshSetMem<uint32_t>(view, target + i * 4, stub[i]);
+        }
+        // buffered until Commit, reads through the view see the new words already
+        CHECK(memcmp(game + 0x4000, stub, sizeof(stub)) != 0);
+        CHECK(VshGetMem<uint32_t>(view, target + 12) == stub[3]);
+        CHECK(g_host_memory_stats.writes == 0);
+        CHECK(view.Commit());
+    }
+    printf("detour: %llu read(s) and %llu write(s), direct took 4 and 4\n", (unsigned long long)g_host_memory_stats.reads,
+           (unsigned long long)g_host_memory_stats.writes);
+    CHECK(g_host_memory_stats.reads == 1);
+    CHECK(g_host_memory_stats.writes == 1);
+    CHECK(memcmp(game + 0x4000, stub, sizeof(stub)) == 0);
+    CHECK(saved[0] == 0x00010203 || saved[0] == 0x03020100);
+}
+
+static void invalidate_and_evict(uint8_t* game)
+{
+    RemoteMemoryView view(sys_process_getpid(), 0x400, 2);
+    const uint32_t addr = GAME_BASE + 0x6000;
+    game[0x6000] = 0x11;
+    CHECK(view.Get<uint8_t>(addr) == 0x11);
+
+    // written behind the view's back: stale until invalidated
+    game[0x6000] = 0x22;
+    CHECK(view.Get<uint8_t>(addr) == 0x11);
+    view.Invalidate(addr, 1);
+    CHECK(view.Get<uint8_t>(addr) == 0x22);
+
+    // a dirty page pushed out by two others is flushed on eviction
+    view.Set<uint8_t>(addr + 1, 0x33);
+    view.Get<uint8_t>(addr + 0x400);
+    view.Get<uint8_t>(addr + 0x800);
+    CHECK(game[0x6001] == 0x33);
+
+    // a write across a page boundary lands in both pages
+    const uint32_t value = 0xA1B2C3D4;
+    view.Write(addr + 0x3FE, &value, sizeof(value));
+    view.InvalidateAll();
+    CHECK(memcmp(game + 0x63FE, &value, sizeof(value)) == 0);
+}
+
+int test_main(void)
+{
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+
+    elf_workload(game);
+    table_workload(game);
+    detour_workload(game);
+    invalidate_and_evict(game);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    return TEST_RESULT();
+}
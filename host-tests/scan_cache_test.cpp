@@ -0,0 +1,76 @@
+// CachedSignatureScan over two code segments: each keeps its own entries, a hit costs one
+// small read, and moved code or another firmware falls back to a full scan.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Utils/ScanCache.hpp"
+
+#include <string.h>
+#include <sys/process.h>
+
+#define GAME_BASE HOST_GAME_WINDOW_BASE
+#define SEGMENT_SIZE 0x100000
+#define FIRST_SEGMENT GAME_BASE
+#define SECOND_SEGMENT (GAME_BASE + 0x200000)
+
+static const uint8_t s_first[] = { 0x7c, 0x08, 0x02, 0xa6, 0xf8, 0x21, 0xff, 0x81, 0xfb, 0xe1, 0x00, 0x78 };
+static const uint8_t s_second[] = { 0x38, 0x60, 0x00, 0x01, 0x4e, 0x80, 0x00, 0x20, 0x2f, 0x83, 0x00, 0x00 };
+
+static uintptr_t scan(uint32_t base, const Signature* signature, uint64_t* reads)
+{
+    host_memory_stats_reset();
+    const uintptr_t found = CachedSignatureScan(sys_process_getpid(), base, SEGMENT_SIZE, signature);
+    *reads = g_host_memory_stats.reads;
+    return found;
+}
+
+int test_main(void)
+{
+    host_fs_temp_root();
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, 0x300000);
+    CHECK(game != NULL);
+    if (!game)
+    {
+        return TEST_RESULT();
+    }
+    memcpy(game + 0x80000, s_first, sizeof(s_first));
+    memcpy(game + 0x200000 + 0x40000, s_second, sizeof(s_second));
+
+    const Signature first = { s_first, NULL, sizeof(s_first), 4, NULL };
+    const Signature second = { s_second, NULL, sizeof(s_second), 0, NULL };
+    uint64_t reads = 0;
+
+    // cold: both scan their segment
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x80000 + 4);
+    CHECK(reads > 2);
+    CHECK(scan(SECOND_SEGMENT, &second, &reads) == SECOND_SEGMENT + 0x40000);
+    CHECK(reads > 2);
+
+    // warm: the second segment's entry didn't replace the first one's
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x80000 + 4);
+    CHECK(reads == 1);
+    CHECK(scan(SECOND_SEGMENT, &second, &reads) == SECOND_SEGMENT + 0x40000);
+    CHECK(reads == 1);
+
+    // the same signature in another range is its own entry
+    CHECK(scan(SECOND_SEGMENT, &first, &reads) == 0);
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x80000 + 4);
+    CHECK(reads == 1);
+
+    // moved code is found again and the entry follows it
+    memset(game + 0x80000, 0, sizeof(s_first));
+    memcpy(game + 0x90000, s_first, sizeof(s_first));
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x90000 + 4);
+    CHECK(reads > 2);
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x90000 + 4);
+    CHECK(reads == 1);
+
+    // another firmware drops everything
+    g_host_fw_version = 0x491;
+    CHECK(scan(SECOND_SEGMENT, &second, &reads) == SECOND_SEGMENT + 0x40000);
+    CHECK(reads > 2);
+    CHECK(scan(FIRST_SEGMENT, &first, &reads) == FIRST_SEGMENT + 0x90000 + 4);
+    CHECK(reads > 2);
+
+    host_unmap(GAME_BASE, 0x300000);
+    return TEST_RESULT();
+}
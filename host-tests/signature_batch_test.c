@@ -0,0 +1,217 @@
+// SignatureScanBatch against one SignatureScan per signature: overlapping matches, signatures sharing
+// an anchor byte, wildcards where the anchor would be, matches at the ends of the image and across
+// windows, then random sets. Then the time of a batch of N signatures against one and against N scans.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/SignatureScan.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <sys/process.h>
+
+#define IMAGE_BASE HOST_GAME_WINDOW_BASE
+#define IMAGE_SIZE (1024 * 1024)
+#define BENCH_SIZE (16 * 1024 * 1024)
+#define MAX_SIGNATURES 32
+#define MAX_SIGNATURE_SIZE 48
+#define RANDOM_ROUNDS 40
+#define BENCH_ROUNDS 3
+
+static uint32_t s_seed = 0x2545f491;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+typedef struct
+{
+    uint8_t bytes[MAX_SIGNATURE_SIZE];
+    uint8_t mask[MAX_SIGNATURE_SIZE];
+} SignatureStorage;
+
+static SignatureStorage s_storage[MAX_SIGNATURES];
+static Signature s_signatures[MAX_SIGNATURES];
+
+static void fill(uint8_t* image, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        image[i] = (uint8_t)next_random();
+    }
+}
+
+static void set_text(size_t index, const char* text, int32_t offset)
+{
+    SignatureStorage* storage = &s_storage[index];
+    const uint32_t size = SignatureParse(text, storage->bytes, storage->mask, MAX_SIGNATURE_SIZE);
+    CHECK(size != 0);
+    const Signature signature = { storage->bytes, storage->mask, size, offset, NULL };
+    s_signatures[index] = signature;
+}
+
+// Batch results for signatures[0, count) are what SignatureScan returns for each of them
+static void compare(const char* what, size_t count)
+{
+    const uint32_t pid = sys_process_getpid();
+    uintptr_t results[MAX_SIGNATURES];
+    const size_t found = SignatureScanBatch(pid, IMAGE_BASE, IMAGE_SIZE, s_signatures, count, results);
+    size_t expected_found = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uintptr_t expected = SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, &s_signatures[i]);
+        expected_found += expected != 0;
+        if (results[i] != expected)
+        {
+            printf("%s: signature %zu at 0x%lx instead of 0x%lx\n", what, i, (unsigned long)results[i], (unsigned long)expected);
+            CHECK(results[i] == expected);
+        }
+    }
+    CHECK(found == expected_found);
+}
+
+static void cases(uint8_t* image)
+{
+    // overlapping matches of one signature and of two: the earliest start each
+    memcpy(image + 0x1000, "\x5a\x5a\x5a\x5a\x5a\xa5\x5a\xa5\x5a", 9);
+    set_text(0, "5A 5A 5A", 0);
+    set_text(1, "5A A5 5A", 4);
+    set_text(2, "A5 5A A5", -4);
+    set_text(3, "5A 5A 5A 5A 5A A5", 0);
+    compare("overlapping", 4);
+
+    // one anchor bucket, either the same byte pair or only the same first byte
+    memcpy(image + 0x2000, "\x7c\x08\x02\xa6\xf8\x21\xff\x91", 8);
+    memcpy(image + 0x2100, "\x7c\x08\x03\xa6\x4e\x80\x00\x20", 8);
+    memcpy(image + 0x2200, "\x7c\x69\x1b\x78\x4e\x80\x00\x20", 8);
+    set_text(0, "7C 08 02 A6 F8 21", 0);
+    set_text(1, "7C 08 03 A6", 0);
+    set_text(2, "7C 69 1B 78", 0);
+    set_text(3, "7C 08 ?? A6 4E 80", 0);
+    set_text(4, "7C 0? 1B 78", 0);
+    compare("shared anchor", 5);
+
+    // wildcards where the anchor would be, the anchor moves in or there is none
+    memcpy(image + 0x3000, "\x38\x60\x00\x01\x4e\x80\x00\x20", 8);
+    set_text(0, "?? ?? 00 01 4E 80", 0);
+    set_text(1, "3? 60 ?? 01 4E", 0);
+    set_text(2, "38 ?? ?? ?? 4E ?? 00", 0);
+    set_text(3, "?? ?? ??", 0);
+    set_text(4, "?? 6? ?? 0? 4? 8? ?? 2?", 2);
+    compare("wildcard anchor", 5);
+
+    // the first and last bytes of the image and straddling the windows inside it
+    memcpy(image, "\xe8\x01\x00\x10", 4);
+    memcpy(image + IMAGE_SIZE - 6, "\x7d\x82\x10\x08\xff\xee", 6);
+    memcpy(image + 0x10000 - 3, "\x91\x81\x00\x08\x93\xe1", 6);
+    memcpy(image + 0x30000 - 1, "\x3c\x40\x00\x81\x60\x42", 6);
+    set_text(0, "E8 01 00 10", 0);
+    set_text(1, "7D 82 10 08 FF EE", 0);
+    set_text(2, "82 10 08 FF EE", 1);
+    set_text(3, "91 81 00 08 93 E1", 0);
+    set_text(4, "3C 40 00 81 60 42", 0);
+    set_text(5, "?? EE", 0);
+    set_text(6, "E8 ??", 0);
+    compare("ends", 7);
+}
+
+// Signatures cut from the image with random masks, some cut from a random buffer instead
+static void random_sets(const uint8_t* image)
+{
+    for (int round = 0; round < RANDOM_ROUNDS; round++)
+    {
+        const size_t count = 1 + next_random() % MAX_SIGNATURES;
+        for (size_t i = 0; i < count; i++)
+        {
+            SignatureStorage* storage = &s_storage[i];
+            const uint32_t size = 1 + next_random() % MAX_SIGNATURE_SIZE;
+            const size_t at = next_random() % (IMAGE_SIZE - size);
+            const bool absent = next_random() % 4 == 0;
+            for (uint32_t b = 0; b < size; b++)
+            {
+                storage->bytes[b] = absent ? (uint8_t)next_random() : image[at + b];
+                const uint32_t kind = next_random() % 8;
+                storage->mask[b] = kind == 0 ? 0 : kind == 1 ? 0xf0 : kind == 2 ? 0x0f : 0xff;
+            }
+            const Signature signature = { storage->bytes, storage->mask, size, (int32_t)(next_random() % 16), NULL };
+            s_signatures[i] = signature;
+        }
+        compare("random", count);
+    }
+}
+
+static uint64_t time_batch(size_t count, bool separate)
+{
+    const uint32_t pid = sys_process_getpid();
+    uint64_t best = ~0ull;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        uintptr_t results[MAX_SIGNATURES];
+        host_memory_stats_reset();
+        const uint64_t start = host_time_ns();
+        if (separate)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                results[i] = SignatureScan(pid, IMAGE_BASE, BENCH_SIZE, &s_signatures[i]);
+            }
+        }
+        else
+        {
+            SignatureScanBatch(pid, IMAGE_BASE, BENCH_SIZE, s_signatures, count, results);
+        }
+        const uint64_t ns = host_time_ns() - start;
+        best = ns < best ? ns : best;
+        for (size_t i = 0; i < count; i++)
+        {
+            CHECK(results[i] == 0);
+        }
+    }
+    return best;
+}
+
+// Nothing matches, so every scan runs the whole image
+static void bench(void)
+{
+    for (size_t i = 0; i < MAX_SIGNATURES; i++)
+    {
+        SignatureStorage* storage = &s_storage[i];
+        for (uint32_t b = 0; b < 16; b++)
+        {
+            storage->bytes[b] = (uint8_t)next_random();
+            storage->mask[b] = b % 4 == 3 ? 0 : 0xff;
+        }
+        const Signature signature = { storage->bytes, storage->mask, 16, 0, NULL };
+        s_signatures[i] = signature;
+    }
+
+    const double one = (double)time_batch(1, false) / 1e6;
+    const uint64_t one_reads = g_host_memory_stats.reads;
+    const double batch = (double)time_batch(MAX_SIGNATURES, false) / 1e6;
+    const uint64_t batch_reads = g_host_memory_stats.reads;
+    const double separate = (double)time_batch(MAX_SIGNATURES, true) / 1e6;
+    const uint64_t separate_reads = g_host_memory_stats.reads;
+    printf("batch of 1: %7.2f ms, %llu reads\n", one, (unsigned long long)one_reads);
+    printf("batch of %d: %7.2f ms, %llu reads, %.2fx a batch of 1\n", MAX_SIGNATURES, batch, (unsigned long long)batch_reads, batch / one);
+    printf("%d scans: %7.2f ms, %llu reads, %.2fx the batch\n", MAX_SIGNATURES, separate, (unsigned long long)separate_reads, separate / batch);
+    CHECK(batch_reads == one_reads);
+}
+
+int test_main(void)
+{
+    uint8_t* image = (uint8_t*)host_map(IMAGE_BASE, BENCH_SIZE);
+    CHECK(image != NULL);
+    if (!image)
+    {
+        return TEST_RESULT();
+    }
+    fill(image, BENCH_SIZE);
+
+    cases(image);
+    random_sets(image);
+    bench();
+
+    host_unmap(IMAGE_BASE, BENCH_SIZE);
+    return TEST_RESULT();
+}
@@ -0,0 +1,51 @@
+// CompileSignature evaluated by the compiler (this file is built as C++14) against SignatureParse and
+// SignaturePrepare, which the units library builds as C++11 like the console's SNC: the inline fallback.
+#include "host_test.h"
+#include "Memory/SignatureCompiler.hpp"
+
+#include <string.h>
+
+#if !defined(SIGNATURE_COMPILE_TIME)
+#error "signature_compiler_test has to be built with constexpr CompileSignature"
+#endif
+
+template <size_t Capacity>
+static void compare(const char* text, const CompiledSignature<Capacity>& compiled)
+{
+    uint8_t bytes[Capacity];
+    uint8_t mask[Capacity];
+    const uint32_t size = SignatureParse(text, bytes, mask, Capacity);
+    CHECK(size == compiled.size);
+    CHECK(memcmp(bytes, compiled.bytes, size) == 0);
+    CHECK(memcmp(mask, compiled.mask, size) == 0);
+
+    const Signature signature = { bytes, mask, size, 0, NULL };
+    SignatureSkip skip;
+    SignaturePrepare(&signature, &skip);
+    if (memcmp(&skip, &compiled.skip, sizeof(skip)) != 0)
+    {
+        printf("%s: the run time skip table differs\n", text);
+        CHECK(memcmp(&skip, &compiled.skip, sizeof(skip)) == 0);
+    }
+}
+
+#define COMPARE(text)                                                    \
+    do                                                                   \
+    {                                                                    \
+        SIGNATURE_STORAGE auto compiled = CompileSignature(text);        \
+        compare(text, compiled);                                         \
+    } while (0)
+
+int test_main(void)
+{
+    CHECK(SignatureCompilerCheck());
+
+    COMPARE("80 1F 00 08 2F 80 00 00 78 1F 00 20 7F E3 FB 78 41 9E ?? ?? ?? ?? ?? ?? 7F E3 FB 78 ?? ?? ?? ??");
+    COMPARE("7C 08 02 A6 4? ?? F8 21 FF 91 38 60 00 01 ? ??");
+    COMPARE("?? ?? 00 01 4E 80 00 20");
+    COMPARE("3? 6? ?0 ?1");
+    COMPARE("00 00 00 00 FF FF FF FF");
+    COMPARE("E8");
+    COMPARE("?");
+    return TEST_RESULT();
+}
@@ -0,0 +1,141 @@
+// SignatureFind's vector kernel against its scalar Horspool loop and a naive reference,
+// then the throughput of both. Clearing SignatureSkip.rare forces the scalar loop.
+#include "host_test.h"
+#include "Memory/SignatureScan.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#define DATA_SIZE 0x4000
+#define ROUNDS 20000
+#define BENCH_SIZE (32 * 1024 * 1024)
+#define BENCH_ROUNDS 5
+
+static uint32_t s_seed = 0x9e3779b9;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static size_t naive_find(const Signature* signature, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i + signature->size <= size; i++)
+    {
+        size_t j = 0;
+        while (j < signature->size && ((data[i + j] ^ signature->bytes[j]) & (signature->mask ? signature->mask[j] : 0xff)) == 0)
+        {
+            j++;
+        }
+        if (j == signature->size)
+        {
+            return i;
+        }
+    }
+    return SIGNATURE_NOT_FOUND;
+}
+
+// A few byte values only, so near matches are everywhere and every lane of the vector compare gets exercised
+static void equivalence(void)
+{
+    uint8_t* buffer = (uint8_t*)malloc(DATA_SIZE + 16);
+    uint8_t bytes[80], mask[80];
+    int vectored = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        const uint32_t alphabet = 2 + next_random() % 6;
+        // unaligned starts for both the data and the signature
+        uint8_t* data = buffer + next_random() % 16;
+        const size_t size = 1 + next_random() % DATA_SIZE;
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = (uint8_t)(0x40 + next_random() % alphabet);
+        }
+
+        const uint32_t length = 1 + next_random() % 64;
+        const uint32_t shift = next_random() % 16;
+        uint8_t* sigBytes = bytes + shift;
+        uint8_t* sigMask = mask + shift;
+        const bool masked = next_random() & 1;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            sigBytes[i] = (uint8_t)(0x40 + next_random() % alphabet);
+            const uint32_t kind = next_random() % 8;
+            sigMask[i] = !masked || kind > 1 ? 0xff : kind ? 0xf0 : 0x00;
+        }
+        // often present, somewhere random
+        if (length <= size && next_random() % 3)
+        {
+            memcpy(data + next_random() % (size - length + 1), sigBytes, length);
+        }
+
+        const Signature signature = { sigBytes, masked ? sigMask : NULL, length, 0, NULL };
+        SignatureSkip skip;
+        SignaturePrepare(&signature, &skip);
+        SignatureSkip scalar = skip;
+        scalar.rare = SIGNATURE_NO_RARE;
+        vectored += skip.rare != SIGNATURE_NO_RARE;
+
+        const size_t expected = naive_find(&signature, data, size);
+        const size_t vector = SignatureFind(&signature, &skip, data, size);
+        const size_t horspool = SignatureFind(&signature, &scalar, data, size);
+        if (vector != expected || horspool != expected)
+        {
+            printf("round %d: size %zu length %u masked %d: naive %zd vector %zd scalar %zd\n", round, size, length, masked,
+                   (ssize_t)expected, (ssize_t)vector, (ssize_t)horspool);
+            CHECK(vector == expected);
+            CHECK(horspool == expected);
+            break;
+        }
+    }
+    // nearly every signature has a fully compared byte to search for
+    CHECK(vectored > ROUNDS * 3 / 4);
+    free(buffer);
+}
+
+static double throughput(const Signature* signature, const SignatureSkip* skip, const uint8_t* data)
+{
+    uint64_t best = ~0ull;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        const uint64_t start = host_time_ns();
+        CHECK(SignatureFind(signature, skip, data, BENCH_SIZE) == SIGNATURE_NOT_FOUND);
+        const uint64_t ns = host_time_ns() - start;
+        best = ns < best ? ns : best;
+    }
+    return (double)BENCH_SIZE / (double)best;  // bytes per ns is GB/s
+}
+
+// PPU-like code, the signature absent so the whole buffer is scanned
+static void benchmark(void)
+{
+    uint8_t* data = (uint8_t*)malloc(BENCH_SIZE);
+    for (size_t i = 0; i < BENCH_SIZE; i += 4)
+    {
+        const uint32_t word = (next_random() % 4 ? 0x38000000 : 0x7c000000) | (next_random() & 0x001fffff);
+        data[i] = (uint8_t)(word >> 24), data[i + 1] = (uint8_t)(word >> 16), data[i + 2] = (uint8_t)(word >> 8), data[i + 3] = (uint8_t)word;
+    }
+
+    static const uint8_t bytes[] = { 0x80, 0x1f, 0x00, 0x08, 0x2f, 0x80, 0x00, 0x00, 0x78, 0x1f, 0x00, 0x20, 0x7f, 0xe3, 0xfb, 0x78 };
+    static const uint8_t mask[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0xff, 0xff };
+    const Signature signature = { bytes, mask, sizeof(bytes), 0, NULL };
+    SignatureSkip skip;
+    SignaturePrepare(&signature, &skip);
+    SignatureSkip scalar = skip;
+    scalar.rare = SIGNATURE_NO_RARE;
+
+    const double vector = throughput(&signature, &skip, data);
+    const double horspool = throughput(&signature, &scalar, data);
+    printf("SignatureFind over %d MB: vector %.2f GB/s, scalar %.2f GB/s\n", BENCH_SIZE >> 20, vector, horspool);
+    free(data);
+}
+
+int test_main(void)
+{
+    equivalence();
+    benchmark();
+    return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+// SignatureScanParallel: same result as SignatureScan for 1-4 threads wherever the match is,
+// and how the scan time scales with the thread count on a 16 MB image.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/SignatureScan.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/process.h>
+
+#define IMAGE_BASE HOST_GAME_WINDOW_BASE
+#define IMAGE_SIZE (16 * 1024 * 1024)
+#define BENCH_ROUNDS 3
+
+static uint32_t s_seed = 0x7f4a7c15;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static const uint8_t s_bytes[] = { 0x80, 0x1f, 0x00, 0x08, 0x2f, 0x80, 0x00, 0x00, 0x78, 0x1f, 0x00, 0x20, 0x7f, 0xe3, 0xfb, 0x78 };
+
+static void fill(uint8_t* image, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        image[i] = (uint8_t)next_random();
+    }
+}
+
+static void check_at(uint8_t* image, const Signature* signature, size_t at)
+{
+    const uint32_t pid = sys_process_getpid();
+    memcpy(image + at, s_bytes, sizeof(s_bytes));
+    const uintptr_t expected = SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, signature);
+    CHECK(expected == IMAGE_BASE + at + signature->offset);
+    for (uint32_t threads = 1; threads <= SIGNATURE_SCAN_MAX_THREADS + 1; threads++)
+    {
+        const uintptr_t found = SignatureScanParallel(pid, IMAGE_BASE, IMAGE_SIZE, signature, threads);
+        if (found != expected)
+        {
+            printf("match at 0x%zx, %u thread(s): 0x%lx instead of 0x%lx\n", at, threads, (unsigned long)found, (unsigned long)expected);
+            CHECK(found == expected);
+        }
+    }
+    fill(image + at, sizeof(s_bytes));
+}
+
+static void equivalence(uint8_t* image, const Signature* signature)
+{
+    const uint32_t pid = sys_process_getpid();
+    for (uint32_t threads = 1; threads <= SIGNATURE_SCAN_MAX_THREADS; threads++)
+    {
+        CHECK(SignatureScanParallel(pid, IMAGE_BASE, IMAGE_SIZE, signature, threads) == 0);
+    }
+
+    // the start, the end, and across every slice boundary for 2, 3 and 4 threads
+    check_at(image, signature, 0);
+    check_at(image, signature, IMAGE_SIZE - sizeof(s_bytes));
+    for (uint32_t threads = 2; threads <= SIGNATURE_SCAN_MAX_THREADS; threads++)
+    {
+        const size_t slice = (IMAGE_SIZE + threads - 1) / threads;
+        for (uint32_t i = 1; i < threads; i++)
+        {
+            check_at(image, signature, slice * i - sizeof(s_bytes) / 2);
+            check_at(image, signature, slice * i - sizeof(s_bytes));
+            check_at(image, signature, slice * i);
+        }
+    }
+    for (int i = 0; i < 32; i++)
+    {
+        check_at(image, signature, next_random() % (IMAGE_SIZE - sizeof(s_bytes)));
+    }
+
+    // two matches in different slices: the earlier one, even though its slice is the slower to get there
+    memcpy(image + IMAGE_SIZE / 4 - 0x100, s_bytes, sizeof(s_bytes));
+    memcpy(image + IMAGE_SIZE / 2 + 0x100, s_bytes, sizeof(s_bytes));
+    for (uint32_t threads = 1; threads <= SIGNATURE_SCAN_MAX_THREADS; threads++)
+    {
+        CHECK(SignatureScanParallel(pid, IMAGE_BASE, IMAGE_SIZE, signature, threads) == IMAGE_BASE + IMAGE_SIZE / 4 - 0x100 + signature->offset);
+    }
+    fill(image + IMAGE_SIZE / 4 - 0x100, sizeof(s_bytes));
+    fill(image + IMAGE_SIZE / 2 + 0x100, sizeof(s_bytes));
+}
+
+static void scaling(const Signature* signature)
+{
+    const uint32_t pid = sys_process_getpid();
+    printf("%ld cpu(s) online\n", sysconf(_SC_NPROCESSORS_ONLN));
+    double single = 0;
+    for (uint32_t threads = 1; threads <= SIGNATURE_SCAN_MAX_THREADS; threads++)
+    {
+        uint64_t best = ~0ull;
+        for (int round = 0; round < BENCH_ROUNDS; round++)
+        {
+            host_memory_stats_reset();
+            const uint64_t start = host_time_ns();
+            CHECK(SignatureScanParallel(pid, IMAGE_BASE, IMAGE_SIZE, signature, threads) == 0);
+            const uint64_t ns = host_time_ns() - start;
+            best = ns < best ? ns : best;
+        }
+        const double ms = (double)best / 1e6;
+        single = threads == 1 ? ms : single;
+        printf("%u thread(s): %7.2f ms, %.2fx, %llu reads\n", threads, ms, single / ms, (unsigned long long)g_host_memory_stats.reads);
+    }
+}
+
+int test_main(void)
+{
+    uint8_t* image = (uint8_t*)host_map(IMAGE_BASE, IMAGE_SIZE);
+    CHECK(image != NULL);
+    if (!image)
+    {
+        return TEST_RESULT();
+    }
+    fill(image, IMAGE_SIZE);
+
+    SignatureSkip skip;
+    Signature signature = { s_bytes, NULL, sizeof(s_bytes), 12, NULL };
+    SignaturePrepare(&signature, &skip);
+    signature.skip = &skip;
+
+    equivalence(image, &signature);
+    scaling(&signature);
+
+    host_unmap(IMAGE_BASE, IMAGE_SIZE);
+    return TEST_RESULT();
+}
@@ -0,0 +1,186 @@
+// SignatureScan over synthetic multi-MB code images, checked and timed against the
+// PatternScan it replaced.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/SignatureScan.h"
+#include "Memory/Memory.h"
+
+#include <string.h>
+#include <sys/process.h>
+
+#define IMAGE_BASE HOST_GAME_WINDOW_BASE
+#define IMAGE_SIZE (8 * 1024 * 1024)
+#define BENCH_ROUNDS 3
+
+static uint32_t s_seed = 0x2545f491;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+// Looks like PPU code: a handful of common opcodes with random operands, big endian words
+static void fill_code(uint8_t* image, size_t size)
+{
+    static const uint32_t opcodes[] = { 0x38000000, 0x80000000, 0x90000000, 0x7c000000, 0x48000000, 0x41800000, 0xe8000000, 0xf8000000 };
+    for (size_t i = 0; i + 4 <= size; i += 4)
+    {
+        const uint32_t word = opcodes[next_random() % 8] | (next_random() & 0x03ffffff);
+        image[i] = (uint8_t)(word >> 24);
+        image[i + 1] = (uint8_t)(word >> 16);
+        image[i + 2] = (uint8_t)(word >> 8);
+        image[i + 3] = (uint8_t)word;
+    }
+}
+
+// The scanner before SignatureScan, 0xff bytes in the signature are wildcards. Unchanged except that
+// seek_buf is padded: the original compared past its 256 bytes into whatever followed on the stack.
+static uintptr_t PatternScan(sys_pid_t process, const uintptr_t module_base, const uint64_t module_size, const void* signature, const uint64_t signature_size, const uint64_t offset)
+{
+#define seek_size 256
+    if (!module_base || !module_size || !signature_size || signature_size > seek_size)
+    {
+        return 0;
+    }
+    for (uintptr_t seek = module_base; seek < ((module_base + module_size) - signature_size); seek += seek_size)
+    {
+        uint8_t seek_buf[seek_size * 2];
+        memset(seek_buf, 0, sizeof(seek_buf));
+        if (ReadProcessMemory(process, (void*)seek, seek_buf, seek_size) == 0)
+        {
+            const uint8_t* scanBytes = seek_buf;
+            const uint8_t* patternBytes = (uint8_t*)signature;
+            for (uint64_t i = 0; i < seek_size; i++)
+            {
+                uint8_t found = 1;
+                for (int32_t j = 0; j < signature_size; j++)
+                {
+                    if (scanBytes[i + j] != patternBytes[j] &&
+                        patternBytes[j] != 0xff)
+                    {
+                        found = 0;
+                        break;
+                    }
+                }
+                if (found)
+                {
+                    return (seek + (((uintptr_t)&scanBytes[i] - (uintptr_t)&scanBytes[0]) + offset));
+                }
+            }
+        }
+    }
+#undef seek_size
+    return 0;
+}
+
+// the start_plugin signature from prx.cpp, wildcards as 0xff for PatternScan and as mask bits for SignatureScan
+static const uint8_t s_pattern[] = {
+    0x2f, 0x80, 0x00, 0x00, 0x78, 0x1f, 0x00, 0x20, 0x7f, 0xe3, 0xfb, 0x78, 0x41, 0x9e, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0x38, 0x60, 0x00, 0x01, 0x4e, 0x80, 0x00, 0x20,
+};
+static const uint8_t s_mask[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+static void plant(uint8_t* image, size_t at)
+{
+    for (size_t i = 0; i < sizeof(s_pattern); i++)
+    {
+        image[at + i] = s_mask[i] ? s_pattern[i] : (uint8_t)next_random();
+    }
+}
+
+static void correctness(uint8_t* image, const Signature* signature)
+{
+    const uint32_t pid = sys_process_getpid();
+
+    // not present at all
+    CHECK(SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, signature) == 0);
+    CHECK(PatternScan(pid, IMAGE_BASE, IMAGE_SIZE, s_pattern, sizeof(s_pattern), 0) == 0);
+
+    // crossing a 64 KB read window, which the scanner must still see whole
+    const size_t crossing = 0x30000 - 10;
+    plant(image, crossing);
+    CHECK(SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, signature) == IMAGE_BASE + crossing);
+    fill_code(image + crossing, 32);
+
+    // a real 0xff byte in the signature is compared, PatternScan took it for a wildcard
+    const uint8_t ffBytes[] = { 0x7c, 0x08, 0x02, 0xa6, 0xff, 0x10 };
+    const Signature ff = { ffBytes, NULL, sizeof(ffBytes), 0, NULL };
+    memcpy(image + 0x1000, ffBytes, sizeof(ffBytes));
+    image[0x1004] = 0xfe;
+    memcpy(image + 0x2000, ffBytes, sizeof(ffBytes));
+    CHECK(SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, &ff) == IMAGE_BASE + 0x2000);
+    CHECK(PatternScan(pid, IMAGE_BASE, IMAGE_SIZE, ffBytes, sizeof(ffBytes), 0) == IMAGE_BASE + 0x1000);
+    fill_code(image + 0x1000, 0x1010);
+
+    // the last bytes of the range
+    const size_t tail = IMAGE_SIZE - sizeof(s_pattern);
+    plant(image, tail);
+    CHECK(SignatureScan(pid, IMAGE_BASE, IMAGE_SIZE, signature) == IMAGE_BASE + tail);
+    fill_code(image + tail, sizeof(s_pattern));
+}
+
+static void benchmark(uint8_t* image, const Signature* signature, size_t size)
+{
+    const uint32_t pid = sys_process_getpid();
+
+    // near the end and inside one of PatternScan's chunks, so both scan the whole image and agree
+    const size_t at = (size - 0x1000) & ~0xff;
+    plant(image, at);
+
+    uint64_t oldNs = 0, newNs = 0, oldReads = 0, newReads = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        host_memory_stats_reset();
+        uint64_t start = host_time_ns();
+        const uintptr_t old = PatternScan(pid, IMAGE_BASE, size, s_pattern, sizeof(s_pattern), 0);
+        oldNs += host_time_ns() - start;
+        oldReads += g_host_memory_stats.reads;
+
+        host_memory_stats_reset();
+        start = host_time_ns();
+        const uintptr_t found = SignatureScan(pid, IMAGE_BASE, size, signature);
+        newNs += host_time_ns() - start;
+        newReads += g_host_memory_stats.reads;
+
+        CHECK(old == IMAGE_BASE + at);
+        CHECK(found == old);
+    }
+    fill_code(image + at, sizeof(s_pattern));
+
+    const double mb = (double)size / (1024 * 1024);
+    const double oldMs = (double)oldNs / BENCH_ROUNDS / 1e6;
+    const double newMs = (double)newNs / BENCH_ROUNDS / 1e6;
+    printf("%4.0f MB: PatternScan %8.2f ms %7llu reads, SignatureScan %7.2f ms %4llu reads, %.1fx\n", mb, oldMs,
+           (unsigned long long)(oldReads / BENCH_ROUNDS), newMs, (unsigned long long)(newReads / BENCH_ROUNDS), oldMs / newMs);
+    CHECK(newReads * 200 < oldReads);
+    CHECK(newNs < oldNs);
+}
+
+int test_main(void)
+{
+    uint8_t* image = (uint8_t*)host_map(IMAGE_BASE, IMAGE_SIZE);
+    CHECK(image != NULL);
+    if (!image)
+    {
+        return TEST_RESULT();
+    }
+    fill_code(image, IMAGE_SIZE);
+
+    SignatureSkip skip;
+    Signature signature = { s_pattern, s_mask, sizeof(s_pattern), 0, NULL };
+    SignaturePrepare(&signature, &skip);
+    signature.skip = &skip;
+
+    correctness(image, &signature);
+    for (size_t size = 2 * 1024 * 1024; size <= IMAGE_SIZE; size *= 2)
+    {
+        benchmark(image, &signature, size);
+    }
+
+    host_unmap(IMAGE_BASE, IMAGE_SIZE);
+    return TEST_RESULT();
+}
@@ -0,0 +1,45 @@
+#pragma once
+// Plain C++ versions of the AltiVec intrinsics the plugins use, so the VMX code paths
+// run on the host. Same results as the PPU, including vec_ld ignoring the low address bits.
+#include <stdint.h>
+#include <string.h>
+#include "vec_types.h"
+
+inline vec_uchar16 vec_ld(int offset, const uint8_t* p)
+{
+    vec_uchar16 v;
+    memcpy(&v, (const void*)(((uintptr_t)p + offset) & ~(uintptr_t)15), sizeof(v));
+    return v;
+}
+
+inline vec_uchar16 vec_splats(uint8_t x)
+{
+    vec_uchar16 v;
+    memset(&v, x, sizeof(v));
+    return v;
+}
+
+inline vec_uchar16 vec_lvsl(int offset, const uint8_t* p)
+{
+    const vec_uchar16 lanes = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    return lanes + vec_splats((uint8_t)(((uintptr_t)p + offset) & 15));
+}
+
+// lanes 0-15 of the selector pick from a, 16-31 from b
+inline vec_uchar16 vec_perm(vec_uchar16 a, vec_uchar16 b, vec_uchar16 c)
+{
+    return __builtin_shuffle(a, b, c & vec_splats(31));
+}
+
+inline vec_uchar16 vec_xor(vec_uchar16 a, vec_uchar16 b) { return a ^ b; }
+inline vec_uchar16 vec_and(vec_uchar16 a, vec_uchar16 b) { return a & b; }
+
+inline bool host_any_lane(vec_uchar16 lanes)
+{
+    uint64_t halves[2];
+    memcpy(halves, &lanes, sizeof(halves));
+    return (halves[0] | halves[1]) != 0;
+}
+
+inline bool vec_any_eq(vec_uchar16 a, vec_uchar16 b) { return host_any_lane((vec_uchar16)(a == b)); }
+inline bool vec_any_ne(vec_uchar16 a, vec_uchar16 b) { return host_any_lane(a ^ b); }
@@ -0,0 +1,17 @@
+#pragma once
+#include <sys/fs.h>
+
+#define CELL_FS_SUCCEEDED 0
+
+typedef int CellFsErrno;
+typedef int CellFsMode;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+CellFsErrno cellFsStat(const char* path, CellFsStat* sb);
+CellFsErrno cellFsUnlink(const char* path);
+#if defined(__cplusplus)
+}
+#endif
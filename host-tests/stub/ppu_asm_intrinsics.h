@@ -0,0 +1,3 @@
+#pragma once
+
+#define __ALWAYS_INLINE inline __attribute__((always_inline))
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+#define CELL_FS_O_RDONLY 000000
+#define CELL_FS_O_WRONLY 000001
+#define CELL_FS_O_RDWR 000002
+#define CELL_FS_O_CREAT 000100
+#define CELL_FS_O_TRUNC 001000
+#define CELL_FS_O_APPEND 002000
+
+#define CELL_FS_SEEK_SET 0
+#define CELL_FS_SEEK_CUR 1
+#define CELL_FS_SEEK_END 2
+
+#define CELL_FS_OK 0
+#define CELL_FS_ERROR_ENOENT 0x80010006
+#define CELL_FS_ERROR_EEXIST 0x80010014
+#define CELL_FS_ERROR_EIO 0x8001002b
+
+typedef struct
+{
+    uint32_t st_mode;
+    int32_t st_uid;
+    int32_t st_gid;
+    int64_t st_atime;
+    int64_t st_mtime;
+    int64_t st_ctime;
+    uint64_t st_size;
+    uint64_t st_blksize;
+} CellFsStat;
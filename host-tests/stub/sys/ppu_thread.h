@@ -0,0 +1,21 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+typedef uint64_t sys_ppu_thread_t;
+
+#define SYS_PPU_THREAD_CREATE_JOINABLE 0x1
+#define SYS_PPU_THREAD_ID_INVALID 0xffffffff
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+int sys_ppu_thread_create(sys_ppu_thread_t* thread, void (*entry)(uint64_t), uint64_t arg, int prio, size_t stacksize, uint64_t flags, const char* name);
+void sys_ppu_thread_exit(uint64_t val);
+int sys_ppu_thread_join(sys_ppu_thread_t thread, uint64_t* val);
+void sys_ppu_thread_yield(void);
+#if defined(__cplusplus)
+}
+#endif
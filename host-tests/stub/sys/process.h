@@ -0,0 +1,11 @@
+#pragma once
+#include <sys/types.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+sys_pid_t sys_process_getpid(void);
+#if defined(__cplusplus)
+}
+#endif
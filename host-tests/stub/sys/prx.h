@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int32_t sys_prx_id_t;
+typedef uint64_t sys_prx_flags_t;
+
+typedef struct
+{
+    uint64_t base;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t index;
+    uint64_t type;
+} sys_prx_segment_info_t;
+
+typedef struct
+{
+    uint64_t size;
+    char name[30];
+    char version[2];
+    uint32_t modattribute;
+    uint32_t start_entry;
+    uint32_t stop_entry;
+    uint32_t all_segments_num;
+    sys_addr_t filename;
+    uint32_t filename_size;
+    sys_addr_t segments;
+    uint32_t segments_num;
+} sys_prx_module_info_t;
+
+typedef struct
+{
+    uint64_t size;
+} sys_prx_load_module_option_t;
+typedef sys_prx_load_module_option_t sys_prx_start_module_option_t;
+typedef sys_prx_load_module_option_t sys_prx_stop_module_option_t;
+typedef sys_prx_load_module_option_t sys_prx_unload_module_option_t;
+typedef sys_prx_load_module_option_t sys_prx_get_module_id_by_name_option_t;
+
+#define SYS_MODULE_INFO(...)
+#define SYS_MODULE_START(...)
+#define SYS_MODULE_STOP(...)
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+sys_prx_id_t sys_prx_load_module(const char* path, sys_prx_flags_t flags, sys_prx_load_module_option_t* option);
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+typedef uint32_t sys_mutex_t;
+typedef uint64_t usecond_t;
+
+#define SYS_SYNC_NAME_SIZE 8
+#define SYS_SYNC_FIFO 0x1
+#define SYS_SYNC_PRIORITY 0x2
+#define SYS_SYNC_PRIORITY_INHERIT 0x3
+#define SYS_SYNC_RECURSIVE 0x10
+#define SYS_SYNC_NOT_RECURSIVE 0x20
+#define SYS_SYNC_NOT_PROCESS_SHARED 0x200
+#define SYS_SYNC_NOT_ADAPTIVE 0x2000
+
+typedef struct
+{
+    uint32_t attr_protocol;
+    uint32_t attr_recursive;
+    uint32_t attr_pshared;
+    uint32_t attr_adaptive;
+    uint64_t key;
+    int flags;
+    uint32_t pad;
+    char name[SYS_SYNC_NAME_SIZE];
+} sys_mutex_attribute_t;
+
+#define sys_mutex_attribute_initialize(x)            \
+    do                                               \
+    {                                                \
+        (x).attr_protocol = SYS_SYNC_PRIORITY;       \
+        (x).attr_recursive = SYS_SYNC_NOT_RECURSIVE; \
+        (x).attr_pshared = SYS_SYNC_NOT_PROCESS_SHARED; \
+        (x).attr_adaptive = SYS_SYNC_NOT_ADAPTIVE;   \
+        (x).key = 0;                                 \
+        (x).flags = 0;                               \
+        (x).name[0] = '\0';                          \
+    } while (0)
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+int sys_mutex_create(sys_mutex_t* mutex, sys_mutex_attribute_t* attr);
+int sys_mutex_destroy(sys_mutex_t mutex);
+int sys_mutex_lock(sys_mutex_t mutex, usecond_t timeout);
+int sys_mutex_unlock(sys_mutex_t mutex);
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+
+typedef int64_t system_time_t;
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+system_time_t sys_time_get_system_time(void);
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// Calls go to the fake kernel in support/host_lv2.c
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+uint64_t host_syscall(uint64_t num, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5, uint64_t a6, uint64_t a7, uint64_t a8);
+#if defined(__cplusplus)
+}
+#endif
+
+#define system_call_0(n) uint64_t __r = host_syscall(n, 0, 0, 0, 0, 0, 0, 0, 0)
+#define system_call_1(n, a) uint64_t __r = host_syscall(n, (uint64_t)(a), 0, 0, 0, 0, 0, 0, 0)
+#define system_call_2(n, a, b) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), 0, 0, 0, 0, 0, 0)
+#define system_call_3(n, a, b, c) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), 0, 0, 0, 0, 0)
+#define system_call_4(n, a, b, c, d) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d), 0, 0, 0, 0)
+#define system_call_5(n, a, b, c, d, e) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d), (uint64_t)(e), 0, 0, 0)
+#define system_call_6(n, a, b, c, d, e, f) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d), (uint64_t)(e), (uint64_t)(f), 0, 0)
+#define system_call_7(n, a, b, c, d, e, f, g) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d), (uint64_t)(e), (uint64_t)(f), (uint64_t)(g), 0)
+#define system_call_8(n, a, b, c, d, e, f, g, h) uint64_t __r = host_syscall(n, (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d), (uint64_t)(e), (uint64_t)(f), (uint64_t)(g), (uint64_t)(h))
+#define return_to_user_prog(type) return (type)__r
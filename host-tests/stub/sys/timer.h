@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+int sys_timer_sleep(uint32_t seconds);
+int sys_timer_usleep(uint64_t microseconds);
+#if defined(__cplusplus)
+}
+#endif
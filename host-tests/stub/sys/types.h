@@ -0,0 +1,10 @@
+#pragma once
+// lv2 types on top of the host's sys/types.h
+#include_next <sys/types.h>
+#include <stdint.h>
+
+typedef uint32_t sys_pid_t;
+typedef uint32_t sys_addr_t;
+
+// sys/return_code.h
+#define SUCCEEDED 0
@@ -0,0 +1,5 @@
+#pragma once
+// The VMX vector types the plugins use, as GCC generic vectors
+#include <stdint.h>
+
+typedef uint8_t vec_uchar16 __attribute__((vector_size(16)));
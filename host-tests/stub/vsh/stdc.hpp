@@ -0,0 +1,29 @@
+#pragma once
+// vsh:: exports used by the shared code, backed by the C library on the host
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace vsh
+{
+inline void* malloc(size_t size) { return ::malloc(size); }
+inline void free(void* p) { ::free(p); }
+inline void* memset(void* p, int value, size_t size) { return ::memset(p, value, size); }
+inline void* memcpy(void* dst, const void* src, size_t size) { return ::memcpy(dst, src, size); }
+inline int strcmp(const char* a, const char* b) { return ::strcmp(a, b); }
+inline size_t strlen(const char* s) { return ::strlen(s); }
+inline FILE* fopen(const char* path, const char* mode) { return ::fopen(path, mode); }
+inline size_t fread(void* p, size_t size, size_t count, FILE* fd) { return ::fread(p, size, count, fd); }
+inline size_t fwrite(const void* p, size_t size, size_t count, FILE* fd) { return ::fwrite(p, size, count, fd); }
+inline int fclose(FILE* fd) { return ::fclose(fd); }
+
+inline int printf(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int written = ::vprintf(format, args);
+    va_end(args);
+    return written;
+}
+}  // namespace vsh
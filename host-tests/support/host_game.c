@@ -0,0 +1,10 @@
+// What prx.cpp and plugins.c provide to game_patch on the console
+#include "plugins.h"
+
+program_args* g_args = NULL;
+
+bool append_arg(program_args* pargs, const char* arg)
+{
+    (void)pargs, (void)arg;
+    return false;
+}
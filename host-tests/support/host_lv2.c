@@ -0,0 +1,555 @@
+#define _GNU_SOURCE
+#include "host_lv2.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+// CellFsStat uses the plain names
+#undef st_atime
+#undef st_mtime
+#undef st_ctime
+
+#include <cell/cell_fs.h>
+#include <sys/ppu_thread.h>
+#include <sys/process.h>
+#include <sys/prx.h>
+#include <sys/sys_time.h>
+#include <sys/synchronization.h>
+#include <sys/syscall.h>
+#include <sys/timer.h>
+
+#define HOST_PID 0x01000500
+#define HOST_MAX_MODULES 128
+#define HOST_THREAD_STACK (1024 * 1024)
+#define HOST_MAX_MUTEXES 16
+
+#define SC_COBRA_SYSCALL8 8
+#define SYSCALL8_OPCODE_PS3MAPI 0x7777
+#define PS3MAPI_OPCODE_GET_FW_VERSION 0x0014
+#define PS3MAPI_OPCODE_GET_PROC_MEM 0x0031
+#define PS3MAPI_OPCODE_SET_PROC_MEM 0x0032
+#define PS3MAPI_OPCODE_PROC_PAGE_ALLOCATE 0x0033
+#define PS3MAPI_OPCODE_PROC_PAGE_FREE 0x0034
+#define PS3MAPI_OPCODE_GET_ALL_PROC_MODULE_PID 0x0041
+#define PS3MAPI_OPCODE_GET_PROC_MODULE_NAME 0x0042
+#define PS3MAPI_OPCODE_GET_PROC_MODULE_FILENAME 0x0043
+#define PS3MAPI_OPCODE_GET_PROC_MODULE_SEGMENTS 0x0048
+
+#define HOST_PTR(a) ((void*)(uintptr_t)(a))
+
+HostMemoryStats g_host_memory_stats;
+uint32_t g_host_fw_version = 0x490;
+
+void host_memory_stats_reset(void)
+{
+    memset(&g_host_memory_stats, 0, sizeof(g_host_memory_stats));
+}
+
+static bool s_window_reserved = false;
+
+static bool in_game_window(uint32_t addr, uint32_t size)
+{
+    return s_window_reserved && addr >= HOST_GAME_WINDOW_BASE && (uint64_t)addr + size <= (uint64_t)HOST_GAME_WINDOW_BASE + HOST_GAME_WINDOW_SIZE;
+}
+
+void host_reserve_game_window(void)
+{
+    void* p = mmap(HOST_PTR(HOST_GAME_WINDOW_BASE), HOST_GAME_WINDOW_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    s_window_reserved = p == HOST_PTR(HOST_GAME_WINDOW_BASE);
+    if (!s_window_reserved)
+    {
+        printf("host: couldn't reserve the game window at 0x%08x\n", HOST_GAME_WINDOW_BASE);
+    }
+}
+
+void* host_map(uint32_t addr, uint32_t size)
+{
+    // inside the reserved window the placeholder is replaced, anywhere else nothing may be there yet
+    const int fixed = in_game_window(addr, size) ? MAP_FIXED : MAP_FIXED_NOREPLACE;
+    void* p = mmap(HOST_PTR(addr), size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | fixed, -1, 0);
+    if (p == MAP_FAILED || p != HOST_PTR(addr))
+    {
+        printf("host_map 0x%08x (0x%x) failed\n", addr, size);
+        return NULL;
+    }
+    return p;
+}
+
+void host_unmap(uint32_t addr, uint32_t size)
+{
+    if (in_game_window(addr, size))
+    {
+        mmap(HOST_PTR(addr), size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+        return;
+    }
+    munmap(HOST_PTR(addr), size);
+}
+
+// both take the process address first and the caller's buffer second, like the syscalls
+static int memory_read(uint64_t addr, uint64_t buf, uint64_t size)
+{
+    g_host_memory_stats.reads++;
+    g_host_memory_stats.read_bytes += size;
+    // unmapped memory fails the call like it does on lv2 instead of faulting
+    struct iovec local = { HOST_PTR(buf), size };
+    struct iovec remote = { HOST_PTR(addr), size };
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == (ssize_t)size ? 0 : -1;
+}
+
+static int memory_write(uint64_t dst, uint64_t src, uint64_t size)
+{
+    g_host_memory_stats.writes++;
+    g_host_memory_stats.written_bytes += size;
+    memmove(HOST_PTR(dst), HOST_PTR(src), size);
+    return 0;
+}
+
+typedef struct
+{
+    int32_t id;
+    char filename[256];
+    sys_prx_segment_info_t segments[2];
+} HostModule;
+
+static HostModule s_modules[HOST_MAX_MODULES];
+static size_t s_module_count;
+
+void host_modules_clear(void)
+{
+    memset(s_modules, 0, sizeof(s_modules));
+    s_module_count = 0;
+}
+
+int32_t host_module_add(const char* filename, uint32_t text_base, uint32_t text_size, uint32_t data_base, uint32_t data_size)
+{
+    if (s_module_count >= HOST_MAX_MODULES)
+    {
+        return 0;
+    }
+    HostModule* m = &s_modules[s_module_count++];
+    m->id = 0x23000000 + (int32_t)s_module_count;
+    snprintf(m->filename, sizeof(m->filename), "%s", filename);
+    m->segments[0].base = text_base;
+    m->segments[0].filesz = m->segments[0].memsz = text_size;
+    m->segments[0].type = 1;
+    m->segments[1].base = data_base;
+    m->segments[1].filesz = m->segments[1].memsz = data_size;
+    m->segments[1].index = 1;
+    m->segments[1].type = 1;
+    return m->id;
+}
+
+static const HostModule* find_module(uint64_t id)
+{
+    for (size_t i = 0; i < s_module_count; i++)
+    {
+        if (s_modules[i].id == (int32_t)id)
+        {
+            return &s_modules[i];
+        }
+    }
+    return NULL;
+}
+
+static int module_segments(uint64_t id, uint64_t info_addr)
+{
+    const HostModule* m = find_module(id);
+    sys_prx_module_info_t* info = (sys_prx_module_info_t*)HOST_PTR(info_addr);
+    if (!m)
+    {
+        return -1;
+    }
+    if (info->filename && info->filename_size)
+    {
+        snprintf((char*)HOST_PTR(info->filename), info->filename_size, "%s", m->filename);
+    }
+    const uint32_t count = m->segments[1].memsz ? 2 : 1;
+    const uint32_t n = info->segments_num < count ? info->segments_num : count;
+    memcpy(HOST_PTR(info->segments), m->segments, sizeof(sys_prx_segment_info_t) * n);
+    info->segments_num = n;
+    return 0;
+}
+
+static int page_allocate(uint64_t size, uint64_t page_table_addr)
+{
+    uint64_t* page_table = (uint64_t*)HOST_PTR(page_table_addr);
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return -1;
+    }
+    page_table[0] = page_table[1] = (uintptr_t)p;
+    return 0;
+}
+
+static uint64_t ps3mapi(uint64_t op, uint64_t a3, uint64_t a4, uint64_t a5, uint64_t a6, uint64_t a7, uint64_t a8)
+{
+    (void)a3;
+    switch (op)
+    {
+        case PS3MAPI_OPCODE_GET_PROC_MEM:
+            return memory_read(a4, a5, a6);
+        case PS3MAPI_OPCODE_SET_PROC_MEM:
+            return memory_write(a4, a5, a6);
+        case PS3MAPI_OPCODE_PROC_PAGE_ALLOCATE:
+            (void)a5, (void)a6, (void)a7;
+            return page_allocate(a4, a8);
+        case PS3MAPI_OPCODE_PROC_PAGE_FREE:
+            return 0;
+        case PS3MAPI_OPCODE_GET_ALL_PROC_MODULE_PID:
+        {
+            int32_t* ids = (int32_t*)HOST_PTR(a4);
+            for (size_t i = 0; i < s_module_count; i++)
+            {
+                ids[i] = s_modules[i].id;
+            }
+            return 0;
+        }
+        case PS3MAPI_OPCODE_GET_PROC_MODULE_NAME:
+        case PS3MAPI_OPCODE_GET_PROC_MODULE_FILENAME:
+        {
+            const HostModule* m = find_module(a4);
+            if (!m)
+            {
+                return -1;
+            }
+            const char* name = m->filename;
+            if (op == PS3MAPI_OPCODE_GET_PROC_MODULE_NAME && strrchr(name, '/'))
+            {
+                name = strrchr(name, '/') + 1;
+            }
+            strcpy((char*)HOST_PTR(a5), name);
+            return 0;
+        }
+        case PS3MAPI_OPCODE_GET_PROC_MODULE_SEGMENTS:
+            return module_segments(a4, a5);
+        case PS3MAPI_OPCODE_GET_FW_VERSION:
+            return g_host_fw_version;
+        default:
+            printf("host: ps3mapi opcode 0x%llx isn't faked\n", (unsigned long long)op);
+            return -1;
+    }
+}
+
+static char s_fs_root[512] = "/tmp";
+
+void host_fs_set_root(const char* dir)
+{
+    snprintf(s_fs_root, sizeof(s_fs_root), "%s", dir);
+}
+
+const char* host_fs_temp_root(void)
+{
+    char dir[] = "/tmp/ps3_host_test_XXXXXX";
+    if (mkdtemp(dir))
+    {
+        host_fs_set_root(dir);
+    }
+    return s_fs_root;
+}
+
+const char* host_fs_path(const char* lv2_path, char* out, size_t size)
+{
+    snprintf(out, size, "%s%s", s_fs_root, lv2_path);
+    return out;
+}
+
+static void make_parents(const char* path)
+{
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char* p = dir + 1; *p; p++)
+    {
+        if (*p == '/')
+        {
+            *p = 0;
+            mkdir(dir, 0777);
+            *p = '/';
+        }
+    }
+}
+
+// The host branches of patch.c use stdio with lv2 paths, the link wraps fopen to send those here too
+FILE* __real_fopen(const char* path, const char* mode);
+
+FILE* __wrap_fopen(const char* path, const char* mode)
+{
+    if (strncmp(path, "/dev_", 5) != 0)
+    {
+        return __real_fopen(path, mode);
+    }
+    char host_path[1024];
+    host_fs_path(path, host_path, sizeof(host_path));
+    if (mode[0] != 'r')
+    {
+        make_parents(host_path);
+    }
+    return __real_fopen(host_path, mode);
+}
+
+int host_fs_write(const char* lv2_path, const void* data, size_t size)
+{
+    char path[1024];
+    host_fs_path(lv2_path, path, sizeof(path));
+    make_parents(path);
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        return -1;
+    }
+    const size_t written = fwrite(data, 1, size, f);
+    fclose(f);
+    return written == size ? 0 : -1;
+}
+
+static uint64_t fs_error(void)
+{
+    return errno == ENOENT ? CELL_FS_ERROR_ENOENT : errno == EEXIST ? CELL_FS_ERROR_EEXIST : CELL_FS_ERROR_EIO;
+}
+
+static uint64_t fs_open(const char* lv2_path, int cell_flags, int* fd)
+{
+    char path[1024];
+    host_fs_path(lv2_path, path, sizeof(path));
+    int flags = (cell_flags & CELL_FS_O_RDWR) ? O_RDWR : (cell_flags & CELL_FS_O_WRONLY) ? O_WRONLY : O_RDONLY;
+    if (cell_flags & CELL_FS_O_CREAT)
+    {
+        flags |= O_CREAT;
+        if (!(cell_flags & (CELL_FS_O_RDWR | CELL_FS_O_WRONLY)))
+        {
+            flags |= O_RDWR;
+        }
+        make_parents(path);
+    }
+    if (cell_flags & CELL_FS_O_TRUNC)
+    {
+        flags |= O_TRUNC;
+    }
+    if (cell_flags & CELL_FS_O_APPEND)
+    {
+        flags |= O_APPEND;
+    }
+    const int h = open(path, flags, 0666);
+    if (h < 0)
+    {
+        return fs_error();
+    }
+    *fd = h;
+    return CELL_FS_OK;
+}
+
+static uint64_t fs_stat(const char* lv2_path, CellFsStat* sb)
+{
+    char path[1024];
+    struct stat st;
+    if (stat(host_fs_path(lv2_path, path, sizeof(path)), &st) != 0)
+    {
+        return fs_error();
+    }
+    memset(sb, 0, sizeof(*sb));
+    sb->st_mode = st.st_mode;
+    sb->st_size = st.st_size;
+    sb->st_mtime = st.st_mtim.tv_sec;
+    sb->st_atime = st.st_atim.tv_sec;
+    sb->st_ctime = st.st_ctim.tv_sec;
+    return CELL_FS_OK;
+}
+
+uint64_t host_syscall(uint64_t num, uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t a5, uint64_t a6, uint64_t a7, uint64_t a8)
+{
+    switch (num)
+    {
+        case SC_COBRA_SYSCALL8:
+            if (a1 == SYSCALL8_OPCODE_PS3MAPI)
+            {
+                return ps3mapi(a2, a3, a4, a5, a6, a7, a8);
+            }
+            return (uint64_t)-1;
+        case 801:  // sys_fs_open
+            return fs_open((const char*)HOST_PTR(a1), (int)a2, (int*)HOST_PTR(a3));
+        case 802:  // sys_fs_read
+        {
+            const ssize_t n = read((int)a1, HOST_PTR(a2), a3);
+            *(uint64_t*)HOST_PTR(a4) = n < 0 ? 0 : (uint64_t)n;
+            return n < 0 ? fs_error() : CELL_FS_OK;
+        }
+        case 803:  // sys_fs_write
+        {
+            const ssize_t n = write((int)a1, HOST_PTR(a2), a3);
+            *(uint64_t*)HOST_PTR(a4) = n < 0 ? 0 : (uint64_t)n;
+            return n < 0 ? fs_error() : CELL_FS_OK;
+        }
+        case 804:  // sys_fs_close
+            return close((int)a1) == 0 ? CELL_FS_OK : fs_error();
+        case 808:  // sys_fs_stat
+            return fs_stat((const char*)HOST_PTR(a1), (CellFsStat*)HOST_PTR(a2));
+        case 814:  // sys_fs_unlink
+        {
+            char path[1024];
+            return unlink(host_fs_path((const char*)HOST_PTR(a1), path, sizeof(path))) == 0 ? CELL_FS_OK : fs_error();
+        }
+        case 818:  // sys_fs_lseek
+        {
+            const int whence = a3 == CELL_FS_SEEK_END ? SEEK_END : a3 == CELL_FS_SEEK_CUR ? SEEK_CUR : SEEK_SET;
+            const off_t pos = lseek((int)a1, (off_t)a2, whence);
+            if (pos < 0)
+            {
+                return fs_error();
+            }
+            *(uint64_t*)HOST_PTR(a4) = (uint64_t)pos;
+            return CELL_FS_OK;
+        }
+        case 904:  // sys_dbg_read_process_memory(pid, addr, size, buf)
+            return memory_read(a2, a4, a3);
+        case 905:  // sys_dbg_write_process_memory(pid, dst, size, src)
+            return memory_write(a2, a4, a3);
+        default:
+            printf("host: syscall %llu isn't faked\n", (unsigned long long)num);
+            return (uint64_t)-1;
+    }
+}
+
+sys_pid_t sys_process_getpid(void)
+{
+    return HOST_PID;
+}
+
+system_time_t sys_time_get_system_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (system_time_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int sys_timer_usleep(uint64_t microseconds)
+{
+    return usleep(microseconds);
+}
+
+int sys_timer_sleep(uint32_t seconds)
+{
+    return sys_timer_usleep((uint64_t)seconds * 1000000);
+}
+
+typedef struct
+{
+    void (*entry)(uint64_t);
+    uint64_t arg;
+} HostThreadStart;
+
+static void* thread_start(void* p)
+{
+    HostThreadStart start = *(HostThreadStart*)p;
+    free(p);
+    start.entry(start.arg);
+    return NULL;
+}
+
+// Threads get their stack below 4 GB like the test's main thread
+int host_thread_create(pthread_t* thread, void* (*entry)(void*), void* arg)
+{
+    void* stack = mmap(NULL, HOST_THREAD_STACK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED)
+    {
+        return -1;
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, HOST_THREAD_STACK);
+    const int ret = pthread_create(thread, &attr, entry, arg);
+    pthread_attr_destroy(&attr);
+    return ret;
+}
+
+int sys_ppu_thread_create(sys_ppu_thread_t* thread, void (*entry)(uint64_t), uint64_t arg, int prio, size_t stacksize, uint64_t flags, const char* name)
+{
+    (void)prio, (void)stacksize, (void)flags, (void)name;
+    HostThreadStart* start = (HostThreadStart*)malloc(sizeof(*start));
+    start->entry = entry;
+    start->arg = arg;
+    pthread_t t;
+    if (host_thread_create(&t, thread_start, start) != 0)
+    {
+        free(start);
+        return -1;
+    }
+    *thread = (sys_ppu_thread_t)t;
+    return 0;
+}
+
+void sys_ppu_thread_exit(uint64_t val)
+{
+    pthread_exit((void*)(uintptr_t)val);
+}
+
+int sys_ppu_thread_join(sys_ppu_thread_t thread, uint64_t* val)
+{
+    void* ret = NULL;
+    const int err = pthread_join((pthread_t)thread, &ret);
+    if (val)
+    {
+        *val = (uint64_t)(uintptr_t)ret;
+    }
+    return err;
+}
+
+void sys_ppu_thread_yield(void)
+{
+    sched_yield();
+}
+
+CellFsErrno cellFsStat(const char* path, CellFsStat* sb)
+{
+    return (CellFsErrno)fs_stat(path, sb);
+}
+
+CellFsErrno cellFsUnlink(const char* path)
+{
+    return (CellFsErrno)host_syscall(814, (uintptr_t)path, 0, 0, 0, 0, 0, 0, 0);
+}
+
+// sys_mutex_t is an index into this, 0 stays invalid
+static pthread_mutex_t s_mutexes[HOST_MAX_MUTEXES];
+static uint32_t s_mutex_count = 0;
+
+int sys_mutex_create(sys_mutex_t* mutex, sys_mutex_attribute_t* attr)
+{
+    if (s_mutex_count + 1 >= HOST_MAX_MUTEXES)
+    {
+        return -1;
+    }
+    pthread_mutexattr_t host_attr;
+    pthread_mutexattr_init(&host_attr);
+    pthread_mutexattr_settype(&host_attr, attr->attr_recursive == SYS_SYNC_RECURSIVE ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_ERRORCHECK);
+    const uint32_t id = ++s_mutex_count;
+    pthread_mutex_init(&s_mutexes[id], &host_attr);
+    pthread_mutexattr_destroy(&host_attr);
+    *mutex = id;
+    return 0;
+}
+
+int sys_mutex_destroy(sys_mutex_t mutex)
+{
+    return mutex && mutex <= s_mutex_count ? pthread_mutex_destroy(&s_mutexes[mutex]) : -1;
+}
+
+int sys_mutex_lock(sys_mutex_t mutex, usecond_t timeout)
+{
+    (void)timeout;
+    return mutex && mutex <= s_mutex_count ? pthread_mutex_lock(&s_mutexes[mutex]) : -1;
+}
+
+int sys_mutex_unlock(sys_mutex_t mutex)
+{
+    return mutex && mutex <= s_mutex_count ? pthread_mutex_unlock(&s_mutexes[mutex]) : -1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// Fake lv2 for the host tests.
+// The tests run with every pointer inside the low 4 GB (see host_test.c), so the 32 bit
+// addresses the console code passes around are real host pointers. On top of that this
+// provides the syscalls the plugins use: process memory, ps3mapi modules and pages, cellFs.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+typedef struct
+{
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t read_bytes;
+    uint64_t written_bytes;
+} HostMemoryStats;
+
+// sys_dbg/ps3mapi process memory calls since the last reset
+extern HostMemoryStats g_host_memory_stats;
+void host_memory_stats_reset(void);
+
+// Game memory goes here. The window is reserved at startup so MAP_32BIT stacks and pages
+// handed out later can't take it.
+#define HOST_GAME_WINDOW_BASE 0x40000000
+#define HOST_GAME_WINDOW_SIZE 0x20000000
+void host_reserve_game_window(void);
+
+// Maps [addr, addr + size) for the "game", zero filled. Returns NULL if the range is taken.
+void* host_map(uint32_t addr, uint32_t size);
+void host_unmap(uint32_t addr, uint32_t size);
+
+// Module list returned by ps3mapi. Returns the prx id.
+int32_t host_module_add(const char* filename, uint32_t text_base, uint32_t text_size, uint32_t data_base, uint32_t data_size);
+void host_modules_clear(void);
+
+// ps3mapi_get_fw_version(), 0x490 unless a test changes it
+extern uint32_t g_host_fw_version;
+
+// lv2 paths ("/dev_hdd0/...") are created below this directory
+void host_fs_set_root(const char* dir);
+// Creates a fresh temporary root and returns it
+const char* host_fs_temp_root(void);
+// Host path of an lv2 path
+const char* host_fs_path(const char* lv2_path, char* out, size_t size);
+// Writes a whole file, creating the directories above it
+int host_fs_write(const char* lv2_path, const void* data, size_t size);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,45 @@
+#include "host_test.h"
+#include "host_lv2.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <time.h>
+
+int g_test_failures = 0;
+
+int host_thread_create(pthread_t* thread, void* (*entry)(void*), void* arg);
+
+uint64_t host_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void* run_test(void* result)
+{
+    *(int*)result = test_main();
+    return NULL;
+}
+
+// The console code keeps pointers in 32 bits. The executable is linked without PIE and malloc
+// only uses the main arena without falling back to mmap, so globals and the heap stay low.
+// The test runs on a stack allocated below 4 GB as well, and the game window is reserved
+// before anything else can be mapped into it.
+int main(void)
+{
+    mallopt(M_ARENA_MAX, 1);
+    mallopt(M_MMAP_MAX, 0);
+    host_reserve_game_window();
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    int result = 1;
+    pthread_t thread;
+    if (host_thread_create(&thread, run_test, &result) != 0)
+    {
+        printf("couldn't start the test thread\n");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+    return result;
+}
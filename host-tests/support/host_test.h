@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+extern int g_test_failures;
+
+// monotonic clock in nanoseconds
+uint64_t host_time_ns(void);
+
+// Each test defines this instead of main()
+int test_main(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+            g_test_failures++;                                                 \
+        }                                                                      \
+    } while (0)
+
+#define TEST_RESULT() (g_test_failures ? (printf("%d check(s) failed\n", g_test_failures), 1) : (printf("ok\n"), 0))
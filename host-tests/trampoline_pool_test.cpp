@@ -0,0 +1,142 @@
+// Hook/unhook cycles: every detour gives its trampoline back, the sites get their code back,
+// and the pool stops growing once it holds the largest working set.
+#include "host_test.h"
+#include "host_lv2.h"
+#include "Memory/Detour.hpp"
+
+#include <string.h>
+
+#define EXE_BASE 0x10000
+#define GAME_BASE HOST_GAME_WINDOW_BASE
+#define GAME_SIZE 0x10000
+#define GAME_TOC 0x10208000
+#define FUNCTIONS 48
+#define ROUNDS 2000
+
+static uint32_t s_seed = 0xa5a5f00d;
+
+static uint32_t next_random(void)
+{
+    s_seed ^= s_seed << 13, s_seed ^= s_seed >> 17, s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+// Relative branches make a trampoline grow, so the functions need 40 to 100 bytes each
+static void write_function(uint8_t* game, uint32_t index)
+{
+    uint32_t* code = (uint32_t*)(game + index * 0x100);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        code[i] = (index >> i) & 1 ? 0x48000101 + i * 0x10 : 0x38600000 + index * 4 + i;  // bl or li r3
+    }
+}
+
+static void pool_cycles()
+{
+    static uint8_t buffer[256];
+    TrampolinePool pool(buffer, sizeof(buffer));
+    uint8_t* blocks[64];
+    uint32_t sizes[64];
+    memset(blocks, 0, sizeof(blocks));
+
+    for (int round = 0; round < ROUNDS * 10; round++)
+    {
+        const uint32_t i = next_random() % 64;
+        if (blocks[i])
+        {
+            pool.Free(blocks[i], sizes[i]);
+            blocks[i] = nullptr;
+            continue;
+        }
+        sizes[i] = 4 + (next_random() % 32) * 4;
+        blocks[i] = pool.Allocate(sizes[i]);
+        CHECK(blocks[i] != nullptr);
+        for (uint32_t j = 0; blocks[i] && j < 64; j++)
+        {
+            // live blocks never overlap
+            if (j != i && blocks[j] && blocks[j] < blocks[i] + sizes[i] && blocks[i] < blocks[j] + sizes[j])
+            {
+                printf("round %d: blocks %u and %u overlap\n", round, i, j);
+                g_test_failures++;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        pool.Free(blocks[i], sizes[i]);
+    }
+
+    const TrampolinePool::Stats& stats = pool.GetStats();
+    printf("pool: %u chunk(s), %u free bytes, %u on free lists\n", stats.chunks, stats.freeBytes, stats.fragmentedBytes);
+    CHECK(stats.liveBytes == 0);
+    CHECK(stats.liveBlocks == 0);
+    // 64 blocks of at most 128 bytes fit one page, a second one is the most splitting may cost
+    CHECK(stats.chunks <= 3);
+}
+
+static void hook_cycles(uint8_t* game)
+{
+    static const opd_s callback = { GAME_BASE + 0x8000, GAME_TOC };
+    static Detour detours[FUNCTIONS];
+    uint8_t original[FUNCTIONS * 0x100];
+    for (uint32_t i = 0; i < FUNCTIONS; i++)
+    {
+        write_function(game, i);
+    }
+    memcpy(original, game, sizeof(original));
+
+    uint32_t maxChunks = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        const uint32_t i = next_random() % FUNCTIONS;
+        if (detours[i].IsHooked())
+        {
+            CHECK(detours[i].UnHook());
+            CHECK(memcmp(game + i * 0x100, original + i * 0x100, Detour::HookSize) == 0);
+        }
+        else
+        {
+            detours[i].Hook(GAME_BASE + i * 0x100, (uintptr_t)&callback);
+            CHECK(detours[i].IsHooked());
+            CHECK(*(const uint32_t*)(game + i * 0x100 + 4) == 0x60008000);
+            // the trampoline starts with the relocated first instruction
+            const uint32_t first = *(const uint32_t*)(original + i * 0x100);
+            const uint32_t* trampoline = (const uint32_t*)(uintptr_t)detours[i].GetOriginalOpd()[0];
+            CHECK(trampoline[0] == (first == 0x48000101 ? 0xF801FFD0 : first));
+        }
+        const uint32_t chunks = Detour::GetTrampolineStats().chunks;
+        maxChunks = chunks > maxChunks ? chunks : maxChunks;
+    }
+    for (uint32_t i = 0; i < FUNCTIONS; i++)
+    {
+        detours[i].UnHook();
+    }
+
+    const TrampolinePool::Stats stats = Detour::GetTrampolineStats();
+    printf("%d hook/unhook cycles: %u chunk(s), %u free bytes, %u on free lists\n", ROUNDS, stats.chunks, stats.freeBytes, stats.fragmentedBytes);
+    CHECK(memcmp(game, original, sizeof(original)) == 0);
+    CHECK(stats.liveBytes == 0);
+    CHECK(stats.liveBlocks == 0);
+    // 48 trampolines of at most 100 bytes: the static buffer and one page
+    CHECK(maxChunks <= 3);
+}
+
+int test_main(void)
+{
+    uint8_t* exe = (uint8_t*)host_map(EXE_BASE, 0x1000);
+    uint8_t* game = (uint8_t*)host_map(GAME_BASE, GAME_SIZE);
+    CHECK(exe != NULL && game != NULL);
+    if (!exe || !game)
+    {
+        return TEST_RESULT();
+    }
+    *(uint32_t*)(exe + 0x1C) = EXE_BASE + 0x100;
+    *(uint32_t*)(exe + 0x104) = GAME_TOC - 0x8000;
+
+    pool_cycles();
+    hook_cycles(game);
+
+    host_unmap(GAME_BASE, GAME_SIZE);
+    host_unmap(EXE_BASE, 0x1000);
+    return TEST_RESULT();
+}
@@ -5,25 +5,30 @@ extern "C"
 #include "../game_patch/lv2_stdio.h"
 }
 
-int load_game_info(const char* path, GamePatchInfo& info)
+int load_launch_record(GameLaunchRecord& record)
 {
     FileHandle h = 0;
-    FileStatus ret = fileOpen(&h, path, FILE_MODE_READ);
-    uint64_t fsz = 0;
+    FileStatus ret = fileOpen(&h, GAME_LAUNCH_RECORD_PATH, FILE_MODE_READ);
     int okay = 0;
-    if (ret == FILE_STATUS_OK && fileSize(h, &fsz) == FILE_STATUS_OK && fsz == sizeof(info))
+    if (ret == FILE_STATUS_OK)
     {
         uint64_t readcount = 0;
-        FileStatus read = fileRead(h, &info, sizeof(info), &readcount);
-        if (read == FILE_STATUS_OK && readcount == sizeof(info))
+        FileStatus read = fileRead(h, &record, sizeof(record), &readcount);
+        if (read == FILE_STATUS_OK && readcount == sizeof(record) && record.magic == GAME_LAUNCH_RECORD_MAGIC &&
+            record.version == GAME_LAUNCH_RECORD_VERSION && record.size == sizeof(record))
         {
-            printf("open %s %d %ld\n", path, ret, readcount);
-            printf("read %d\n", read);
-            printf("title %s\n", info.titleid);
-            printf("app_ver %s\n", info.app_ver);
+            record.info.titleid[sizeof(record.info.titleid) - 1] = 0;
+            record.info.app_ver[sizeof(record.info.app_ver) - 1] = 0;
+            record.patch_path[sizeof(record.patch_path) - 1] = 0;
+            printf("launch %d title %s app_ver %s\n", record.sequence, record.info.titleid, record.info.app_ver);
+            printf("patch file %s\n", record.patch_path);
             okay = 1;
         }
+        else
+        {
+            printf("bad launch record %s (read %d, %ld bytes)\n", GAME_LAUNCH_RECORD_PATH, read, readcount);
+        }
+        fileClose(h);
     }
-    fileClose(h);
     return okay;
 }
@@ -3,12 +3,56 @@
 #if !defined(GAME_PATCH_INFO_H)
 #define GAME_PATCH_INFO_H
 
+#include <stdint.h>
+
 typedef struct
 {
     char titleid[16];
     char app_ver[8];
 } GamePatchInfo;
 
+#define GAME_LAUNCH_RECORD_MAGIC 0x474C4152  // 'GLAR'
+#define GAME_LAUNCH_RECORD_VERSION 1
+#define GAME_LAUNCH_PATH_SIZE 128
+#define GAME_LAUNCH_MESSAGE_SIZE 64
+
+typedef enum
+{
+    GAME_LAUNCH_RESULT_PENDING,  // game_patch didn't run (yet)
+    GAME_LAUNCH_RESULT_APPLIED,  // message is shown by vsh
+    GAME_LAUNCH_RESULT_NONE,     // ran, nothing to report
+} GameLaunchResultState;
+
+#define GAME_LAUNCH_HAS_PATCH_FILE 1
+
+// Written back by game_patch, in place at GAME_LAUNCH_RESULT_OFFSET
+typedef struct __attribute__((packed))
+{
+    uint32_t state;
+    uint32_t sequence;  // of the record it answers
+    uint32_t patch_count;
+    uint32_t deferred_count;
+    char message[GAME_LAUNCH_MESSAGE_SIZE + 1];
+} GameLaunchResult;
+
+// Prepared by vsh for every launch, read once by the bootloader and game_patch
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t sequence;  // bumped every launch
+    uint32_t flags;
+    GamePatchInfo info;
+    char patch_path[GAME_LAUNCH_PATH_SIZE];  // GAME_PATCH_FILES_PATH/<titleid>.yml
+    uint64_t patch_file_size;  // stat of patch_path at launch
+    int64_t patch_file_mtime;
+    uint32_t state_checksum;  // settings/<titleid>.bin, 0 when there is none
+    GameLaunchResult result;
+} GameLaunchRecord;
+
+#define GAME_LAUNCH_RESULT_OFFSET __builtin_offsetof(GameLaunchRecord, result)
+
 #define HDD_PATH "/dev_hdd0"
 #define PLUGINS_PATH HDD_PATH "/game_plugins.yml"
 #define BOOTLOADER_PATH HDD_PATH "/game_plugin_bootloader.sprx"
@@ -19,9 +63,10 @@ typedef struct
 #define GAME_PATCH_SETTINGS GAME_PATCH_DATA_PATH "/settings" // per title id .bin
 #define GAME_PATCH_FILES_PATH HDD_PATH BASE_GAME_PATCH_PATH
 #define GAME_PATCH_WORK_PATH GAME_PATCH_DATA_PATH "/work"
-#define GAME_INFO_PATH GAME_PATCH_WORK_PATH "/game_patch_data.bin"
-#define GAME_PATCH_NOTIFY_MSG_FILE GAME_PATCH_WORK_PATH "/notify.bin"
+#define GAME_PATCH_CACHE_PATH GAME_PATCH_DATA_PATH "/cache" // per title id .plan
+#define GAME_PATCH_HOT_RELOAD_PATH GAME_PATCH_DATA_PATH "/hot_reload.txt" // poll interval in ms, enables hot reload
+#define GAME_LAUNCH_RECORD_PATH GAME_PATCH_WORK_PATH "/launch.bin"
+#define GAME_PATCH_SCAN_CACHE_PATH GAME_PATCH_WORK_PATH "/scan_cache.bin" // signature addresses per vsh build
 #define USB_PATH "/dev_usb%03ld"
-#define CHECK_BYTE '!'
 
 #endif // !defined(GAME_PATCH_INFO_H)
@@ -2,4 +2,5 @@
 
 #include "GamePatchInfo.h"
 
-int load_game_info(const char* path, GamePatchInfo& info);
+// Reads GAME_LAUNCH_RECORD_PATH in one go, 0 when it's missing or from another version
+int load_launch_record(GameLaunchRecord& record);
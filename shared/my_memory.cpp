@@ -2,6 +2,9 @@
 #include "../game_patch/lv2_stdio.h"
 #else
 #include <vshlib.hpp>
+#if !defined(printf)
+#define printf vsh::printf
+#endif
 #endif
 #include "../game_patch_vsh_data/Memory/Memory.h"
 #include <sys/process.h>
@@ -9,10 +12,6 @@
 
 #include "memory.h"
 
-#if !defined(printf)
-#define printf vsh::printf
-#endif
-
 #define MAKE_JUMP_VALUE(addr, to) (((0x12 << 26) | ((((to - (uint64_t)(addr)) >> 2) & 0xFFFFFF) << 2)))
 #define MAKE_CALL_VALUE(addr, to) (((0x12 << 26) | ((((to - (uint64_t)(addr)) >> 2) & 0xFFFFFF) << 2)) | 1)
 
@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdint.h>
 
 static uint32_t stringid(const char* str, uint32_t base)
@@ -12,3 +13,17 @@ static uint32_t stringid(const char* str, uint32_t base)
     }
     return base;
 }
+
+static uint32_t memid(const void* data, size_t size, uint32_t base)
+{
+    if (!base)
+    {
+        base = 0x811c9dc5;
+    }
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        base = 0x01000193 * (base ^ p[i]);
+    }
+    return base;
+}